@@ -0,0 +1,1645 @@
+/*
+
+Minceraft benchmarks
+
+By CobaltXII
+
+*/
+
+#include <main.hpp>
+
+// On Linux, hardware cache misses are counted using perf_event_open. On other
+// platforms (or when the kernel does not allow it), only the elapsed time is
+// reported.
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+
+#include <sys/ioctl.h>
+
+#include <sys/syscall.h>
+
+#include <unistd.h>
+
+#endif
+
+// A bench_counter measures the elapsed time and the number of cache misses 
+// between a call to bench_counter::start and a call to bench_counter::stop.
+
+struct bench_counter
+{
+	int fd;
+
+	long long misses;
+
+	double milliseconds;
+
+	std::chrono::high_resolution_clock::time_point start_time;
+
+	bench_counter()
+	{
+		fd = -1;
+
+		misses = -1;
+
+		milliseconds = 0.0;
+
+		#ifdef __linux__
+
+		perf_event_attr attributes;
+
+		memset(&attributes, 0, sizeof(attributes));
+
+		attributes.size = sizeof(attributes);
+
+		attributes.type = PERF_TYPE_HARDWARE;
+
+		attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+
+		attributes.disabled = 1;
+
+		attributes.exclude_kernel = 1;
+
+		attributes.exclude_hv = 1;
+
+		fd = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+
+		#endif
+	}
+
+	~bench_counter()
+	{
+		#ifdef __linux__
+
+		if (fd != -1)
+		{
+			close(fd);
+		}
+
+		#endif
+	}
+
+	void start()
+	{
+		#ifdef __linux__
+
+		if (fd != -1)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+
+		#endif
+
+		start_time = std::chrono::high_resolution_clock::now();
+	}
+
+	void stop()
+	{
+		milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+		#ifdef __linux__
+
+		if (fd != -1)
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+			if (read(fd, &misses, sizeof(misses)) != sizeof(misses))
+			{
+				misses = -1;
+			}
+		}
+
+		#endif
+	}
+
+	// Print the measurements with a label.
+
+	void print(std::string label)
+	{
+		std::cout << "    " << label << ": " << milliseconds << " ms";
+
+		if (misses >= 0)
+		{
+			std::cout << ", " << misses << " cache misses";
+		}
+		else
+		{
+			std::cout << ", cache misses unavailable";
+		}
+
+		std::cout << std::endl;
+	}
+};
+
+// Load the block face_info array without creating a texture array. The 
+// layers are assigned in the same order as load_block_texture_array would
+// assign them.
+
+void bench_load_block_face_info_array()
+{
+	for (unsigned int i = 0; i < all_tex.size(); i++)
+	{
+		block_name_to_layer.emplace(all_tex[i], float(i));
+	}
+
+	load_block_face_info_array();
+}
+
+// Remove a level directory that was saved from a world of the specified
+// size, and return the total size of it's region files. Region files that do
+// not exist are skipped.
+
+unsigned long long bench_remove_level(std::string path_to_level, unsigned int x_res, unsigned int z_res)
+{
+	unsigned long long region_bytes = 0;
+
+	for (unsigned int z = 0; z < z_res; z += region_res * 16)
+	for (unsigned int x = 0; x < x_res; x += region_res * 16)
+	{
+		std::string path = region_path(path_to_level, x, z);
+
+		std::ifstream region(path, std::ios::binary | std::ios::ate);
+
+		if (region.good())
+		{
+			region_bytes += region.tellg();
+		}
+
+		region.close();
+
+		std::remove(path.c_str());
+	}
+
+	std::remove((path_to_level + "/level.dat").c_str());
+
+	std::remove(path_to_level.c_str());
+
+	return region_bytes;
+}
+
+// Mesh every chunk of a world and pack it's vertices into quads, like
+// allocate_chunk does, and return the total amount of floats that were
+// generated. The total amount of quads is stored in total_quads.
+
+unsigned long long bench_mesh_world(world* the_world, unsigned long long& total_quads)
+{
+	float* target = (float*)malloc(16 * 16 * 16 * 12 * 4 * 7 * sizeof(float));
+
+	float* water_target = (float*)malloc(16 * 16 * 16 * 6 * 4 * 7 * sizeof(float));
+
+	packed_vertex* packed_target = (packed_vertex*)malloc(16 * 16 * 16 * 12 * 4 * sizeof(packed_vertex));
+
+	unsigned long long total_floats = 0;
+
+	total_quads = 0;
+
+	for (unsigned int z = 0; z < the_world->z_res; z += 16)
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	for (unsigned int x = 0; x < the_world->x_res; x += 16)
+	{
+		unsigned int target_size_in_floats;
+
+		unsigned int water_target_size_in_floats;
+
+		world_subset_to_mesh(the_world, x, y, z, 16, 16, 16, target, target_size_in_floats);
+
+		world_subset_to_water_mesh(the_world, x, y, z, 16, 16, 16, water_target, water_target_size_in_floats);
+
+		total_quads += pack_quads(target, target_size_in_floats, x, y, z, packed_target);
+
+		total_quads += pack_quads(water_target, water_target_size_in_floats, x, y, z, packed_target);
+
+		total_floats += target_size_in_floats + water_target_size_in_floats;
+	}
+
+	free(target);
+
+	free(water_target);
+
+	free(packed_target);
+
+	return total_floats;
+}
+
+// Mesh every chunk of a world on parallel_threads threads, like
+// allocate_accessor does, and return the total amount of quads.
+
+unsigned long long bench_mesh_world_in_parallel(world* the_world)
+{
+	size_t chunk_count = size_t(the_world->chunk_x_res) * the_world->chunk_y_res * the_world->chunk_z_res;
+
+	std::vector<unsigned long long> quads(chunk_count);
+
+	run_in_parallel(chunk_count, [&](size_t i)
+	{
+		unsigned int x = (i % the_world->chunk_x_res) * 16;
+		unsigned int y = ((i / the_world->chunk_x_res) % the_world->chunk_y_res) * 16;
+		unsigned int z = (i / the_world->chunk_x_res / the_world->chunk_y_res) * 16;
+
+		chunk_mesh* the_mesh = allocate_chunk_mesh(the_world, x, y, z, 16, 16, 16);
+
+		quads[i] = the_mesh->target_quad_count + the_mesh->water_target_quad_count;
+
+		deallocate_chunk_mesh(the_mesh);
+	});
+
+	unsigned long long total_quads = 0;
+
+	for (unsigned long long chunk_quads: quads)
+	{
+		total_quads += chunk_quads;
+	}
+
+	return total_quads;
+}
+
+// Mesh every section of a world, including the ones that world_subset_to_mesh
+// would skip, reading the voxels through a mesh_halo if use_halo is true and
+// through a world_voxels (which checks the bounds of the world on every read)
+// if not. Return the total amount of floats that were generated.
+
+unsigned long long bench_mesh_sections(world* the_world, bool use_halo)
+{
+	float* target = (float*)malloc(16 * 16 * 16 * 12 * 4 * 7 * sizeof(float));
+
+	float* water_target = (float*)malloc(16 * 16 * 16 * 6 * 4 * 7 * sizeof(float));
+
+	mesh_halo* halo = new mesh_halo();
+
+	world_voxels voxels = {the_world};
+
+	unsigned long long total_floats = 0;
+
+	for (unsigned int z = 0; z < the_world->z_res; z += 16)
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	for (unsigned int x = 0; x < the_world->x_res; x += 16)
+	{
+		unsigned int target_size_in_floats;
+
+		unsigned int water_target_size_in_floats;
+
+		if (use_halo)
+		{
+			halo->load(the_world, x, y, z);
+
+			voxels_to_mesh(*halo, x, y, z, 16, 16, 16, target, target_size_in_floats);
+
+			halo->load(the_world, x, y, z);
+
+			voxels_to_water_mesh(*halo, x, y, z, 16, 16, 16, water_target, water_target_size_in_floats);
+		}
+		else
+		{
+			voxels_to_mesh(voxels, x, y, z, 16, 16, 16, target, target_size_in_floats);
+
+			voxels_to_water_mesh(voxels, x, y, z, 16, 16, 16, water_target, water_target_size_in_floats);
+		}
+
+		total_floats += target_size_in_floats + water_target_size_in_floats;
+	}
+
+	delete halo;
+
+	free(target);
+
+	free(water_target);
+
+	return total_floats;
+}
+
+// The flat voxel layout that worlds used before they were stored in sections,
+// kept as a baseline for the cache misses of the passes below. It is one
+// array of 16-bit voxels, indexed x + x_res * (y + y_res * z), so the voxels
+// of a 16^3 chunk are spread over thousands of cache lines.
+
+struct bench_flat_world
+{
+	unsigned int x_res;
+	unsigned int y_res;
+	unsigned int z_res;
+
+	std::vector<voxel> voxels;
+
+	inline block_id get_id(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return voxel_get_id(voxels[x + x_res * (y + y_res * z)]);
+	}
+};
+
+// Copy the block_ids of a world into a bench_flat_world.
+
+void bench_flatten_world(world* the_world, bench_flat_world& out)
+{
+	out.x_res = the_world->x_res;
+	out.y_res = the_world->y_res;
+	out.z_res = the_world->z_res;
+
+	out.voxels.assign(size_t(out.x_res) * out.y_res * out.z_res, 0);
+
+	for (unsigned int z = 0; z < out.z_res; z++)
+	for (unsigned int y = 0; y < out.y_res; y++)
+	for (unsigned int x = 0; x < out.x_res; x++)
+	{
+		voxel_set_id(out.voxels[x + out.x_res * (y + out.y_res * z)], the_world->get_id(x, y, z));
+	}
+}
+
+// Count the faces of every chunk that touch id_air, chunk by chunk like the
+// mesher, reading each voxel and it's six neighbors through voxels (a
+// bench_flat_world or a mesh_halo that is loaded for each chunk).
+
+template <typename T, typename L>
+unsigned long long bench_count_air_faces(world* the_world, T& voxels, L load)
+{
+	unsigned long long faces = 0;
+
+	for (unsigned int z = 0; z < the_world->z_res; z += 16)
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	for (unsigned int x = 0; x < the_world->x_res; x += 16)
+	{
+		load(x, y, z);
+
+		for (unsigned int cz = std::max(z, 1u); cz < std::min(z + 16, the_world->z_res - 1); cz++)
+		for (unsigned int cy = std::max(y, 1u); cy < std::min(y + 16, the_world->y_res - 1); cy++)
+		for (unsigned int cx = std::max(x, 1u); cx < std::min(x + 16, the_world->x_res - 1); cx++)
+		{
+			if (voxels.get_id(cx, cy, cz) == id_air)
+			{
+				continue;
+			}
+
+			faces += voxels.get_id(cx - 1, cy, cz) == id_air;
+			faces += voxels.get_id(cx + 1, cy, cz) == id_air;
+
+			faces += voxels.get_id(cx, cy - 1, cz) == id_air;
+			faces += voxels.get_id(cx, cy + 1, cz) == id_air;
+
+			faces += voxels.get_id(cx, cy, cz - 1) == id_air;
+			faces += voxels.get_id(cx, cy, cz + 1) == id_air;
+		}
+	}
+
+	return faces;
+}
+
+// Find the highest voxel of every column that is not id_air by walking it
+// from the top, like propagate_skylight walks each column, reading the
+// voxels through voxels (a bench_flat_world or a world).
+
+template <typename T>
+unsigned long long bench_walk_columns(world* the_world, T& voxels)
+{
+	unsigned long long sum = 0;
+
+	for (unsigned int x = 0; x < the_world->x_res; x++)
+	for (unsigned int z = 0; z < the_world->z_res; z++)
+	{
+		unsigned int y = 0;
+
+		while (y < the_world->y_res && voxels.get_id(x, y, z) == id_air)
+		{
+			y++;
+		}
+
+		sum += y;
+	}
+
+	return sum;
+}
+
+// Check that a buffer comes back unchanged after compress_bytes and
+// decompress_bytes.
+
+bool bench_round_trips(const std::string& buffer)
+{
+	std::string decompressed;
+
+	return decompress_bytes(compress_bytes(buffer), decompressed) && decompressed == buffer;
+}
+
+// The entry point. The world dimensions may be passed on the command line,
+// the default is 512x256x512.
+
+int main(int argc, char** argv)
+{
+	unsigned int x_res = 512;
+	unsigned int y_res = 256;
+	unsigned int z_res = 512;
+
+	if (argc == 4)
+	{
+		x_res = std::stoi(std::string(argv[1]));
+		y_res = std::stoi(std::string(argv[2]));
+		z_res = std::stoi(std::string(argv[3]));
+	}
+
+	std::cout << "World: " << x_res << "x" << y_res << "x" << z_res << std::endl;
+
+	bench_load_block_face_info_array();
+
+	// Generate the world with a fixed seed, so that every run measures the
+	// same terrain.
+
+	world* the_world = allocate_world(x_res, y_res, z_res);
+
+	bench_counter generate_counter;
+
+	generate_counter.start();
+
+	generate_world(the_world, 1024);
+
+	generate_counter.stop();
+
+	generate_counter.print("generate_world");
+
+	// Compare the memory used by the sections to the memory that a flat array
+	// of 16-bit voxels would use.
+
+	unsigned long long flat_bytes = (unsigned long long)x_res * y_res * z_res * sizeof(voxel);
+
+	unsigned long long section_bytes = world_memory_usage(the_world);
+
+	std::cout << "    Voxel memory: " << section_bytes / 1024 << " KiB (flat: " << flat_bytes / 1024 << " KiB, " << float(flat_bytes) / float(section_bytes) << "x smaller)" << std::endl;
+
+	// Count the sections that are uniform, and so cost no voxel memory.
+
+	unsigned int section_count = the_world->chunk_x_res * the_world->chunk_y_res * the_world->chunk_z_res;
+
+	unsigned int uniform_count = 0;
+
+	for (size_t i = 0; i < size_t(the_world->window_x_res) * the_world->chunk_y_res * the_world->window_z_res; i++)
+	{
+		if (the_world->sections[i] && the_world->sections[i]->bits == 0)
+		{
+			uniform_count++;
+		}
+	}
+
+	std::cout << "    Uniform sections: " << uniform_count << " of " << section_count << std::endl;
+
+	// Measure the bytes that a full pass over each plane reads, compared to
+	// a pass over packed 16-bit voxels. propagate_skylight reads the
+	// heightmap and the natural lighting planes, and the mesher's visibility
+	// checks only read the block_id plane.
+
+	unsigned long long id_plane_bytes = 0;
+
+	unsigned long long natural_plane_bytes = 0;
+
+	unsigned long long artificial_plane_bytes = 0;
+
+	for (size_t i = 0; i < size_t(the_world->window_x_res) * the_world->chunk_y_res * the_world->window_z_res; i++)
+	{
+		section* the_section = the_world->sections[i];
+
+		if (!the_section)
+		{
+			continue;
+		}
+
+		if (the_section->bits != 0)
+		{
+			id_plane_bytes += the_section->palette_size * sizeof(unsigned short) + 4096 * the_section->bits / 8;
+		}
+
+		natural_plane_bytes += the_section->natural ? 2048 : 0;
+
+		artificial_plane_bytes += the_section->artificial ? 2048 : 0;
+	}
+
+	unsigned long long packed_bytes = (unsigned long long)section_count * 4096 * sizeof(voxel);
+
+	std::cout << "    Planes: block_id " << id_plane_bytes / 1024 << " KiB, natural " << natural_plane_bytes / 1024 << " KiB, artificial " << artificial_plane_bytes / 1024 << " KiB (packed voxels: " << packed_bytes / 1024 << " KiB)" << std::endl;
+
+	// Compare the cache misses of a pass over the voxels of every chunk, like
+	// the mesher's, and of a walk down every column, like propagate_skylight's,
+	// through the old flat layout and through the sections.
+
+	{
+		bench_flat_world flat;
+
+		bench_flatten_world(the_world, flat);
+
+		mesh_halo* halo = new mesh_halo();
+
+		bench_counter flat_faces_counter;
+
+		flat_faces_counter.start();
+
+		unsigned long long flat_faces = bench_count_air_faces(the_world, flat, [](unsigned int x, unsigned int y, unsigned int z) {});
+
+		flat_faces_counter.stop();
+
+		flat_faces_counter.print("faces that touch id_air, chunk by chunk, flat voxels");
+
+		bench_counter section_faces_counter;
+
+		section_faces_counter.start();
+
+		unsigned long long section_faces = bench_count_air_faces(the_world, *halo, [&](unsigned int x, unsigned int y, unsigned int z)
+		{
+			halo->load(the_world, x, y, z);
+		});
+
+		section_faces_counter.stop();
+
+		section_faces_counter.print("faces that touch id_air, chunk by chunk, sections through a mesh_halo");
+
+		if (flat_faces != section_faces)
+		{
+			std::cout << "    The face counts do not match." << std::endl;
+		}
+
+		bench_counter flat_walk_counter;
+
+		flat_walk_counter.start();
+
+		unsigned long long flat_sum = bench_walk_columns(the_world, flat);
+
+		flat_walk_counter.stop();
+
+		flat_walk_counter.print("walking every column from the top, flat voxels");
+
+		bench_counter section_walk_counter;
+
+		section_walk_counter.start();
+
+		unsigned long long section_sum = bench_walk_columns(the_world, *the_world);
+
+		section_walk_counter.stop();
+
+		section_walk_counter.print("walking every column from the top, sections");
+
+		if (flat_sum != section_sum)
+		{
+			std::cout << "    The column walks do not match." << std::endl;
+		}
+
+		delete halo;
+	}
+
+	// Measure propagate_skylight on its own.
+
+	bench_counter skylight_counter;
+
+	skylight_counter.start();
+
+	propagate_skylight(the_world);
+
+	skylight_counter.stop();
+
+	skylight_counter.print("propagate_skylight");
+
+	unsigned long long natural_after_bytes = 0;
+
+	for (size_t i = 0; i < size_t(the_world->window_x_res) * the_world->chunk_y_res * the_world->window_z_res; i++)
+	{
+		if (the_world->sections[i] && the_world->sections[i]->natural)
+		{
+			natural_after_bytes += 2048;
+		}
+	}
+
+	unsigned long long heights_bytes = (unsigned long long)the_world->window_x_res * the_world->window_z_res * sizeof(column_heights);
+
+	std::cout << "    propagate_skylight pass reads " << (heights_bytes + natural_after_bytes) / 1024 << " KiB of planes (packed voxels: " << packed_bytes / 1024 << " KiB)" << std::endl;
+
+	// Measure finding the highest voxel of every column that is not id_air,
+	// by scanning the column from the top and by reading the heightmap.
+
+	bench_counter scan_counter;
+
+	scan_counter.start();
+
+	unsigned long long scan_sum = 0;
+
+	for (unsigned int x = 0; x < the_world->x_res; x++)
+	for (unsigned int z = 0; z < the_world->z_res; z++)
+	{
+		unsigned int y = 0;
+
+		while (y < the_world->y_res && the_world->get_id(x, y, z) == id_air)
+		{
+			y++;
+		}
+
+		scan_sum += y;
+	}
+
+	scan_counter.stop();
+
+	scan_counter.print("highest voxel of every column, scanning");
+
+	bench_counter heights_counter;
+
+	heights_counter.start();
+
+	unsigned long long heights_sum = 0;
+
+	for (unsigned int x = 0; x < the_world->x_res; x++)
+	for (unsigned int z = 0; z < the_world->z_res; z++)
+	{
+		heights_sum += the_world->top_non_air(x, z);
+	}
+
+	heights_counter.stop();
+
+	heights_counter.print("highest voxel of every column, heightmap");
+
+	if (scan_sum != heights_sum)
+	{
+		std::cout << "    The heightmap does not match the world." << std::endl;
+	}
+
+	// Measure meshing every chunk.
+
+	bench_counter mesh_counter;
+
+	mesh_counter.start();
+
+	unsigned long long total_quads;
+
+	unsigned long long total_floats = bench_mesh_world(the_world, total_quads);
+
+	mesh_counter.stop();
+
+	mesh_counter.print("world_subset_to_mesh + world_subset_to_water_mesh + pack_quads");
+
+	std::cout << "    Generated " << total_floats / 7 << " vertices (" << double(total_floats / 7) / mesh_counter.milliseconds / 1000.0 << " million vertices per second)" << std::endl;
+
+	std::cout << "    Mesher visibility pass reads " << id_plane_bytes / 1024 << " KiB of planes (packed voxels: " << packed_bytes / 1024 << " KiB)" << std::endl;
+
+	// Measure meshing every chunk without merging the faces of full cubes,
+	// and compare the size of the meshes per chunk, which is the amount of
+	// data that is uploaded to the GPU.
+
+	greedy_meshing = false;
+
+	bench_counter unmerged_mesh_counter;
+
+	unmerged_mesh_counter.start();
+
+	unsigned long long unmerged_quads;
+
+	bench_mesh_world(the_world, unmerged_quads);
+
+	unmerged_mesh_counter.stop();
+
+	greedy_meshing = true;
+
+	unmerged_mesh_counter.print("world_subset_to_mesh + world_subset_to_water_mesh + pack_quads, greedy_meshing = false");
+
+	unsigned long long chunk_count = (unsigned long long)the_world->chunk_x_res * the_world->chunk_y_res * the_world->chunk_z_res;
+
+	std::cout << "    Per chunk, greedy_meshing = true: " << total_quads * 4 / chunk_count << " vertices (" << total_quads * 6 / chunk_count << " unindexed), " << total_quads * 2 / chunk_count << " triangles, " << total_quads * 4 * sizeof(packed_vertex) / chunk_count << " bytes uploaded (" << total_quads * 6 * 7 * sizeof(float) / chunk_count << " bytes as unindexed floats)" << std::endl;
+
+	std::cout << "    Per chunk, greedy_meshing = false: " << unmerged_quads * 4 / chunk_count << " vertices (" << unmerged_quads * 6 / chunk_count << " unindexed), " << unmerged_quads * 2 / chunk_count << " triangles, " << unmerged_quads * 4 * sizeof(packed_vertex) / chunk_count << " bytes uploaded (" << unmerged_quads * 6 * 7 * sizeof(float) / chunk_count << " bytes as unindexed floats)" << std::endl;
+
+	// Measure meshing every chunk on every hardware thread and on one, like
+	// allocate_accessor does at startup.
+
+	bench_counter parallel_mesh_counter;
+
+	parallel_mesh_counter.start();
+
+	unsigned long long parallel_quads = bench_mesh_world_in_parallel(the_world);
+
+	parallel_mesh_counter.stop();
+
+	parallel_mesh_counter.print("allocate_chunk_mesh on every chunk, parallel_threads = " + std::to_string(parallel_threads));
+
+	unsigned int all_mesh_threads = parallel_threads;
+
+	parallel_threads = 1;
+
+	bench_counter serial_mesh_counter;
+
+	serial_mesh_counter.start();
+
+	unsigned long long serial_quads = bench_mesh_world_in_parallel(the_world);
+
+	serial_mesh_counter.stop();
+
+	parallel_threads = all_mesh_threads;
+
+	serial_mesh_counter.print("allocate_chunk_mesh on every chunk, parallel_threads = 1");
+
+	if (parallel_quads != total_quads || serial_quads != total_quads)
+	{
+		std::cout << "    The meshes do not match." << std::endl;
+	}
+
+	// Measure meshing every section with and without the halo, which removes
+	// the bounds checks from every read of a voxel and it's neighbors.
+
+	bench_counter checked_mesh_counter;
+
+	checked_mesh_counter.start();
+
+	unsigned long long checked_floats = bench_mesh_sections(the_world, false);
+
+	checked_mesh_counter.stop();
+
+	checked_mesh_counter.print("meshing every section, world_voxels");
+
+	bench_counter halo_mesh_counter;
+
+	halo_mesh_counter.start();
+
+	unsigned long long halo_floats = bench_mesh_sections(the_world, true);
+
+	halo_mesh_counter.stop();
+
+	halo_mesh_counter.print("meshing every section, mesh_halo");
+
+	if (checked_floats != halo_floats)
+	{
+		std::cout << "    The meshes do not match." << std::endl;
+	}
+
+	// Measure taking a snapshot, and the cost of the copies that the world
+	// makes when one voxel of every section is changed while the snapshot is
+	// alive.
+
+	std::vector<unsigned int> every_column;
+
+	for (unsigned int i = 0; i < the_world->chunk_x_res * the_world->chunk_z_res; i++)
+	{
+		every_column.push_back(i);
+	}
+
+	bench_counter snapshot_counter;
+
+	snapshot_counter.start();
+
+	world* snapshot = snapshot_world(the_world, every_column);
+
+	snapshot_counter.stop();
+
+	snapshot_counter.print("snapshot_world");
+
+	bench_counter copy_counter;
+
+	copy_counter.start();
+
+	for (unsigned int z = 0; z < the_world->z_res; z += 16)
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	for (unsigned int x = 0; x < the_world->x_res; x += 16)
+	{
+		the_world->set_natural(x, y, z, the_world->get_natural(x, y, z));
+	}
+
+	copy_counter.stop();
+
+	copy_counter.print("copy every section of a snapshotted world");
+
+	std::cout << "    Voxel memory with snapshot: " << world_memory_usage(the_world) / 1024 << " KiB + " << world_memory_usage(snapshot) / 1024 << " KiB" << std::endl;
+
+	deallocate_world(snapshot);
+
+	// Measure the box functions against the per-voxel loops they replace, on
+	// a box that covers the lower half of the world. The generated terrain
+	// is copied first, so every run starts from the same voxels.
+
+	unsigned int box_y = y_res / 2;
+
+	world* box_world = allocate_world(x_res, y_res, z_res);
+
+	bench_counter voxel_fill_counter;
+
+	voxel_fill_counter.start();
+
+	for (unsigned int z = 0; z < z_res; z++)
+	for (unsigned int y = box_y; y < y_res; y++)
+	for (unsigned int x = 0; x < x_res; x++)
+	{
+		box_world->set_id(x, y, z, id_stone);
+	}
+
+	voxel_fill_counter.stop();
+
+	voxel_fill_counter.print("set_id per voxel");
+
+	bench_counter fill_counter;
+
+	fill_counter.start();
+
+	fill_box(box_world, 0, box_y, 0, x_res, y_res - box_y, z_res, id_dirt);
+
+	fill_counter.stop();
+
+	fill_counter.print("fill_box");
+
+	copy_box(the_world, 0, 0, 0, box_world, 0, 0, 0, x_res, y_res, z_res);
+
+	bench_counter voxel_replace_counter;
+
+	voxel_replace_counter.start();
+
+	for (unsigned int z = 0; z < z_res; z++)
+	for (unsigned int y = box_y; y < y_res; y++)
+	for (unsigned int x = 0; x < x_res; x++)
+	{
+		if (box_world->get_id(x, y, z) == id_stone)
+		{
+			box_world->set_id(x, y, z, id_gravel);
+		}
+	}
+
+	voxel_replace_counter.stop();
+
+	voxel_replace_counter.print("get_id + set_id per voxel, replacing stone");
+
+	copy_box(the_world, 0, 0, 0, box_world, 0, 0, 0, x_res, y_res, z_res);
+
+	bench_counter replace_counter;
+
+	replace_counter.start();
+
+	replace_in_box(box_world, 0, box_y, 0, x_res, y_res - box_y, z_res, id_stone, id_gravel);
+
+	replace_counter.stop();
+
+	replace_counter.print("replace_in_box, replacing stone");
+
+	deallocate_world(box_world);
+
+	// Measure saving the world to a file, saving it again over the same file
+	// (which only writes back the pages that changed) and loading it.
+
+	std::string world_path = "minceraft_bench_world.bin";
+
+	bench_counter save_counter;
+
+	save_counter.start();
+
+	save_world_to_file(the_world, 0.0f, 0.0f, 0.0f, world_path);
+
+	save_counter.stop();
+
+	save_counter.print("save_world_to_file");
+
+	the_world->set_id(0, 0, 0, id_stone);
+
+	bench_counter resave_counter;
+
+	resave_counter.start();
+
+	save_world_to_file(the_world, 0.0f, 0.0f, 0.0f, world_path);
+
+	resave_counter.stop();
+
+	resave_counter.print("save_world_to_file, one voxel changed");
+
+	world* loaded_world;
+
+	float loaded_x;
+	float loaded_y;
+	float loaded_z;
+
+	bench_counter load_counter;
+
+	load_counter.start();
+
+	load_world_from_file(loaded_world, loaded_x, loaded_y, loaded_z, world_path);
+
+	load_counter.stop();
+
+	load_counter.print("load_world_from_file");
+
+	std::cout << "    Voxel memory after loading: " << world_memory_usage(loaded_world) / 1024 << " KiB" << std::endl;
+
+	deallocate_world(loaded_world);
+
+	// Measure saving the world to a level directory of compressed region
+	// files and loading it, and compare the size of the region files to the
+	// size of the flat file.
+
+	std::string level_path = "minceraft_bench_level";
+
+	bench_counter level_save_counter;
+
+	level_save_counter.start();
+
+	save_world_to_level(the_world, 1024, 0.0f, 0.0f, 0.0f, level_path);
+
+	level_save_counter.stop();
+
+	level_save_counter.print("save_world_to_level, parallel_threads = " + std::to_string(parallel_threads));
+
+	bench_counter level_load_counter;
+
+	level_load_counter.start();
+
+	load_world_from_level(loaded_world, level_path, 1024, the_world->generator, x_res, y_res, z_res);
+
+	level_load_counter.stop();
+
+	level_load_counter.print("load_world_from_level, parallel_threads = " + std::to_string(parallel_threads));
+
+	deallocate_world(loaded_world);
+
+	// Measure loading the level progressively from the center of the world,
+	// until the columns within 4 columns of the player are loaded (which is
+	// when the first frame can be shown) and until every column is loaded.
+	// There is no OpenGL context for an accessor, so no chunks are created.
+
+	bench_counter near_load_counter;
+
+	near_load_counter.start();
+
+	level_load* the_load = start_level_load(loaded_world, level_path, 1024, the_world->generator, x_res, y_res, z_res, float(x_res) / 2.0f, float(z_res) / 2.0f);
+
+	size_t near_columns = level_load_columns_within(the_load, float(x_res) / 2.0f, float(z_res) / 2.0f, 4);
+
+	wait_for_level_load(the_load, nullptr, near_columns);
+
+	near_load_counter.stop();
+
+	near_load_counter.print("start_level_load, until " + std::to_string(near_columns) + " columns around the player are loaded");
+
+	wait_for_level_load(the_load, nullptr, the_load->order.size());
+
+	std::cout << "    Every column was loaded " << the_load->total_time_in_ms << " ms after start_level_load" << std::endl;
+
+	deallocate_level_load(the_load);
+
+	deallocate_world(loaded_world);
+
+	// Measure saving and loading the level on one thread, and check that the
+	// region files do not depend on the amount of threads.
+
+	unsigned int all_threads = parallel_threads;
+
+	parallel_threads = 1;
+
+	std::string serial_level_path = "minceraft_bench_level_serial";
+
+	bench_counter serial_save_counter;
+
+	serial_save_counter.start();
+
+	save_world_to_level(the_world, 1024, 0.0f, 0.0f, 0.0f, serial_level_path);
+
+	serial_save_counter.stop();
+
+	serial_save_counter.print("save_world_to_level, parallel_threads = 1");
+
+	bench_counter serial_load_counter;
+
+	serial_load_counter.start();
+
+	load_world_from_level(loaded_world, serial_level_path, 1024, the_world->generator, x_res, y_res, z_res);
+
+	serial_load_counter.stop();
+
+	serial_load_counter.print("load_world_from_level, parallel_threads = 1");
+
+	deallocate_world(loaded_world);
+
+	parallel_threads = all_threads;
+
+	for (unsigned int z = 0; z < z_res; z += region_res * 16)
+	for (unsigned int x = 0; x < x_res; x += region_res * 16)
+	{
+		std::ifstream parallel_region(region_path(level_path, x, z), std::ios::binary);
+		std::ifstream serial_region(region_path(serial_level_path, x, z), std::ios::binary);
+
+		std::string parallel_bytes((std::istreambuf_iterator<char>(parallel_region)), std::istreambuf_iterator<char>());
+		std::string serial_bytes((std::istreambuf_iterator<char>(serial_region)), std::istreambuf_iterator<char>());
+
+		if (parallel_bytes != serial_bytes)
+		{
+			std::cout << "    The region files depend on the amount of threads." << std::endl;
+		}
+	}
+
+	// Check that compress_bytes and decompress_bytes round trip random
+	// buffers and buffers that hit the edge cases of the codec: runs just
+	// shorter and longer than min_run, lengths that need a variable length
+	// integer, and matches that overlap the bytes they copy.
+
+	std::vector<std::string> buffers;
+
+	buffers.push_back(std::string());
+
+	buffers.push_back(std::string(1, 'a'));
+
+	buffers.push_back(std::string(100000, '\0'));
+
+	unsigned int bench_seed = 1024;
+
+	auto bench_random = [&]()
+	{
+		bench_seed = bench_seed * 1664525u + 1013904223u;
+
+		return bench_seed >> 24;
+	};
+
+	std::string random_bytes;
+
+	for (unsigned int i = 0; i < 100000; i++)
+	{
+		random_bytes += char(bench_random());
+	}
+
+	buffers.push_back(random_bytes);
+
+	std::string runs;
+
+	for (unsigned int length = 1; length < 300; length++)
+	{
+		runs.append(length, char(length & 1 ? 'a' : 'b'));
+	}
+
+	buffers.push_back(runs);
+
+	for (unsigned int period = 1; period < 80; period++)
+	{
+		std::string pattern;
+
+		for (unsigned int i = 0; i < 1000 + period; i++)
+		{
+			pattern += char(i % period);
+		}
+
+		buffers.push_back(pattern);
+	}
+
+	std::string words;
+
+	for (unsigned int i = 0; i < 20000; i++)
+	{
+		words += "word" + std::to_string(bench_random() % 16) + " ";
+	}
+
+	buffers.push_back(words);
+
+	std::string column_data = write_column_data(the_world, 0, 0, true);
+
+	std::string raw_column;
+
+	decompress_bytes(column_data, raw_column);
+
+	buffers.push_back(raw_column);
+
+	for (std::string& buffer: buffers)
+	{
+		if (!bench_round_trips(buffer))
+		{
+			std::cout << "    A buffer of " << buffer.size() << " bytes does not round trip through compress_bytes." << std::endl;
+		}
+	}
+
+	// Check that decompress_bytes rejects every truncation of a column's
+	// data, a changed decompressed size, and every flipped bit that changes
+	// the decompressed column (which the checksum catches if the operations
+	// do not). Flips that only change how the same bytes are encoded may be
+	// accepted. decompress_bytes must never read or write out of bounds.
+
+	std::string corrupt_output;
+
+	for (size_t length = 0; length < column_data.size(); length++)
+	{
+		if (decompress_bytes(column_data.substr(0, length), corrupt_output))
+		{
+			std::cout << "    decompress_bytes accepts a column truncated to " << length << " bytes." << std::endl;
+		}
+	}
+
+	unsigned int flipped_bits = 0;
+
+	unsigned int rejected_bits = 0;
+
+	for (size_t i = 0; i < column_data.size(); i++)
+	for (unsigned int bit = 0; bit < 8; bit++)
+	{
+		std::string corrupt_data = column_data;
+
+		corrupt_data[i] ^= char(1 << bit);
+
+		bool accepted = decompress_bytes(corrupt_data, corrupt_output);
+
+		if (accepted && i < sizeof(unsigned int))
+		{
+			std::cout << "    decompress_bytes accepts a column with a changed size." << std::endl;
+		}
+
+		if (accepted && corrupt_output != raw_column)
+		{
+			std::cout << "    decompress_bytes accepts a flipped bit that changes a column." << std::endl;
+		}
+
+		flipped_bits++;
+
+		rejected_bits += !accepted;
+	}
+
+	std::cout << "    decompress_bytes rejects " << rejected_bits << " of " << flipped_bits << " single bit flips of a column" << std::endl;
+
+	// Check that read_column_data rejects a column whose data decompresses
+	// fine, but holds a palette entry that is not a block_id, an index past
+	// the end of the palette, or a cut off section, and that it leaves the
+	// column empty.
+
+	std::vector<std::string> corrupt_columns;
+
+	size_t section_start = 0;
+
+	unsigned int section_header[2] = {0, 0};
+
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	{
+		memcpy(section_header, raw_column.data() + section_start, sizeof(section_header));
+
+		if (section_header[0] != 0)
+		{
+			break;
+		}
+
+		section_start += sizeof(section_header);
+	}
+
+	if (section_header[0] != 0)
+	{
+		std::string bad_palette = raw_column;
+
+		unsigned short bad_id = id_null;
+
+		memcpy(&bad_palette[section_start + sizeof(section_header)], &bad_id, sizeof(bad_id));
+
+		corrupt_columns.push_back(bad_palette);
+
+		// Drop the last palette entry, so the indices that refer to it are
+		// past the end of the palette.
+
+		std::string bad_indices = raw_column;
+
+		unsigned int smaller_palette = section_header[1] - 1;
+
+		memcpy(&bad_indices[section_start + sizeof(unsigned int)], &smaller_palette, sizeof(smaller_palette));
+
+		bad_indices.erase(section_start + sizeof(section_header) + smaller_palette * sizeof(unsigned short), sizeof(unsigned short));
+
+		corrupt_columns.push_back(bad_indices);
+	}
+	else
+	{
+		std::cout << "    The column has no section with a palette to corrupt." << std::endl;
+	}
+
+	corrupt_columns.push_back(raw_column.substr(0, raw_column.size() - 1));
+
+	world* corrupt_world = allocate_world_window(the_world->x_res, the_world->y_res, the_world->z_res, 1, 1);
+
+	allocate_column(corrupt_world, 0, 0);
+
+	for (size_t i = 0; i < corrupt_columns.size(); i++)
+	{
+		bool read = read_column_data(corrupt_world, 0, 0, compress_bytes(corrupt_columns[i]), true);
+
+		bool empty = true;
+
+		for (unsigned int j = 0; j < 256; j++)
+		{
+			empty = empty && corrupt_world->top_non_air(j & 15, j >> 4) == corrupt_world->y_res;
+		}
+
+		if (read || !empty)
+		{
+			std::cout << "    read_column_data accepts a corrupt column, or does not leave it empty." << std::endl;
+		}
+	}
+
+	deallocate_world(corrupt_world);
+
+	// Check that a region file round trips through read_region_file, and
+	// that region_header_valid (with the size check of read_region_file)
+	// rejects the file once it is truncated into the data of a column, or
+	// once the top byte of a column's offset or size is flipped.
+
+	std::string the_region_path = region_path(serial_level_path, 0, 0);
+
+	unsigned int region_flags;
+
+	std::vector<std::string> region_data;
+
+	read_region_file(the_region_path, region_flags, region_data);
+
+	bool region_round_trips = true;
+
+	for (unsigned int z = 0; z < std::min(z_res, region_res * 16); z += 16)
+	for (unsigned int x = 0; x < std::min(x_res, region_res * 16); x += 16)
+	{
+		region_round_trips = region_round_trips && region_data[region_index(x, z)] == write_column_data(the_world, x, z, region_flags & region_lighting);
+	}
+
+	if (!region_round_trips)
+	{
+		std::cout << "    The region file does not match the world." << std::endl;
+	}
+
+	std::ifstream region_file(the_region_path, std::ios::binary);
+
+	std::string region_bytes_read((std::istreambuf_iterator<char>(region_file)), std::istreambuf_iterator<char>());
+
+	region_header* header = new region_header();
+
+	memcpy(header, region_bytes_read.data(), sizeof(region_header));
+
+	unsigned long long data_end = sizeof(region_header);
+
+	for (unsigned int i = 0; i < region_columns; i++)
+	{
+		if (header->offsets[i] != 0)
+		{
+			data_end = std::max(data_end, (unsigned long long)header->offsets[i] + header->sizes[i]);
+		}
+	}
+
+	for (unsigned long long size = 0; size <= region_bytes_read.size(); size += size + 4096 < region_bytes_read.size() ? 997 : 1)
+	{
+		bool accepted = size >= sizeof(region_header) && region_header_valid(*header, size);
+
+		if (accepted != (size >= data_end))
+		{
+			std::cout << "    region_header_valid " << (accepted ? "accepts" : "rejects") << " a region file truncated to " << size << " bytes." << std::endl;
+		}
+	}
+
+	for (unsigned int i = 0; i < region_columns; i++)
+	{
+		if (header->offsets[i] == 0)
+		{
+			continue;
+		}
+
+		unsigned int* fields[2] = {&header->offsets[i], &header->sizes[i]};
+
+		for (unsigned int* field: fields)
+		{
+			*field ^= 0x80000000;
+
+			if (region_header_valid(*header, region_bytes_read.size()))
+			{
+				std::cout << "    region_header_valid accepts a region file with a flipped offset or size." << std::endl;
+			}
+
+			*field ^= 0x80000000;
+		}
+	}
+
+	header->magic ^= 1;
+
+	if (region_header_valid(*header, region_bytes_read.size()))
+	{
+		std::cout << "    region_header_valid accepts a region file with a flipped magic number." << std::endl;
+	}
+
+	delete header;
+
+	bench_remove_level(serial_level_path, x_res, z_res);
+
+	// Measure saving the level again after placing a few blocks, which only
+	// writes the columns that were modified. There is no OpenGL context for
+	// an accessor, so the columns are marked as modified the same way that
+	// accessor::set_id_safe marks them.
+
+	unsigned int edit_count = 8;
+
+	for (unsigned int i = 0; i < edit_count; i++)
+	{
+		unsigned int x = (i * 97) % x_res;
+		unsigned int z = (i * 61) % z_res;
+
+		the_world->set_id(x, 0, z, id_stone);
+
+		the_world->columns_modified[the_world->column_slot(x, z)] = true;
+	}
+
+	bench_counter level_resave_counter;
+
+	level_resave_counter.start();
+
+	save_modified_columns_to_level(the_world, 1024, 0.0f, 0.0f, 0.0f, level_path);
+
+	level_resave_counter.stop();
+
+	level_resave_counter.print("save_modified_columns_to_level, " + std::to_string(edit_count) + " blocks placed");
+
+	unsigned long long region_bytes = bench_remove_level(level_path, x_res, z_res);
+
+	std::cout << "    Region files: " << region_bytes / 1024 << " KiB (flat file: " << (world_file_header_size + (unsigned long long)x_res * y_res * z_res * sizeof(voxel)) / 1024 << " KiB)" << std::endl;
+
+	std::remove(world_path.c_str());
+
+	// Measure a background save of the whole world. The calling thread only
+	// takes a snapshot of the world, and the columns are compressed and
+	// written on the save's own thread.
+
+	bench_counter start_save_counter;
+
+	start_save_counter.start();
+
+	level_save* the_save = start_level_save(the_world, 1024, 0.0f, 0.0f, 0.0f, level_path);
+
+	start_save_counter.stop();
+
+	start_save_counter.print("start_level_save, on the calling thread");
+
+	bench_counter background_save_counter;
+
+	background_save_counter.start();
+
+	finish_level_save(the_world, the_save);
+
+	background_save_counter.stop();
+
+	background_save_counter.print("level_save, until finished");
+
+	bench_remove_level(level_path, x_res, z_res);
+
+	deallocate_world(the_world);
+
+	// Measure a world that is generated one column at a time. Only it's seed
+	// and the columns that were modified are saved, and the other columns
+	// are generated again when it is loaded.
+
+	world* column_world = allocate_world(x_res, y_res, z_res);
+
+	bench_counter column_generate_counter;
+
+	column_generate_counter.start();
+
+	generate_world_columns(column_world, 1024);
+
+	column_generate_counter.stop();
+
+	column_generate_counter.print("generate_world_columns");
+
+	for (unsigned int i = 0; i < edit_count; i++)
+	{
+		unsigned int x = (i * 97) % x_res;
+		unsigned int z = (i * 61) % z_res;
+
+		column_world->set_id(x, 0, z, id_stone);
+
+		column_world->columns_modified[column_world->column_slot(x, z)] = true;
+	}
+
+	bench_counter diff_save_counter;
+
+	diff_save_counter.start();
+
+	save_world_to_level(column_world, 1024, 0.0f, 0.0f, 0.0f, level_path);
+
+	diff_save_counter.stop();
+
+	diff_save_counter.print("save_world_to_level, seed and " + std::to_string(edit_count) + " modified columns");
+
+	bench_counter diff_load_counter;
+
+	diff_load_counter.start();
+
+	load_world_from_level(loaded_world, level_path, 1024, generated_by_column, x_res, y_res, z_res);
+
+	diff_load_counter.stop();
+
+	diff_load_counter.print("load_world_from_level, unmodified columns generated again");
+
+	unsigned long long diff_bytes = bench_remove_level(level_path, x_res, z_res);
+
+	std::cout << "    Region files: " << diff_bytes / 1024 << " KiB (" << diff_bytes << " bytes)" << std::endl;
+
+	// The placed blocks did not update the lighting, so only the block_ids
+	// are compared.
+
+	unsigned long long mismatched_voxels = 0;
+
+	for (unsigned int x = 0; x < x_res; x++)
+	for (unsigned int y = 0; y < y_res; y++)
+	for (unsigned int z = 0; z < z_res; z++)
+	{
+		if (loaded_world->get_id(x, y, z) != column_world->get_id(x, y, z))
+		{
+			mismatched_voxels++;
+		}
+	}
+
+	if (mismatched_voxels != 0)
+	{
+		std::cout << "    The loaded world does not match." << std::endl;
+	}
+
+	deallocate_world(loaded_world);
+
+	deallocate_world(column_world);
+
+	// Measure the startup cost of a streaming world, which depends on the 
+	// render distance instead of the size of the world.
+
+	for (int radius = 4; radius <= 16; radius *= 2)
+	{
+		world* streaming_world = allocate_streaming_world(y_res);
+
+		accessor* streaming_accessor = allocate_accessor(streaming_world);
+
+		stream* the_stream = allocate_stream(streaming_accessor, 1024, std::string());
+
+		bench_counter stream_counter;
+
+		stream_counter.start();
+
+		unsigned int center = streaming_world_res / 2;
+
+		for (int dz = -radius - 1; dz <= radius + 1; dz++)
+		for (int dx = -radius - 1; dx <= radius + 1; dx++)
+		{
+			make_column_resident(the_stream, center + dx * 16, center + dz * 16);
+		}
+
+		stream_counter.stop();
+
+		stream_counter.print("streaming world, radius " + std::to_string(radius) + ", make_column_resident");
+
+		std::cout << "    Voxel memory: " << world_memory_usage(streaming_world) / 1024 << " KiB" << std::endl;
+
+		// Count the chunks (and the voxels in them) that are marked for 
+		// remeshing when one block is placed on the ground. There is no 
+		// OpenGL context, so the columns around the block get chunks that
+		// only keep track of changes, and are never meshed.
+
+		std::vector<chunk*> bench_chunks;
+
+		for (int dz = -1; dz <= 1; dz++)
+		for (int dx = -1; dx <= 1; dx++)
+		for (unsigned int y = 0; y < y_res; y += 16)
+		{
+			chunk* the_chunk = new chunk();
+
+			the_chunk->modified = false;
+
+			the_chunk->changes = 0;
+
+			memset(the_chunk->changed_voxels, 0, sizeof(the_chunk->changed_voxels));
+
+			streaming_accessor->the_chunks[streaming_world->section_index(center + dx * 16, y, center + dz * 16)] = the_chunk;
+
+			bench_chunks.push_back(the_chunk);
+		}
+
+		unsigned int ground = streaming_world->top_non_air(center + 8, center + 8);
+
+		streaming_accessor->set_id_safe(center + 8, ground - 1, center + 8, id_stone);
+
+		unsigned int marked_chunks = 0;
+
+		unsigned int marked_voxels = 0;
+
+		unsigned int meshed_chunks = 0;
+
+		for (size_t i = 0; i < streaming_accessor->chunk_count; i++)
+		{
+			chunk* the_chunk = streaming_accessor->the_chunks[i];
+
+			if (the_chunk && the_chunk->modified)
+			{
+				marked_chunks++;
+
+				marked_voxels += the_chunk->changed_voxel_count();
+
+				if (chunk_needs_meshing(streaming_world, the_chunk))
+				{
+					meshed_chunks++;
+				}
+			}
+		}
+
+		std::cout << "    Placing one block marks " << marked_chunks << " chunks and " << marked_voxels << " voxels (" << streaming_world->chunk_y_res << " chunks per column), " << meshed_chunks << " of the chunks need meshing again" << std::endl;
+
+		for (size_t i = 0; i < streaming_accessor->chunk_count; i++)
+		{
+			streaming_accessor->the_chunks[i] = nullptr;
+		}
+
+		for (chunk* the_chunk: bench_chunks)
+		{
+			delete the_chunk;
+		}
+
+		deallocate_stream(the_stream);
+
+		deallocate_accessor(streaming_accessor);
+
+		deallocate_world(streaming_world);
+	}
+
+	// Measure an autosave of a streaming world, whose columns are saved by
+	// the calling thread a few at a time. Every resident column is marked as
+	// modified, so the autosave saves every one of them.
+
+	{
+		world* streaming_world = allocate_streaming_world(y_res);
+
+		accessor* streaming_accessor = allocate_accessor(streaming_world);
+
+		std::string stream_level_path = "minceraft_bench_stream";
+
+		make_directory(stream_level_path);
+
+		stream* the_stream = allocate_stream(streaming_accessor, 1024, stream_level_path);
+
+		unsigned int center = streaming_world_res / 2;
+
+		int radius = 4;
+
+		for (int dz = -radius; dz <= radius; dz++)
+		for (int dx = -radius; dx <= radius; dx++)
+		{
+			make_column_resident(the_stream, center + dx * 16, center + dz * 16);
+
+			streaming_world->columns_modified[streaming_world->column_slot(center + dx * 16, center + dz * 16)] = true;
+		}
+
+		unsigned int columns_per_frame = 4;
+
+		autosave* the_autosave = allocate_autosave(streaming_world, the_stream, nullptr, 1024, stream_level_path, 0, columns_per_frame);
+
+		request_autosave(the_autosave);
+
+		while (!update_autosave(the_autosave, 0.0f, 0.0f, 0.0f))
+		{
+		}
+
+		std::cout << "    update_autosave, streaming world, " << columns_per_frame << " columns per frame: " << the_autosave->columns_saved << " columns in " << the_autosave->frames << " frames, " << the_autosave->frame_time_in_ms / the_autosave->frames << " ms per frame (at most " << the_autosave->max_frame_time_in_ms << " ms)" << std::endl;
+
+		deallocate_autosave(the_autosave);
+
+		// Measure journaling edits, which is what makes an edit durable
+		// between autosaves, and compare it to saving the edited column.
+
+		journal* the_journal = allocate_journal(stream_level_path);
+
+		unsigned int journal_edits = 10000;
+
+		bench_counter journal_counter;
+
+		journal_counter.start();
+
+		for (unsigned int i = 0; i < journal_edits; i++)
+		{
+			append_to_journal(the_journal, center + i % 16, i % y_res, center, id_air, id_stone);
+		}
+
+		journal_counter.stop();
+
+		std::cout << "    append_to_journal: " << journal_counter.milliseconds * 1000.0 / journal_edits << " us per edit (" << journal_edits << " edits)" << std::endl;
+
+		bench_counter column_counter;
+
+		column_counter.start();
+
+		save_column_to_file(streaming_world, center, center, stream_level_path);
+
+		column_counter.stop();
+
+		column_counter.print("save_column_to_file, one edited column");
+
+		bench_counter replay_counter;
+
+		replay_counter.start();
+
+		size_t journal_entries = read_journal(stream_level_path).size();
+
+		replay_counter.stop();
+
+		replay_counter.print("read_journal, " + std::to_string(journal_entries) + " edits");
+
+		truncate_journal(the_journal);
+
+		deallocate_journal(the_journal);
+
+		std::remove(journal_path(stream_level_path).c_str());
+
+		for (int dz = -radius; dz <= radius; dz++)
+		for (int dx = -radius; dx <= radius; dx++)
+		{
+			std::remove(region_path(stream_level_path, center + dx * 16, center + dz * 16).c_str());
+		}
+
+		std::remove((stream_level_path + "/level.dat").c_str());
+
+		std::remove(stream_level_path.c_str());
+
+		deallocate_stream(the_stream);
+
+		deallocate_accessor(streaming_accessor);
+
+		deallocate_world(streaming_world);
+	}
+
+	return 0;
+}
@@ -1,12 +1,15 @@
 #version 330 core
 
-// Vertex attributes.
+// Vertex attributes, packed like the packed_vertex struct in chunk.hpp.
 
-layout (location = 0) in vec3 vertex_position;
+layout (location = 0) in uint vertex_position;
 
-layout (location = 1) in vec3 vertex_texture;
+layout (location = 1) in uint vertex_texture;
 
-layout (location = 2) in float vertex_lighting;
+// The lighting coefficients of the faces, in the order of their indices in a
+// packed vertex. They must match face_coefficient_indices in mesh.hpp.
+
+const float face_coefficients[4] = float[4](1.0f, 0.65f, 0.75f, 0.9f);
 
 // Input matrices.
 
@@ -16,6 +19,10 @@ uniform mat4 matrix_view;
 
 uniform mat4 matrix_model;
 
+// The position of the chunk that is being rendered.
+
+uniform vec3 chunk_offset;
+
 // Input time (in seconds).
 
 uniform float time_in_seconds;
@@ -32,24 +39,48 @@ out float frag_distance;
 
 void main()
 {
+	// Unpack the position, which is stored relative to the chunk in 1/16 of
+	// a voxel, with the Y axis pointing down.
+
+	vec3 position = vec3
+	(
+		float(vertex_position & 511u),
+
+		-float((vertex_position >> 9u) & 511u),
+
+		float((vertex_position >> 18u) & 511u)
+	);
+
+	position = position / 16.0f + chunk_offset;
+
 	// Multiply the vertex position by the projection, view, and model 
 	// matrices to find the final position.
 
-	gl_Position = matrix_projection * matrix_view * matrix_model * vec4(vertex_position, 1.0f);
+	gl_Position = matrix_projection * matrix_view * matrix_model * vec4(position, 1.0f);
 
-	// Pass the texture vertex attribute and the lighting vertex attribute to 
-	// the fragment shader.
+	// Unpack the texture coordinates and the layer, and pass them to the
+	// fragment shader.
+
+	frag_texture = vec3
+	(
+		float(vertex_texture & 511u) / 16.0f,
 
-	frag_texture = vertex_texture;
+		float((vertex_texture >> 9u) & 511u) / 16.0f,
 
-	if (frag_texture.z < 0.0f)
+		float((vertex_texture >> 18u) & 255u)
+	);
+
+	if (((vertex_position >> 29u) & 1u) != 0u)
 	{
 		// Animate the texture.
 
-		frag_texture.z = abs(frag_texture.z) + mod(floor(time_in_seconds * 16.0f), 31.0f);
+		frag_texture.z = frag_texture.z + mod(floor(time_in_seconds * 16.0f), 31.0f);
 	}
 
-	frag_lighting = vertex_lighting;
+	// Unpack the lighting coefficient and the light level, and pass their
+	// product to the fragment shader.
+
+	frag_lighting = face_coefficients[(vertex_position >> 27u) & 3u] * (float((vertex_texture >> 26u) & 15u) / 15.0f);
 
 	// Pass the distance to the origin squared to the fragment shader, so that
 	// it is simple to calculate fog density.
@@ -12,7 +12,11 @@ struct accessor
 	unsigned int chunk_y_res;
 	unsigned int chunk_z_res;
 
-	unsigned int chunk_count;
+	size_t chunk_count;
+
+	// The journal* that every edit is appended to, or nullptr.
+
+	journal* the_journal;
 
 	// Set the block_id information of the voxel at the specified coordinates,
 	// if the coordinates are within the bounds of the world.
@@ -30,13 +34,16 @@ struct accessor
 		{
 			// Something actually changed.
 
-			int cx = x / 16;
-			int cy = y / 16;
-			int cz = z / 16;
-
 			the_world->set_id(x, y, z, id);
 
-			the_chunks[cx + chunk_x_res * (cy + chunk_y_res * cz)]->modified = true;
+			the_world->columns_modified[the_world->column_slot(x, z)] = true;
+
+			if (the_journal)
+			{
+				append_to_journal(the_journal, x, y, z, old_id, id);
+			}
+
+			mark_chunk_modified(the_world, the_chunks, x, y, z, change_geometry);
 
 			// If the new block_id is transparent, neighboring chunks may need
 			// to be updated as well.
@@ -49,44 +56,44 @@ struct accessor
 
 				// Negative X.
 
-				if (x != 0 && xc == 0)
+				if (xc == 0)
 				{
-					the_chunks[(cx - 1) + chunk_x_res * (cy + chunk_y_res * cz)]->modified = true;
+					mark_chunk_modified(the_world, the_chunks, x - 1, y, z, change_neighbor);
 				}
 
 				// Positive X.
 
-				if (x != the_world->x_res - 1 && xc == 15)
+				if (xc == 15)
 				{
-					the_chunks[(cx + 1) + chunk_x_res * (cy + chunk_y_res * cz)]->modified = true;
+					mark_chunk_modified(the_world, the_chunks, x + 1, y, z, change_neighbor);
 				}
 
 				// Negative Y.
 
-				if (y != 0 && yc == 0)
+				if (yc == 0)
 				{
-					the_chunks[cx + chunk_x_res * ((cy - 1) + chunk_y_res * cz)]->modified = true;
+					mark_chunk_modified(the_world, the_chunks, x, y - 1, z, change_neighbor);
 				}
 
 				// Positive Y.
 
-				if (y != the_world->y_res - 1 && yc == 15)
+				if (yc == 15)
 				{
-					the_chunks[cx + chunk_x_res * ((cy + 1) + chunk_y_res * cz)]->modified = true;
+					mark_chunk_modified(the_world, the_chunks, x, y + 1, z, change_neighbor);
 				}
 
 				// Negative Z.
 
-				if (z != 0 && zc == 0)
+				if (zc == 0)
 				{
-					the_chunks[cx + chunk_x_res * (cy + chunk_y_res * (cz - 1))]->modified = true;
+					mark_chunk_modified(the_world, the_chunks, x, y, z - 1, change_neighbor);
 				}
 
 				// Positive Z.
 
-				if (z != the_world->z_res - 1 && zc == 15)
+				if (zc == 15)
 				{
-					the_chunks[cx + chunk_x_res * (cy + chunk_y_res * (cz + 1))]->modified = true;
+					mark_chunk_modified(the_world, the_chunks, x, y, z + 1, change_neighbor);
 				}
 			}
 		}
@@ -101,10 +108,6 @@ struct accessor
 
  				the_chunks, 
 
- 				chunk_x_res,
- 				chunk_y_res,
- 				chunk_z_res,
-
  				x, 
  				z
  			);
@@ -124,7 +127,43 @@ struct accessor
 	}
 };
 
-// Create an accessor* from a world*.
+// Create the chunks of the column that holds the voxel at the specified X and
+// Z coordinates.
+
+void allocate_column_chunks(accessor* the_accessor, unsigned int x, unsigned int z)
+{
+	world* the_world = the_accessor->the_world;
+
+	x &= ~15u;
+	z &= ~15u;
+
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	{
+		the_accessor->the_chunks[the_world->section_index(x, y, z)] = allocate_chunk(the_world, x, y, z, 16, 16, 16);
+	}
+}
+
+// Destroy the chunks of the column in the specified slot, if it has any.
+
+void deallocate_column_chunks(accessor* the_accessor, unsigned int slot)
+{
+	world* the_world = the_accessor->the_world;
+
+	for (unsigned int cy = 0; cy < the_world->chunk_y_res; cy++)
+	{
+		chunk*& the_chunk = the_accessor->the_chunks[the_world->slot_section_index(slot, cy)];
+
+		if (the_chunk)
+		{
+			deallocate_chunk(the_chunk);
+
+			the_chunk = nullptr;
+		}
+	}
+}
+
+// Create an accessor* from a world*. Chunks are created for every resident
+// column of the world.
 
 accessor* allocate_accessor(world* the_world)
 {
@@ -134,15 +173,20 @@ accessor* allocate_accessor(world* the_world)
 
 	the_accessor->the_world = the_world;
 
-	the_accessor->chunk_x_res = the_world->x_res / 16;
-	the_accessor->chunk_y_res = the_world->y_res / 16;
-	the_accessor->chunk_z_res = the_world->z_res / 16;
+	the_accessor->the_journal = nullptr;
+
+	// The chunks are ordered like the sections of the world.
 
-	the_accessor->chunk_count = the_accessor->chunk_x_res * the_accessor->chunk_y_res * the_accessor->chunk_z_res;
+	the_accessor->chunk_x_res = the_world->window_x_res;
+	the_accessor->chunk_y_res = the_world->chunk_y_res;
+	the_accessor->chunk_z_res = the_world->window_z_res;
 
-	// Allocate an array of chunk pointers.
+	the_accessor->chunk_count = size_t(the_accessor->chunk_x_res) * the_accessor->chunk_y_res * the_accessor->chunk_z_res;
 
-	the_accessor->the_chunks = (chunk**)malloc(the_accessor->chunk_count * sizeof(chunk*));
+	// Reserve an array of chunk pointers. Slots without a resident column 
+	// have no chunks, so most of a huge world's array is never touched.
+
+	the_accessor->the_chunks = (chunk**)reserve_memory(the_accessor->chunk_count * sizeof(chunk*));
 
 	if (!the_accessor->the_chunks)
 	{
@@ -151,19 +195,60 @@ accessor* allocate_accessor(world* the_world)
 		exit(15);
 	}
 
-	// Generate all of the chunks.
+	// Generate the chunks of every resident column.
+
+	size_t slot_count = size_t(the_world->window_x_res) * the_world->window_z_res;
 
-	for (int z = 0; z < the_accessor->chunk_z_res; z++)
+	std::vector<unsigned int> resident_columns;
+
+	for (size_t i = 0; i < slot_count; i++)
 	{
-		for (int y = 0; y < the_accessor->chunk_y_res; y++)
+		if (the_world->columns[i] != no_column)
 		{
-			for (int x = 0; x < the_accessor->chunk_x_res; x++)
-			{
-				the_accessor->the_chunks[x + the_accessor->chunk_x_res * (y + the_accessor->chunk_y_res * z)] = allocate_chunk(the_world, x * 16, y * 16, z * 16, 16, 16, 16);
+			resident_columns.push_back(the_world->columns[i]);
+		}
+	}
 
-				std::cout << "Loading world: " << int(float(x + the_accessor->chunk_x_res * (y + the_accessor->chunk_y_res * z) + 1) / float(the_accessor->chunk_x_res * the_accessor->chunk_y_res * the_accessor->chunk_z_res) * 100.0f) << "% complete..." << std::string(16, ' ') << "\r" << std::flush;
-			}
+	if (resident_columns.empty())
+	{
+		return the_accessor;
+	}
+
+	// The chunks are meshed on every hardware thread, a few columns per
+	// thread at a time, and uploaded to the GPU on this thread, which owns
+	// the OpenGL context.
+
+	size_t columns_per_batch = size_t(parallel_threads) * 4;
+
+	std::vector<chunk_mesh*> meshes;
+
+	for (size_t first = 0; first < resident_columns.size(); first += columns_per_batch)
+	{
+		size_t column_count = std::min(columns_per_batch, resident_columns.size() - first);
+
+		meshes.assign(column_count * the_world->chunk_y_res, nullptr);
+
+		run_in_parallel(meshes.size(), [&](size_t i)
+		{
+			unsigned int column = resident_columns[first + i / the_world->chunk_y_res];
+
+			unsigned int x = (column % the_world->chunk_x_res) * 16;
+			unsigned int y = (i % the_world->chunk_y_res) * 16;
+			unsigned int z = (column / the_world->chunk_x_res) * 16;
+
+			meshes[i] = allocate_chunk_mesh(the_world, x, y, z, 16, 16, 16);
+		});
+
+		for (chunk_mesh* the_mesh: meshes)
+		{
+			the_accessor->the_chunks[the_world->section_index(the_mesh->x, the_mesh->y, the_mesh->z)] = allocate_chunk(the_mesh);
+
+			deallocate_chunk_mesh(the_mesh);
 		}
+
+		size_t loaded_count = first + column_count;
+
+		std::cout << "Loading world: " << int(float(loaded_count) / float(resident_columns.size()) * 100.0f) << "% complete..." << std::string(16, ' ') << "\r" << std::flush;
 	}
 
 	std::cout << "Loading world: 100% complete." << std::string(16, ' ') << std::endl;
@@ -179,12 +264,17 @@ void deallocate_accessor(accessor* the_accessor)
 {
 	// Destroy all of the contained chunks.
 
-	for (int i = 0; i < the_accessor->chunk_count; i++)
+	for (size_t i = 0; i < the_accessor->chunk_count; i++)
 	{
-		deallocate_chunk(the_accessor->the_chunks[i]);
+		if (the_accessor->the_chunks[i])
+		{
+			deallocate_chunk(the_accessor->the_chunks[i]);
+		}
 	}
 
+	release_memory(the_accessor->the_chunks, the_accessor->chunk_count * sizeof(chunk*));
+
 	// Delete the accessor*.
 
 	delete the_accessor;
-}
\ No newline at end of file
+}
@@ -570,26 +570,34 @@ std::vector<std::string> block_id_to_block_name =
 	"Fire"
 };
 
-// Returns true if a block is a fire block. Otherwise, returns false.
-
-inline bool is_fire(block_id id)
+// The properties of every block_id are kept as flags in block_flags, a table
+// that is built at compile time from the definitions below, so checking a 
+// property is a single load.
+
+const unsigned char flag_fire = 1 << 0;
+const unsigned char flag_cross = 1 << 1;
+const unsigned char flag_crop = 1 << 2;
+const unsigned char flag_slab = 1 << 3;
+const unsigned char flag_transparent = 1 << 4;
+const unsigned char flag_not_permeable_mob = 1 << 5;
+const unsigned char flag_not_permeable_ray = 1 << 6;
+const unsigned char flag_not_permeable_light = 1 << 7;
+
+// Defines which blocks are fire blocks.
+
+constexpr bool defines_fire(unsigned int id)
 {
-	if 
+	return
 	(
 		id == id_fire
-	)
-	{
-		return true;
-	}
-
-	return false;
+	);
 }
 
-// Returns true if a block is a cross block. Otherwise, returns false.
+// Defines which blocks are cross blocks.
 
-inline bool is_cross(block_id id)
+constexpr bool defines_cross(unsigned int id)
 {
-	if 
+	return
 	(
 		id == id_rose ||
 
@@ -604,72 +612,46 @@ inline bool is_cross(block_id id)
 		id == id_oak_sapling || 
 
 		id == id_birch_sapling
-	)
-	{
-		return true;
-	}
-
-	return false;
+	);
 }
 
-// Returns true if a block is a crop block. Otherwise, returns false.
+// Defines which blocks are crop blocks.
 
-inline bool is_crop(block_id id)
+constexpr bool defines_crop(unsigned int id)
 {
-	if
+	return
 	(
 		id == id_wheat_0 ||
-
 		id == id_wheat_1 ||
-
 		id == id_wheat_2 ||
-
 		id == id_wheat_3 ||
-
 		id == id_wheat_4 ||
-
 		id == id_wheat_5 ||
-
 		id == id_wheat_6 ||
-
 		id == id_wheat_7 ||
 
 		id == id_carrots_0 ||
-
 		id == id_carrots_1 ||
-
 		id == id_carrots_2 ||
-
 		id == id_carrots_3 ||
 
 		id == id_potatoes_0 ||
-
 		id == id_potatoes_1 ||
-
 		id == id_potatoes_2 ||
-
 		id == id_potatoes_3 ||
 
 		id == id_beetroots_0 ||
-
 		id == id_beetroots_1 ||
-
 		id == id_beetroots_2 ||
-
 		id == id_beetroots_3
-	)
-	{
-		return true;
-	}
-
-	return false;
+	);
 }
 
-// Returns true if a block is a slab. Otherwise, returns false.
+// Defines which blocks are slabs.
 
-inline bool is_slab(block_id id)
+constexpr bool defines_slab(unsigned int id)
 {
-	if
+	return
 	(
 		id == id_stone_slab ||
 
@@ -682,19 +664,14 @@ inline bool is_slab(block_id id)
 		id == id_cobblestone_slab ||
 
 		id == id_brick_slab
-	)
-	{
-		return true;
-	}
-
-	return false;
+	);
 }
 
-// Returns true if the block is not opaque. Otherwise, returns false.
+// Defines which blocks are not opaque.
 
-inline bool is_transparent(block_id id)
+constexpr bool defines_transparent(unsigned int id)
 {
-	if 
+	return
 	(
 		id == id_air || 
 
@@ -708,26 +685,21 @@ inline bool is_transparent(block_id id)
 
 		id == id_null ||
 
-		is_cross(id) ||
-
-		is_crop(id) ||
+		defines_cross(id) ||
 
-		is_slab(id) ||
+		defines_crop(id) ||
 
-		is_fire(id)
-	)
-	{
-		return true;
-	}
+		defines_slab(id) ||
 
-	return false;
+		defines_fire(id)
+	);
 }
 
-// Returns false if a block is permeable to players. Otherwise, returns true.
+// Defines which blocks are permeable to players.
 
-inline bool is_not_permeable_mob(block_id id)
+constexpr bool defines_permeable_mob(unsigned int id)
 {
-	if 
+	return
 	(
 		id == id_air ||
 
@@ -735,59 +707,165 @@ inline bool is_not_permeable_mob(block_id id)
 
 		id == id_null ||
 
-		is_cross(id) ||
+		defines_cross(id) ||
 
-		is_crop(id) ||
+		defines_crop(id) ||
 
-		is_fire(id)
-	)
-	{
-		return false;
-	}
-
-	return true;
+		defines_fire(id)
+	);
 }
 
-// Returns false if a block is permeable to rays. Otherwise, returns true.
+// Defines which blocks are permeable to rays.
 
-inline bool is_not_permeable_ray(block_id id)
+constexpr bool defines_permeable_ray(unsigned int id)
 {
-	if 
+	return
 	(
 		id == id_air ||
 
 		id == id_water ||
 
 		id == id_null
-	)
-	{
-		return false;
-	}
-
-	return true;
+	);
 }
 
-// Returns false if a block is permeable to light. Otherwise, returns true.
+// Defines which blocks are permeable to light.
 
-inline bool is_not_permeable_light(block_id id)
+constexpr bool defines_permeable_light(unsigned int id)
 {
-	if 
+	return
 	(
 		id == id_air ||
 
 		id == id_glass ||
 
-		is_cross(id) ||
+		defines_cross(id) ||
+
+		defines_crop(id) ||
+
+		defines_fire(id)
+	);
+}
+
+// Combine the definitions of a block into it's flags.
+
+constexpr unsigned char block_flags_of(unsigned int id)
+{
+	return
+	(
+		(defines_fire(id) ? flag_fire : 0) |
+
+		(defines_cross(id) ? flag_cross : 0) |
+
+		(defines_crop(id) ? flag_crop : 0) |
+
+		(defines_slab(id) ? flag_slab : 0) |
+
+		(defines_transparent(id) ? flag_transparent : 0) |
+
+		(defines_permeable_mob(id) ? 0 : flag_not_permeable_mob) |
+
+		(defines_permeable_ray(id) ? 0 : flag_not_permeable_ray) |
+
+		(defines_permeable_light(id) ? 0 : flag_not_permeable_light)
+	);
+}
+
+// The table of flags has an entry for every value that a voxel's block_id
+// can have, so it can be indexed without checking the block_id first. It is
+// built by expanding a pack of the indices 0 to 255.
+
+struct block_flag_table
+{
+	unsigned char flags[256];
+};
+
+template <unsigned int... I>
+struct block_indices
+{
+};
+
+template <unsigned int N, unsigned int... I>
+struct make_block_indices: make_block_indices<N - 1, N - 1, I...>
+{
+};
+
+template <unsigned int... I>
+struct make_block_indices<0, I...>
+{
+	typedef block_indices<I...> type;
+};
+
+template <unsigned int... I>
+constexpr block_flag_table make_block_flag_table(block_indices<I...>)
+{
+	return {{block_flags_of(I)...}};
+}
+
+constexpr block_flag_table block_flags = make_block_flag_table(make_block_indices<256>::type());
+
+// Returns true if a block has all of the specified flags. Otherwise, returns
+// false.
+
+inline bool has_flags(block_id id, unsigned char flags)
+{
+	return (block_flags.flags[id & 0xff] & flags) == flags;
+}
+
+// Returns true if a block is a fire block. Otherwise, returns false.
+
+inline bool is_fire(block_id id)
+{
+	return has_flags(id, flag_fire);
+}
+
+// Returns true if a block is a cross block. Otherwise, returns false.
+
+inline bool is_cross(block_id id)
+{
+	return has_flags(id, flag_cross);
+}
+
+// Returns true if a block is a crop block. Otherwise, returns false.
 
-		is_crop(id) ||
+inline bool is_crop(block_id id)
+{
+	return has_flags(id, flag_crop);
+}
+
+// Returns true if a block is a slab. Otherwise, returns false.
+
+inline bool is_slab(block_id id)
+{
+	return has_flags(id, flag_slab);
+}
+
+// Returns true if the block is not opaque. Otherwise, returns false.
+
+inline bool is_transparent(block_id id)
+{
+	return has_flags(id, flag_transparent);
+}
 
-		is_fire(id)
-	)
-	{
-		return false;
-	}
+// Returns false if a block is permeable to players. Otherwise, returns true.
+
+inline bool is_not_permeable_mob(block_id id)
+{
+	return has_flags(id, flag_not_permeable_mob);
+}
+
+// Returns false if a block is permeable to rays. Otherwise, returns true.
 
-	return true;
+inline bool is_not_permeable_ray(block_id id)
+{
+	return has_flags(id, flag_not_permeable_ray);
+}
+
+// Returns false if a block is permeable to light. Otherwise, returns true.
+
+inline bool is_not_permeable_light(block_id id)
+{
+	return has_flags(id, flag_not_permeable_light);
 }
 
 // Converts a slab block_id into it's corresponding double slab block_id. Will
@@ -0,0 +1,360 @@
+#include <algorithm>
+
+// The functions in this file work on boxes of voxels. A box is given by the
+// coordinates of it's first voxel and it's size along each axis, and may
+// reach outside of the world, in which case it is clipped to the bounds of
+// the world. Voxels in columns that are not resident are skipped.
+//
+// Each function walks the box one section at a time, and the voxels inside of
+// each section in the order that they are stored in (X first, then Y, then
+// Z), instead of looking up the section of every voxel separately. The 
+// heightmap is updated once per section.
+
+// Call function(section_x, section_y, section_z, x0, y0, z0, x1, y1, z1) for
+// every resident section that a box of a world touches. The voxels of the box
+// that are inside of the section are the ones from (x0, y0, z0) up to, but
+// not including, (x1, y1, z1).
+
+template <typename F>
+void for_each_section_in_box(world* the_world, int x, int y, int z, int x_res, int y_res, int z_res, F function)
+{
+	int x0 = std::max(x, 0);
+	int y0 = std::max(y, 0);
+	int z0 = std::max(z, 0);
+
+	int x1 = std::min(x + x_res, int(the_world->x_res));
+	int y1 = std::min(y + y_res, int(the_world->y_res));
+	int z1 = std::min(z + z_res, int(the_world->z_res));
+
+	if (x0 >= x1 || y0 >= y1 || z0 >= z1)
+	{
+		return;
+	}
+
+	for (int sz = z0 & ~15; sz < z1; sz += 16)
+	for (int sy = y0 & ~15; sy < y1; sy += 16)
+	for (int sx = x0 & ~15; sx < x1; sx += 16)
+	{
+		if (!the_world->column_resident(sx, sz))
+		{
+			continue;
+		}
+
+		function
+		(
+			sx, sy, sz,
+
+			std::max(x0, sx),
+			std::max(y0, sy),
+			std::max(z0, sz),
+
+			std::min(x1, sx + 16),
+			std::min(y1, sy + 16),
+			std::min(z1, sz + 16)
+		);
+	}
+}
+
+// Set the block_id information of every voxel in part of a section* to the
+// specified palette index. Rows that span the whole section are merged into
+// longer runs.
+
+inline void fill_section_runs(world* the_world, section* the_section, int x0, int y0, int z0, int x1, int y1, int z1, unsigned int entry)
+{
+	if (x1 - x0 == 16 && y1 - y0 == 16)
+	{
+		the_section->fill_run(the_world->local_index(0, 0, z0), 256 * (z1 - z0), entry);
+	}
+	else if (x1 - x0 == 16)
+	{
+		for (int cz = z0; cz < z1; cz++)
+		{
+			the_section->fill_run(the_world->local_index(0, y0, cz), 16 * (y1 - y0), entry);
+		}
+	}
+	else
+	{
+		for (int cz = z0; cz < z1; cz++)
+		for (int cy = y0; cy < y1; cy++)
+		{
+			the_section->fill_run(the_world->local_index(x0, cy, cz), x1 - x0, entry);
+		}
+	}
+}
+
+// Set the block_id information of every voxel in a box of a world. Sections
+// that are completely covered by the box become uniform.
+
+void fill_box(world* out, int x, int y, int z, int x_res, int y_res, int z_res, block_id id)
+{
+	for_each_section_in_box(out, x, y, z, x_res, y_res, z_res, [&](int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1)
+	{
+		section* the_section = out->section_at(sx, sy, sz);
+
+		if (the_section->bits == 0 && the_section->uniform_id == id)
+		{
+			return;
+		}
+
+		the_section = out->writable_section_at(sx, sy, sz);
+
+		if (x1 - x0 == 16 && y1 - y0 == 16 && z1 - z0 == 16)
+		{
+			the_section->fill(id);
+		}
+		else
+		{
+			fill_section_runs(out, the_section, x0, y0, z0, x1, y1, z1, the_section->palette_entry(id));
+		}
+
+		out->update_heights_in_box(x0, y0, z0, x1, y1, z1);
+	});
+}
+
+// Replace from with to in part of a section* that is not uniform.
+
+inline void replace_entry_in_section(world* out, int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1, block_id from, block_id to, bool whole_section)
+{
+	section* the_section = out->section_at(sx, sy, sz);
+
+	// Find the palette index of from.
+
+	unsigned int from_entry = 0;
+
+	while (from_entry < the_section->palette_size && the_section->palette[from_entry] != from)
+	{
+		from_entry++;
+	}
+
+	if (from_entry == the_section->palette_size)
+	{
+		return;
+	}
+
+	the_section = out->writable_section_at(sx, sy, sz);
+
+	if (whole_section)
+	{
+		// If to is not in the palette yet, from's palette entry can just
+		// be changed into to.
+
+		unsigned int to_entry = 0;
+
+		while (to_entry < the_section->palette_size && the_section->palette[to_entry] != to)
+		{
+			to_entry++;
+		}
+
+		if (to_entry == the_section->palette_size)
+		{
+			the_section->palette[from_entry] = to;
+		}
+		else
+		{
+			the_section->replace_entry(from_entry, to_entry);
+		}
+
+		return;
+	}
+
+	unsigned int to_entry = the_section->palette_entry(to);
+
+	for (int cz = z0; cz < z1; cz++)
+	for (int cy = y0; cy < y1; cy++)
+	for (int cx = x0; cx < x1; cx++)
+	{
+		unsigned int i = out->local_index(cx, cy, cz);
+
+		if (the_section->get_index(i) == from_entry)
+		{
+			the_section->set_index(i, to_entry);
+		}
+	}
+}
+
+// Replace the block_id information of every voxel in a box of a world that is
+// equal to from with to. Sections that do not contain from are skipped, and
+// sections that are completely covered by the box only have their palette
+// changed.
+
+void replace_in_box(world* out, int x, int y, int z, int x_res, int y_res, int z_res, block_id from, block_id to)
+{
+	if (from == to)
+	{
+		return;
+	}
+
+	// The heightmap only changes if from and to are not alike.
+
+	bool same_heights = (from == id_air) == (to == id_air) && is_not_permeable_light(from) == is_not_permeable_light(to);
+
+	for_each_section_in_box(out, x, y, z, x_res, y_res, z_res, [&](int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1)
+	{
+		section* the_section = out->section_at(sx, sy, sz);
+
+		bool whole_section = x1 - x0 == 16 && y1 - y0 == 16 && z1 - z0 == 16;
+
+		// A uniform section of from is the same as a fill.
+
+		if (the_section->bits == 0)
+		{
+			if (the_section->uniform_id != from)
+			{
+				return;
+			}
+
+			the_section = out->writable_section_at(sx, sy, sz);
+
+			if (whole_section)
+			{
+				the_section->fill(to);
+			}
+			else
+			{
+				fill_section_runs(out, the_section, x0, y0, z0, x1, y1, z1, the_section->palette_entry(to));
+			}
+		}
+		else
+		{
+			replace_entry_in_section(out, sx, sy, sz, x0, y0, z0, x1, y1, z1, from, to, whole_section);
+		}
+
+		if (!same_heights)
+		{
+			out->update_heights_in_box(x0, y0, z0, x1, y1, z1);
+		}
+	});
+}
+
+// Copy the voxels (including their lighting information) of a box of a world
+// that starts at (from_x, from_y, from_z) into a box of another world that
+// starts at (x, y, z). If both worlds are the same, the boxes must not
+// overlap. Voxels that are out of bounds in either world are skipped.
+//
+// Whole sections that line up in both worlds are not copied at all. Instead,
+// the section is shared, and copied later if one of the worlds changes it.
+
+void copy_box(world* in, int from_x, int from_y, int from_z, world* out, int x, int y, int z, int x_res, int y_res, int z_res)
+{
+	int offset_x = from_x - x;
+	int offset_y = from_y - y;
+	int offset_z = from_z - z;
+
+	bool aligned = (offset_x & 15) == 0 && (offset_y & 15) == 0 && (offset_z & 15) == 0;
+
+	for_each_section_in_box(out, x, y, z, x_res, y_res, z_res, [&](int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1)
+	{
+		if
+		(
+			aligned && x1 - x0 == 16 && y1 - y0 == 16 && z1 - z0 == 16 &&
+
+			in->in_bounds(sx + offset_x, sy + offset_y, sz + offset_z) &&
+			in->in_bounds(sx + offset_x + 15, sy + offset_y + 15, sz + offset_z + 15)
+		)
+		{
+			section*& target = out->sections[out->section_index(sx, sy, sz)];
+
+			section* source = in->section_at(sx + offset_x, sy + offset_y, sz + offset_z);
+
+			if (target != source)
+			{
+				source->references.fetch_add(1, std::memory_order_relaxed);
+
+				release_section(target);
+
+				target = source;
+			}
+
+			out->update_heights_in_box(x0, y0, z0, x1, y1, z1);
+
+			return;
+		}
+
+		section* the_section = out->writable_section_at(sx, sy, sz);
+
+		for (int cz = z0; cz < z1; cz++)
+		for (int cy = y0; cy < y1; cy++)
+		for (int cx = x0; cx < x1; cx++)
+		{
+			if (!in->in_bounds(cx + offset_x, cy + offset_y, cz + offset_z))
+			{
+				continue;
+			}
+
+			voxel value = in->get(cx + offset_x, cy + offset_y, cz + offset_z);
+
+			unsigned int i = out->local_index(cx, cy, cz);
+
+			the_section->set_id(i, voxel_get_id(value));
+
+			the_section->set_natural(i, voxel_get_natural(value));
+
+			the_section->set_artificial(i, voxel_get_artificial(value));
+		}
+
+		out->update_heights_in_box(x0, y0, z0, x1, y1, z1);
+	});
+}
+
+// Call function(x, y, z, id) for every voxel in a box of a world, where id is
+// the voxel's block_id. The world is not changed, so this may be used on a
+// snapshot.
+
+template <typename F>
+void for_each_in_box(world* in, int x, int y, int z, int x_res, int y_res, int z_res, F function)
+{
+	unsigned short ids[4096];
+
+	for_each_section_in_box(in, x, y, z, x_res, y_res, z_res, [&](int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1)
+	{
+		in->section_at(sx, sy, sz)->get_ids(ids);
+
+		for (int cz = z0; cz < z1; cz++)
+		for (int cy = y0; cy < y1; cy++)
+		for (int cx = x0; cx < x1; cx++)
+		{
+			function(cx, cy, cz, block_id(ids[in->local_index(cx, cy, cz)]));
+		}
+	});
+}
+
+// Call function(x, y, z, id) for every voxel in a box of a world, where id is
+// the voxel's block_id, and set the voxel's block_id to the value it returns.
+// Each section that was changed is packed again once, after all of it's
+// voxels were visited.
+
+template <typename F>
+void transform_in_box(world* out, int x, int y, int z, int x_res, int y_res, int z_res, F function)
+{
+	unsigned short ids[4096];
+
+	for_each_section_in_box(out, x, y, z, x_res, y_res, z_res, [&](int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1)
+	{
+		out->section_at(sx, sy, sz)->get_ids(ids);
+
+		bool changed = false;
+
+		for (int cz = z0; cz < z1; cz++)
+		for (int cy = y0; cy < y1; cy++)
+		for (int cx = x0; cx < x1; cx++)
+		{
+			unsigned int i = out->local_index(cx, cy, cz);
+
+			block_id id = function(cx, cy, cz, block_id(ids[i]));
+
+			if (id != ids[i])
+			{
+				ids[i] = id;
+
+				changed = true;
+			}
+		}
+
+		if (changed)
+		{
+			out->writable_section_at(sx, sy, sz)->set_ids(ids);
+
+			out->update_heights_in_box(x0, y0, z0, x1, y1, z1);
+		}
+	});
+}
@@ -1,4 +1,160 @@
 #include <iostream>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+// The kinds of changes that can be recorded in a chunk. A voxel's block_id
+// can change (change_geometry), only it's lighting can change (change_light),
+// or a voxel in a neighboring chunk can change in a way that changes the 
+// faces of the voxel (change_neighbor).
+
+const unsigned char change_geometry = 1;
+const unsigned char change_light = 2;
+const unsigned char change_neighbor = 4;
+
+// The vertices of a chunk's meshes are uploaded to the GPU as packed_vertex
+// structs of 8 bytes each, instead of the 7 floats that the mesher writes.
+// Every value of a vertex is a small integer:
+//
+// position: X, Y and Z relative to the chunk (Y pointing down), in 1/16 of a
+// voxel (9 bits each, bits 0 to 26), the index of the face's lighting
+// coefficient (2 bits, bits 27 and 28), and whether the texture is animated
+// (bit 29).
+//
+// texture: U and V, in 1/16 of a voxel (9 bits each, bits 0 to 17), the
+// layer (8 bits, bits 18 to 25), and the light level (4 bits, bits 26 to
+// 29).
+//
+// The position of the chunk is passed to the block shader as a uniform.
+
+struct packed_vertex
+{
+	unsigned int position;
+
+	unsigned int texture;
+};
+
+// Pack a vertex that the mesher wrote for a chunk at the specified
+// coordinates into a packed_vertex.
+
+inline packed_vertex pack_vertex(float* vertex, unsigned int x, unsigned int y, unsigned int z)
+{
+	unsigned int px = lround((vertex[0] - float(x)) * 16.0f);
+	unsigned int py = lround((-vertex[1] - float(y)) * 16.0f);
+	unsigned int pz = lround((vertex[2] - float(z)) * 16.0f);
+
+	unsigned int u = lround(vertex[3] * 16.0f);
+	unsigned int v = lround(vertex[4] * 16.0f);
+
+	// Animated textures have a negative layer.
+
+	unsigned int animated = vertex[5] < 0.0f;
+
+	unsigned int layer = lround(fabs(vertex[5]));
+
+	// The lighting value is already packed, see face_lighting.
+
+	unsigned int lighting = lround(vertex[6]);
+
+	packed_vertex out;
+
+	out.position = px | py << 9 | pz << 18 | (lighting >> 4) << 27 | animated << 29;
+
+	out.texture = u | v << 9 | layer << 18 | (lighting & 15) << 26;
+
+	return out;
+}
+
+// Pack the vertices that the mesher wrote for a chunk at the specified
+// coordinates into packed_vertex structs. The mesher writes every face as a
+// quad of 4 vertices, which are drawn with the indices of the quad index
+// buffer. Returns the amount of quads.
+
+unsigned int pack_quads(float* vertices, unsigned int size_in_floats, unsigned int x, unsigned int y, unsigned int z, packed_vertex* out)
+{
+	unsigned int vertex_count = size_in_floats / 7;
+
+	for (unsigned int i = 0; i < vertex_count; i++)
+	{
+		out[i] = pack_vertex(vertices + i * 7, x, y, z);
+	}
+
+	return vertex_count / 4;
+}
+
+// Every chunk draws it's quads with the indices 0, 1, 2, 0, 2, 3 of each
+// quad, which are stored once in the quad index buffer. It grows when a
+// chunk has more quads than it holds indices for.
+
+GLuint quad_index_buffer = 0;
+
+unsigned int quad_index_buffer_quads = 0;
+
+// Bind the quad index buffer to the vertex array object that is bound to the
+// current state, after making sure that it holds the indices of at least
+// quad_count quads.
+
+void bind_quad_indices(unsigned int quad_count)
+{
+	if (quad_index_buffer == 0)
+	{
+		glGenBuffers(1, &quad_index_buffer);
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_index_buffer);
+
+	if (quad_count > quad_index_buffer_quads)
+	{
+		// The buffer is grown to at least twice it's size, so that it is
+		// not uploaded again for every chunk that is a little larger.
+
+		unsigned int new_quads = std::max(quad_count, quad_index_buffer_quads * 2);
+
+		std::vector<unsigned int> indices(size_t(new_quads) * 6);
+
+		for (unsigned int i = 0; i < new_quads; i++)
+		{
+			unsigned int* index = indices.data() + size_t(i) * 6;
+
+			index[0] = i * 4 + 0; index[1] = i * 4 + 1; index[2] = i * 4 + 2;
+			index[3] = i * 4 + 0; index[4] = i * 4 + 2; index[5] = i * 4 + 3;
+		}
+
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+		quad_index_buffer_quads = new_quads;
+	}
+}
+
+// Delete the quad index buffer from the GPU.
+
+void deallocate_quad_indices()
+{
+	if (quad_index_buffer != 0)
+	{
+		glDeleteBuffers(1, &quad_index_buffer);
+	}
+
+	quad_index_buffer = 0;
+
+	quad_index_buffer_quads = 0;
+}
+
+// Set up the vertex attributes of a packed_vertex for the vertex array object
+// that is bound to the current state.
+
+void set_packed_vertex_attributes()
+{
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(packed_vertex), (void*)offsetof(packed_vertex, position));
+
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(packed_vertex), (void*)offsetof(packed_vertex, texture));
+
+	glEnableVertexAttribArray(1);
+}
 
 // A chunk represents a subset of the world that has been loaded on to the 
 // GPU.
@@ -16,22 +172,96 @@ struct chunk
 	GLuint target_vao;
 	GLuint target_vbo;
 
-	unsigned int target_size_in_floats;
+	unsigned int target_quad_count;
 
 	GLuint water_target_vao;
 	GLuint water_target_vbo;
 
-	unsigned int water_target_size_in_floats;
+	unsigned int water_target_quad_count;
 
 	// When a block inside the region enclosed by a chunk changes, the chunk's
 	// modified flag is set to true.
 
 	bool modified;
+
+	// The kinds of changes that were made to the chunk since it was meshed,
+	// and which of it's voxels were changed, one bit per voxel in the order
+	// of world::local_index. They are used to skip meshing the chunk again
+	// when the changes can not change it's meshes (see chunk_needs_meshing).
+
+	unsigned char changes;
+
+	unsigned long long changed_voxels[64];
+
+	// The id of the job of a mesher that is meshing the chunk again, or 0.
+
+	unsigned long long mesh_job;
+
+	// Check if the voxel at the specified local index was changed since the
+	// chunk was meshed.
+
+	inline bool voxel_changed(unsigned int i)
+	{
+		return (changed_voxels[i >> 6] >> (i & 63)) & 1;
+	}
+
+	// Count the voxels that were changed since the chunk was meshed.
+
+	unsigned int changed_voxel_count()
+	{
+		unsigned int count = 0;
+
+		for (int i = 0; i < 64; i++)
+		{
+			for (unsigned long long word = changed_voxels[i]; word; word &= word - 1)
+			{
+				count++;
+			}
+		}
+
+		return count;
+	}
 };
 
-// Create a chunk* from a subset of a world.
+// A chunk_mesh holds the packed vertex arrays of a subset of a world, before
+// they are uploaded to the GPU. Creating a chunk_mesh only reads the world,
+// so chunk_meshes can be created on any thread, as long as the world is not
+// changed while they are (like a snapshot of the world). Only uploading them
+// has to happen on the thread that owns the OpenGL context.
 
-chunk* allocate_chunk
+struct chunk_mesh
+{
+	unsigned int x;
+	unsigned int y;
+	unsigned int z;
+
+	unsigned int x_res;
+	unsigned int y_res;
+	unsigned int z_res;
+
+	packed_vertex* target;
+
+	unsigned int target_quad_count;
+
+	packed_vertex* water_target;
+
+	unsigned int water_target_quad_count;
+};
+
+// The vertex arrays that the mesher writes to are reused by every chunk_mesh
+// that is created on the same thread, instead of allocating them for each
+// chunk_mesh. They are not initialized, so only the part of them that the
+// mesher writes to is ever touched.
+
+thread_local std::unique_ptr<float[]> chunk_mesh_target;
+
+thread_local std::unique_ptr<float[]> chunk_mesh_water_target;
+
+thread_local size_t chunk_mesh_target_size = 0;
+
+// Create a chunk_mesh* from a subset of a world.
+
+chunk_mesh* allocate_chunk_mesh
 (
 	world* input,
 
@@ -44,21 +274,25 @@ chunk* allocate_chunk
 	unsigned int z_res
 )
 {
-	// Allocate memory to hold the enclosed region's vertex arrays.
-
-	float* target = (float*)malloc(x_res * y_res * z_res * 6 * 2 * 2 * 3 * 7 * sizeof(float));
-
-	float* water_target = (float*)malloc(x_res * y_res * z_res * 4 * 2 * 2 * 3 * 7 * sizeof(float));
+	// Make sure that the vertex arrays of this thread can hold the enclosed
+	// region's vertices. A voxel has at most 12 quads (fire), and a water
+	// voxel at most 6.
 
-	int Time_On_End = SDL_GetTicks();
+	size_t target_size = size_t(x_res) * y_res * z_res * 12 * 4 * 7;
 
-	if (!target || !water_target)
+	if (chunk_mesh_target_size < target_size)
 	{
-		std::cout << "Could not allocate enough memory for a new chunk." << std::endl;
+		chunk_mesh_target.reset(new float[target_size]);
 
-		exit(14);
+		chunk_mesh_water_target.reset(new float[size_t(x_res) * y_res * z_res * 6 * 4 * 7]);
+
+		chunk_mesh_target_size = target_size;
 	}
 
+	float* target = chunk_mesh_target.get();
+
+	float* water_target = chunk_mesh_water_target.get();
+
 	// Generate the enclosed region's vertex arrays.
 
 	unsigned int target_size_in_floats;
@@ -69,24 +303,82 @@ chunk* allocate_chunk
 
 	world_subset_to_water_mesh(input, x, y, z, x_res, y_res, z_res, water_target, water_target_size_in_floats);
 
+	// Pack the vertex arrays into quads.
+
+	packed_vertex* packed_target = (packed_vertex*)malloc((target_size_in_floats / 7) * sizeof(packed_vertex) + 1);
+
+	packed_vertex* packed_water_target = (packed_vertex*)malloc((water_target_size_in_floats / 7) * sizeof(packed_vertex) + 1);
+
+	if (!packed_target || !packed_water_target)
+	{
+		std::cout << "Could not allocate enough memory for a new chunk." << std::endl;
+
+		exit(14);
+	}
+
+	// Create the chunk_mesh*.
+
+	chunk_mesh* the_mesh = new chunk_mesh();
+
+	the_mesh->x = x;
+	the_mesh->y = y;
+	the_mesh->z = z;
+
+	the_mesh->x_res = x_res;
+	the_mesh->y_res = y_res;
+	the_mesh->z_res = z_res;
+
+	the_mesh->target = packed_target;
+
+	the_mesh->target_quad_count = pack_quads(target, target_size_in_floats, x, y, z, packed_target);
+
+	the_mesh->water_target = packed_water_target;
+
+	the_mesh->water_target_quad_count = pack_quads(water_target, water_target_size_in_floats, x, y, z, packed_water_target);
+
+	return the_mesh;
+}
+
+// Deallocate a chunk_mesh*.
+
+void deallocate_chunk_mesh(chunk_mesh* to_be_annihilated)
+{
+	free(to_be_annihilated->target);
+
+	free(to_be_annihilated->water_target);
+
+	delete to_be_annihilated;
+}
+
+// Create a chunk* by uploading a chunk_mesh* to the GPU. The chunk_mesh* is
+// not deallocated.
+
+chunk* allocate_chunk(chunk_mesh* the_mesh)
+{
 	// Create the chunk*.
 
 	chunk* the_chunk = new chunk();
 
-	the_chunk->x = x;
-	the_chunk->y = y;
-	the_chunk->z = z;
+	the_chunk->x = the_mesh->x;
+	the_chunk->y = the_mesh->y;
+	the_chunk->z = the_mesh->z;
 
-	the_chunk->x_res = x_res;
-	the_chunk->y_res = y_res;
-	the_chunk->z_res = z_res;
+	the_chunk->x_res = the_mesh->x_res;
+	the_chunk->y_res = the_mesh->y_res;
+	the_chunk->z_res = the_mesh->z_res;
 
-	the_chunk->target_size_in_floats = target_size_in_floats;
+	the_chunk->target_quad_count = the_mesh->target_quad_count;
 
-	the_chunk->water_target_size_in_floats = water_target_size_in_floats;
+	the_chunk->water_target_quad_count = the_mesh->water_target_quad_count;
 
 	the_chunk->modified = false;
 
+	the_chunk->changes = 0;
+
+	memset(the_chunk->changed_voxels, 0, sizeof(the_chunk->changed_voxels));
+
+	the_chunk->mesh_job = 0;
+
 	{
 		// Generate a target_vao and a target_vbo to reference the vertex data
 		// of the enclosed region after it is uploaded to the GPU.
@@ -106,25 +398,14 @@ chunk* allocate_chunk
 
 		// Upload the target vertex data to the GPU.
 
-		glBufferData(GL_ARRAY_BUFFER, target_size_in_floats * sizeof(float), target, GL_STATIC_DRAW);
-
-		// Free the enclosed region's vertex data from the CPU.
+		glBufferData(GL_ARRAY_BUFFER, the_mesh->target_quad_count * 4 * sizeof(packed_vertex), the_mesh->target, GL_STATIC_DRAW);
 
-		free(target);
+		// Enable the packed vertex attributes, and bind the quad index
+		// buffer to the target_vao.
 
-		// Enable the default vertex attributes.
+		set_packed_vertex_attributes();
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(0 * sizeof(float)));
-
-		glEnableVertexAttribArray(0);
-
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
-
-		glEnableVertexAttribArray(1);
-
-		glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(6 * sizeof(float)));
-
-		glEnableVertexAttribArray(2);
+		bind_quad_indices(the_mesh->target_quad_count);
 
 		// Unbind the target_vao and the target_vbo from the current state.
 
@@ -159,25 +440,14 @@ chunk* allocate_chunk
 
 		// Upload the water_target vertex data to the GPU.
 
-		glBufferData(GL_ARRAY_BUFFER, water_target_size_in_floats * sizeof(float), water_target, GL_STATIC_DRAW);
-
-		// Free the enclosed region's water vertex data from the CPU.
-
-		free(water_target);
-
-		// Enable the default vertex attributes.
+		glBufferData(GL_ARRAY_BUFFER, the_mesh->water_target_quad_count * 4 * sizeof(packed_vertex), the_mesh->water_target, GL_STATIC_DRAW);
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(0 * sizeof(float)));
+		// Enable the packed vertex attributes, and bind the quad index
+		// buffer to the water_target_vao.
 
-		glEnableVertexAttribArray(0);
+		set_packed_vertex_attributes();
 
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
-
-		glEnableVertexAttribArray(1);
-
-		glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(6 * sizeof(float)));
-
-		glEnableVertexAttribArray(2);
+		bind_quad_indices(the_mesh->water_target_quad_count);
 
 		// Unbind the water_target_vao and the water_target_vbo from the 
 		// current state.
@@ -197,6 +467,30 @@ chunk* allocate_chunk
 	return the_chunk;
 }
 
+// Create a chunk* from a subset of a world.
+
+chunk* allocate_chunk
+(
+	world* input,
+
+	unsigned int x,
+	unsigned int y,
+	unsigned int z,
+
+	unsigned int x_res,
+	unsigned int y_res,
+	unsigned int z_res
+)
+{
+	chunk_mesh* the_mesh = allocate_chunk_mesh(input, x, y, z, x_res, y_res, z_res);
+
+	chunk* the_chunk = allocate_chunk(the_mesh);
+
+	deallocate_chunk_mesh(the_mesh);
+
+	return the_chunk;
+}
+
 // Deallocate a chunk*.
 
 void deallocate_chunk(chunk* to_be_annihilated)
@@ -207,24 +501,172 @@ void deallocate_chunk(chunk* to_be_annihilated)
 
 	glDeleteBuffers(1, &to_be_annihilated->target_vbo);
 
+	// Delete the water_target_vao and the water_target_vbo from the GPU.
+
+	glDeleteVertexArrays(1, &to_be_annihilated->water_target_vao);
+
+	glDeleteBuffers(1, &to_be_annihilated->water_target_vbo);
+
 	// Delete the pointer to the chunk.
 
 	delete to_be_annihilated;
 }
 
-// Render a chunk*.
+// Set the modified flag of the chunk that holds the voxel at the specified 
+// coordinates, and record the voxel and the kind of change, if the voxel is
+// within the bounds of the world and the chunk exists. The chunks must be 
+// ordered like the sections of the world.
+
+inline void mark_chunk_modified(world* the_world, chunk** the_chunks, unsigned int x, unsigned int y, unsigned int z, unsigned char change)
+{
+	if (!the_world->in_bounds(x, y, z))
+	{
+		return;
+	}
+
+	chunk* the_chunk = the_chunks[the_world->section_index(x, y, z)];
+
+	if (the_chunk)
+	{
+		unsigned int i = the_world->local_index(x, y, z);
+
+		the_chunk->changed_voxels[i >> 6] |= 1ull << (i & 63);
+
+		the_chunk->changes |= change;
+
+		the_chunk->modified = true;
+	}
+}
+
+// Record a change to the lighting of the voxel at the specified coordinates.
+// The faces of the voxel's neighbors are lit by the voxel, so if it is on 
+// the border of it's chunk, the neighboring chunks are marked as well. Light
+// spreads into the columns around an edit, so if the world's lighting is
+// saved, the voxel's column is marked as modified too, otherwise saving only
+// the modified columns would lose it.
+
+inline void mark_chunk_light_modified(world* the_world, chunk** the_chunks, unsigned int x, unsigned int y, unsigned int z)
+{
+	if (the_world->generator == generated_by_world)
+	{
+		the_world->columns_modified[the_world->column_slot(x, z)] = true;
+	}
+
+	mark_chunk_modified(the_world, the_chunks, x, y, z, change_light);
+
+	if ((x & 15) == 0)
+	{
+		mark_chunk_modified(the_world, the_chunks, x - 1, y, z, change_neighbor);
+	}
+
+	if ((x & 15) == 15)
+	{
+		mark_chunk_modified(the_world, the_chunks, x + 1, y, z, change_neighbor);
+	}
+
+	if ((y & 15) == 0)
+	{
+		mark_chunk_modified(the_world, the_chunks, x, y - 1, z, change_neighbor);
+	}
+
+	if ((y & 15) == 15)
+	{
+		mark_chunk_modified(the_world, the_chunks, x, y + 1, z, change_neighbor);
+	}
+
+	if ((z & 15) == 0)
+	{
+		mark_chunk_modified(the_world, the_chunks, x, y, z - 1, change_neighbor);
+	}
+
+	if ((z & 15) == 15)
+	{
+		mark_chunk_modified(the_world, the_chunks, x, y, z + 1, change_neighbor);
+	}
+}
+
+// Set the modified flag of the chunk that holds the voxel at the specified
+// coordinates, and record every voxel of the chunk as changed, if the voxel
+// is within the bounds of the world and the chunk exists.
+
+inline void mark_whole_chunk_modified(world* the_world, chunk** the_chunks, unsigned int x, unsigned int y, unsigned int z, unsigned char change)
+{
+	if (!the_world->in_bounds(x, y, z))
+	{
+		return;
+	}
+
+	chunk* the_chunk = the_chunks[the_world->section_index(x, y, z)];
+
+	if (the_chunk)
+	{
+		memset(the_chunk->changed_voxels, 0xff, sizeof(the_chunk->changed_voxels));
+
+		the_chunk->changes |= change;
+
+		the_chunk->modified = true;
+	}
+}
+
+// Check if the changes recorded in a chunk* since it was meshed can change
+// it's meshes. A change to a neighboring chunk only changes the faces of the
+// voxels that it marked, on the border of the chunk, so if the chunk has only
+// recorded such changes and every marked voxel is id_air, which has no faces,
+// the chunk does not need to be meshed again.
+
+bool chunk_needs_meshing(world* the_world, chunk* the_chunk)
+{
+	if (the_chunk->changes != change_neighbor)
+	{
+		return true;
+	}
+
+	section* the_section = the_world->section_at(the_chunk->x, the_chunk->y, the_chunk->z);
+
+	for (unsigned int i = 0; i < 4096; i++)
+	{
+		// Words without a marked voxel are skipped whole.
+
+		if (the_chunk->changed_voxels[i >> 6] == 0)
+		{
+			i |= 63;
+
+			continue;
+		}
+
+		if (the_chunk->voxel_changed(i) && the_section->get_id(i) != id_air)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Pass the position of a chunk* to the chunk_offset uniform of the block
+// shader program, at the specified uniform location.
 
-void render_chunk(chunk* the_chunk)
+inline void set_chunk_offset(chunk* the_chunk, GLint chunk_offset_location)
 {
-	if (the_chunk->target_size_in_floats > 0)
+	glUniform3f(chunk_offset_location, float(the_chunk->x), -float(the_chunk->y), float(the_chunk->z));
+}
+
+// Render a chunk*. The chunk_offset uniform of the block shader program is
+// at chunk_offset_location.
+
+void render_chunk(chunk* the_chunk, GLint chunk_offset_location)
+{
+	if (the_chunk->target_quad_count > 0)
 	{
+		set_chunk_offset(the_chunk, chunk_offset_location);
+
 		// Bind the target_vao to the current state.
 
 		glBindVertexArray(the_chunk->target_vao);
 
-		// Draw the vertex array object as an array of triangles.
+		// Draw the vertex array object as two triangles per quad.
 
-		glDrawArrays(GL_TRIANGLES, 0, the_chunk->target_size_in_floats / 7);
+		glDrawElements(GL_TRIANGLES, the_chunk->target_quad_count * 6, GL_UNSIGNED_INT, (void*)0);
 
 		// Unbind the target_vao from the current state.
 
@@ -232,19 +674,22 @@ void render_chunk(chunk* the_chunk)
 	}
 }
 
-// Render a chunk*'s water vertex array.
+// Render a chunk*'s water vertex array. The chunk_offset uniform of the
+// block shader program is at chunk_offset_location.
 
-void render_chunk_water(chunk* the_chunk)
+void render_chunk_water(chunk* the_chunk, GLint chunk_offset_location)
 {
-	if (the_chunk->water_target_size_in_floats > 0)
+	if (the_chunk->water_target_quad_count > 0)
 	{
+		set_chunk_offset(the_chunk, chunk_offset_location);
+
 		// Bind the water_target_vao to the current state.
 
 		glBindVertexArray(the_chunk->water_target_vao);
 
-		// Draw the water vertex array object as an array of triangles.
+		// Draw the water vertex array object as two triangles per quad.
 
-		glDrawArrays(GL_TRIANGLES, 0, the_chunk->water_target_size_in_floats / 7);
+		glDrawElements(GL_TRIANGLES, the_chunk->water_target_quad_count * 6, GL_UNSIGNED_INT, (void*)0);
 
 		// Unbind the water_target_vao from the current state.
 
@@ -0,0 +1,353 @@
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+// The functions in this file compress and decompress blocks of bytes, such as
+// the columns that are stored in region files. The codec is meant to be fast
+// rather than to compress as well as possible.
+//
+// Compressed data starts with the size and the Adler-32 checksum of the
+// decompressed data (as two unsigned ints), followed by a list of operations. Each operation starts with
+// a byte whose lowest 2 bits hold the kind of the operation, and whose other 6
+// bits hold a length. If the length is 63, a variable length integer follows,
+// which is added to the length. The kinds of operations are:
+//
+//     compress_literal    copy length + 1 bytes that follow the operation
+//     compress_run        repeat the byte that follows the operation length +
+//                         min_run times
+//     compress_match      copy length + min_match bytes from a distance (a
+//                         variable length integer that follows the operation)
+//                         back in the decompressed data
+//
+// A variable length integer is stored 7 bits at a time, lowest bits first, and
+// the highest bit of each byte is set if more bytes follow.
+
+const unsigned char compress_literal = 0;
+const unsigned char compress_run = 1;
+const unsigned char compress_match = 2;
+
+const unsigned int min_run = 4;
+const unsigned int min_match = 4;
+
+// The amount of bits of the hash table that compress_bytes uses to find
+// matches.
+
+const unsigned int compress_hash_bits = 14;
+
+// Calculate the Adler-32 checksum of a block of bytes. The operations can
+// not tell if a bit of a literal was flipped, so decompress_bytes compares
+// the checksum of it's output with the one that compress_bytes stored.
+
+inline unsigned int checksum_bytes(const unsigned char* data, size_t size)
+{
+	unsigned int a = 1;
+	unsigned int b = 0;
+
+	while (size > 0)
+	{
+		// The sums are reduced every 5552 bytes, the most that b can take
+		// without overflowing.
+
+		size_t block = std::min<size_t>(size, 5552);
+
+		for (size_t i = 0; i < block; i++)
+		{
+			a += data[i];
+
+			b += a;
+		}
+
+		a %= 65521;
+		b %= 65521;
+
+		data += block;
+
+		size -= block;
+	}
+
+	return b << 16 | a;
+}
+
+// Append a variable length integer to a std::string.
+
+inline void put_varint(std::string& out, unsigned long long value)
+{
+	while (value >= 0x80)
+	{
+		out += char((value & 0x7f) | 0x80);
+
+		value >>= 7;
+	}
+
+	out += char(value);
+}
+
+// Read a variable length integer from a std::string, starting at position i.
+// Returns false if the integer is cut off or too long.
+
+inline bool get_varint(const std::string& in, size_t& i, unsigned long long& value)
+{
+	value = 0;
+
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		if (i >= in.size())
+		{
+			return false;
+		}
+
+		unsigned char byte = in[i++];
+
+		value |= (unsigned long long)(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Append an operation to a std::string.
+
+inline void put_operation(std::string& out, unsigned char kind, unsigned long long length)
+{
+	if (length < 63)
+	{
+		out += char((length << 2) | kind);
+	}
+	else
+	{
+		out += char((63 << 2) | kind);
+
+		put_varint(out, length - 63);
+	}
+}
+
+// Hash the 4 bytes at the specified address.
+
+inline unsigned int compress_hash(const unsigned char* data)
+{
+	unsigned int word;
+
+	memcpy(&word, data, sizeof(word));
+
+	return (word * 2654435761u) >> (32 - compress_hash_bits);
+}
+
+// Compress a block of bytes.
+
+std::string compress_bytes(const std::string& in)
+{
+	const unsigned char* data = (const unsigned char*)in.data();
+
+	size_t size = in.size();
+
+	std::string out;
+
+	unsigned int raw_size = size;
+
+	unsigned int checksum = checksum_bytes(data, size);
+
+	out.append((char*)&raw_size, sizeof(raw_size));
+
+	out.append((char*)&checksum, sizeof(checksum));
+
+	// The hash table holds the position (plus one) of the last 4 bytes that
+	// had each hash.
+
+	std::vector<unsigned int> last_position(1 << compress_hash_bits, 0);
+
+	size_t literal_start = 0;
+
+	size_t i = 0;
+
+	// Write the bytes from literal_start up to (but not including) i as a
+	// literal operation.
+
+	auto flush_literal = [&]()
+	{
+		if (i > literal_start)
+		{
+			put_operation(out, compress_literal, i - literal_start - 1);
+
+			out.append(in, literal_start, i - literal_start);
+		}
+	};
+
+	while (i < size)
+	{
+		// Runs of the same byte are the most common pattern, and the
+		// cheapest to find.
+
+		size_t run = 1;
+
+		while (i + run < size && data[i + run] == data[i])
+		{
+			run++;
+		}
+
+		if (run >= min_run)
+		{
+			flush_literal();
+
+			put_operation(out, compress_run, run - min_run);
+
+			out += char(data[i]);
+
+			i += run;
+
+			literal_start = i;
+
+			continue;
+		}
+
+		// Look for an earlier copy of the next 4 bytes.
+
+		if (i + 4 <= size)
+		{
+			unsigned int hash = compress_hash(data + i);
+
+			size_t candidate = last_position[hash];
+
+			last_position[hash] = i + 1;
+
+			if (candidate != 0)
+			{
+				candidate--;
+
+				size_t length = 0;
+
+				while (i + length < size && data[candidate + length] == data[i + length])
+				{
+					length++;
+				}
+
+				if (length >= min_match)
+				{
+					flush_literal();
+
+					put_operation(out, compress_match, length - min_match);
+
+					put_varint(out, i - candidate);
+
+					i += length;
+
+					literal_start = i;
+
+					continue;
+				}
+			}
+		}
+
+		i++;
+	}
+
+	flush_literal();
+
+	return out;
+}
+
+// Decompress a block of bytes that was compressed with compress_bytes.
+// Returns false if the compressed data is corrupt.
+
+bool decompress_bytes(const std::string& in, std::string& out)
+{
+	unsigned int raw_size;
+
+	unsigned int checksum;
+
+	if (in.size() < sizeof(raw_size) + sizeof(checksum))
+	{
+		return false;
+	}
+
+	memcpy(&raw_size, in.data(), sizeof(raw_size));
+
+	memcpy(&checksum, in.data() + sizeof(raw_size), sizeof(checksum));
+
+	// The decompressed data is appended to out, instead of allocating
+	// raw_size bytes up front, so a corrupt size can not allocate more
+	// memory than the operations actually produce.
+
+	out.clear();
+
+	out.reserve(std::min<size_t>(raw_size, in.size() * 16));
+
+	size_t i = sizeof(raw_size) + sizeof(checksum);
+
+	while (i < in.size())
+	{
+		unsigned char operation = in[i++];
+
+		unsigned char kind = operation & 3;
+
+		unsigned long long length = operation >> 2;
+
+		if (length == 63)
+		{
+			unsigned long long extra;
+
+			if (!get_varint(in, i, extra))
+			{
+				return false;
+			}
+
+			length += extra;
+		}
+
+		if (kind == compress_literal)
+		{
+			length += 1;
+
+			if (length > in.size() - i || length > raw_size - out.size())
+			{
+				return false;
+			}
+
+			out.append(in, i, length);
+
+			i += length;
+		}
+		else if (kind == compress_run)
+		{
+			length += min_run;
+
+			if (i >= in.size() || length > raw_size - out.size())
+			{
+				return false;
+			}
+
+			out.append(length, in[i++]);
+		}
+		else if (kind == compress_match)
+		{
+			length += min_match;
+
+			unsigned long long distance;
+
+			if (!get_varint(in, i, distance) || distance == 0 || distance > out.size() || length > raw_size - out.size())
+			{
+				return false;
+			}
+
+			// The copy may overlap the bytes it writes, so it is done one
+			// byte at a time.
+
+			size_t from = out.size() - distance;
+
+			for (unsigned long long j = 0; j < length; j++)
+			{
+				out += out[from + j];
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return out.size() == raw_size && checksum_bytes((const unsigned char*)out.data(), out.size()) == checksum;
+}
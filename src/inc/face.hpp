@@ -18,6 +18,23 @@ struct face_info
 
 	float l_back;
 
+	// Blocks without a face_info use layer -1 for every face.
+
+	face_info()
+	{
+		l_top = -1.0f;
+
+		l_bottom = -1.0f;
+
+		l_left = -1.0f;
+
+		l_right = -1.0f;
+
+		l_front = -1.0f;
+
+		l_back = -1.0f;
+	}
+
 	face_info(float _l_top, float _l_bottom, float _l_left, float _l_right, float _l_front, float _l_back)
 	{
 		l_top = _l_top;
@@ -34,64 +51,68 @@ struct face_info
 	}
 };
 
-// Generates a face_info* where each all of the six faces correspond to the
+// Generates a face_info where each all of the six faces correspond to the
 // same layer.
 
-face_info* make_face_info_all(float all)
+face_info make_face_info_all(float all)
 {
-	return new face_info(all, all, all, all, all, all);
+	return face_info(all, all, all, all, all, all);
 }
 
-// Generates a face_info* that uses cap for the top and bottom faces, and uses
+// Generates a face_info that uses cap for the top and bottom faces, and uses
 // side for the remaining four faces.
 
-face_info* make_face_info_cap(float cap, float side)
+face_info make_face_info_cap(float cap, float side)
 {
-	return new face_info(cap, cap, side, side, side, side);
+	return face_info(cap, cap, side, side, side, side);
 }
 
-// Generates a face_info* that uses top for the top face, uses bottom for the
+// Generates a face_info that uses top for the top face, uses bottom for the
 // bottom face, and uses side for the remaining four faces.
 
-face_info* make_face_info_caps(float top, float bottom, float side)
+face_info make_face_info_caps(float top, float bottom, float side)
 {
-	return new face_info(top, bottom, side, side, side, side);
+	return face_info(top, bottom, side, side, side, side);
 }
 
-// Generates a face_info* that uses side_1 for the front and back faces, 
+// Generates a face_info that uses side_1 for the front and back faces, 
 // side_2 for the left and right faces, uses bottom for the bottom face, and
 // top for the top face.
 
-face_info* make_face_info_bench(float top, float bottom, float side_1, float side_2)
+face_info make_face_info_bench(float top, float bottom, float side_1, float side_2)
 {
-	return new face_info(top, bottom, side_2, side_2, side_1, side_1);
+	return face_info(top, bottom, side_2, side_2, side_1, side_1);
 }
 
-// Generates a face_info* that uses side_1 for the front face, side_2 for the 
+// Generates a face_info that uses side_1 for the front face, side_2 for the 
 // left, right and back faces, and cap for the top and bottom faces.
 
-face_info* make_face_info_table(float cap, float side_1, float side_2)
+face_info make_face_info_table(float cap, float side_1, float side_2)
 {
-	return new face_info(cap, cap, side_2, side_2, side_1, side_2);
+	return face_info(cap, cap, side_2, side_2, side_1, side_2);
 }
 
-// Generates a face_info* that uses side_1 for the front face, side_2 for the 
+// Generates a face_info that uses side_1 for the front face, side_2 for the 
 // left, right, bottom and back faces, and cap for the top face.
 
-face_info* make_face_info_block_food(float cap, float side_1, float side_2)
+face_info make_face_info_block_food(float cap, float side_1, float side_2)
 {
-	return new face_info(cap, side_2, side_2, side_2, side_1, side_2);
+	return face_info(cap, side_2, side_2, side_2, side_1, side_2);
 }
 
-// This function fills up block_face_info with a face_info* object for each
-// block_id. Call this function after calling load_block_texture_array, 
-// because this function uses block_name_to_layer as a lookup table.
+// This function fills up block_face_info with a face_info for each block_id.
+// Call this function after calling load_block_texture_array, because this 
+// function uses block_name_to_layer as a lookup table.
+//
+// block_face_info holds the face_info structs themselves, and has an entry 
+// for every value that a voxel's block_id can have, so the mesher looks up
+// the layers of a block with a single index and no pointer to follow.
 
-std::vector<face_info*> block_face_info;
+face_info block_face_info[256];
 
 void load_block_face_info_array()
 {
-	block_face_info = 
+	std::vector<face_info> face_infos =
 	{
 		make_face_info_all(-1.0f),
 
@@ -277,4 +298,9 @@ void load_block_face_info_array()
 
 		make_face_info_all(block_name_to_layer.at("fire_0"))
 	};
+
+	for (unsigned int i = 0; i < face_infos.size(); i++)
+	{
+		block_face_info[i] = face_infos[i];
+	}
 }
\ No newline at end of file
@@ -1,13 +1,232 @@
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <climits>
+#include <atomic>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// A mapped_file is a file whose contents are mapped into memory, so that they
+// can be read and written like an array. The operating system pages the file
+// in as it is read, and writes back only the pages that were changed.
+
+struct mapped_file
+{
+	unsigned char* data = nullptr;
+
+	size_t size = 0;
+
+	#ifdef _WIN32
+
+	HANDLE file = INVALID_HANDLE_VALUE;
+
+	HANDLE mapping = NULL;
+
+	#endif
+};
+
+// Map a file into memory. If writable is true, the file is created if it does
+// not exist yet and resized to size bytes. Otherwise, size is ignored and the
+// file's own size is used. Returns false if the file could not be mapped.
+
+bool map_file(mapped_file& the_file, std::string path, size_t size, bool writable)
+{
+	#ifdef _WIN32
+
+	the_file.file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL, writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (the_file.file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+
+	if (writable)
+	{
+		file_size.QuadPart = size;
+
+		if (!SetFilePointerEx(the_file.file, file_size, NULL, FILE_BEGIN) || !SetEndOfFile(the_file.file))
+		{
+			CloseHandle(the_file.file);
+
+			return false;
+		}
+	}
+	else if (!GetFileSizeEx(the_file.file, &file_size))
+	{
+		CloseHandle(the_file.file);
+
+		return false;
+	}
+
+	the_file.size = size_t(file_size.QuadPart);
+
+	// Empty files can not be mapped.
+
+	if (the_file.size == 0)
+	{
+		CloseHandle(the_file.file);
+
+		return false;
+	}
+
+	the_file.mapping = CreateFileMappingA(the_file.file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+
+	if (the_file.mapping == NULL)
+	{
+		CloseHandle(the_file.file);
+
+		return false;
+	}
+
+	the_file.data = (unsigned char*)MapViewOfFile(the_file.mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+
+	if (!the_file.data)
+	{
+		CloseHandle(the_file.mapping);
+
+		CloseHandle(the_file.file);
+
+		return false;
+	}
+
+	#else
+
+	int file = open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+
+	if (file < 0)
+	{
+		return false;
+	}
+
+	if (writable)
+	{
+		if (ftruncate(file, off_t(size)) != 0)
+		{
+			close(file);
+
+			return false;
+		}
+
+		the_file.size = size;
+	}
+	else
+	{
+		struct stat file_info;
+
+		if (fstat(file, &file_info) != 0)
+		{
+			close(file);
+
+			return false;
+		}
+
+		the_file.size = size_t(file_info.st_size);
+	}
+
+	// Empty files can not be mapped.
+
+	if (the_file.size == 0)
+	{
+		close(file);
+
+		return false;
+	}
+
+	void* data = mmap(nullptr, the_file.size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+
+	// The mapping keeps the file open by itself.
+
+	close(file);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	the_file.data = (unsigned char*)data;
+
+	#endif
+
+	return true;
+}
+
+// Unmap a mapped_file. If flush is true, the changed pages are written back
+// to the file before this returns.
+
+void unmap_file(mapped_file& the_file, bool flush)
+{
+	#ifdef _WIN32
+
+	if (flush)
+	{
+		FlushViewOfFile(the_file.data, 0);
+
+		FlushFileBuffers(the_file.file);
+	}
+
+	UnmapViewOfFile(the_file.data);
+
+	CloseHandle(the_file.mapping);
+
+	CloseHandle(the_file.file);
+
+	#else
+
+	if (flush)
+	{
+		msync(the_file.data, the_file.size, MS_SYNC);
+	}
+
+	munmap(the_file.data, the_file.size);
+
+	#endif
+
+	the_file.data = nullptr;
+
+	the_file.size = 0;
+}
+
+// The size of the header of a world file, which holds the world's size and
+// the player's coordinates.
+
+const size_t world_file_header_size = 3 * sizeof(unsigned int) + 3 * sizeof(float);
 
 // Save a world to a file.
+//
+// The file is mapped into memory, and each row of voxels is only written if
+// it differs from what the file already holds, so saving a world over it's
+// previous save only dirties (and writes back) the pages that changed.
 
 void save_world_to_file(world* in, float player_x, float player_y, float player_z, std::string path)
 {
-	std::ofstream out(path, std::ios::binary);
+	unsigned long long file_size = world_file_header_size + (unsigned long long)in->x_res * in->y_res * in->z_res * sizeof(voxel);
+
+	mapped_file the_file;
 
-	// Write the world's size to the output stream.
+	if (file_size > SIZE_MAX || !map_file(the_file, path, size_t(file_size), true))
+	{
+		std::cout << "Could not save a world to " << path << "." << std::endl;
+
+		return;
+	}
+
+	// Write the world's size and the player's coordinates to the header.
 
 	unsigned int size_data[3];
 
@@ -15,57 +234,1418 @@ void save_world_to_file(world* in, float player_x, float player_y, float player_
 	size_data[1] = in->y_res;
 	size_data[2] = in->z_res;
 
-	out.write((char*)size_data, sizeof(size_data));
-
-	// Write the player's coordinates to the output stream.
-
 	float player_coordinates[3];
 
 	player_coordinates[0] = player_x;
 	player_coordinates[1] = player_y;
 	player_coordinates[2] = player_z;
 
-	out.write((char*)player_coordinates, sizeof(player_coordinates));
+	memcpy(the_file.data, size_data, sizeof(size_data));
+
+	memcpy(the_file.data + sizeof(size_data), player_coordinates, sizeof(player_coordinates));
+
+	// Write the world's voxel data. The file always stores the voxels in flat
+	// X, Y, Z order, regardless of the layout that the world uses in memory,
+	// so each section is decoded once and it's rows are scattered into the
+	// file. The file stores 16-bit voxels, which only have room for 8-bit
+	// block_ids, unlike the region files.
+
+	voxel* voxels = (voxel*)(the_file.data + world_file_header_size);
+
+	unsigned short ids[4096];
+
+	unsigned char naturals[4096];
 
-	// Write the world's voxel data to the output stream.
+	unsigned char artificials[4096];
 
-	out.write((char*)in->voxels, in->x_res * in->y_res * in->z_res * sizeof(voxel));
+	voxel row[16];
 
-	// Close the output stream.
+	for_each_section_in_box(in, 0, 0, 0, in->x_res, in->y_res, in->z_res, [&](int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1)
+	{
+		section* the_section = in->section_at(sx, sy, sz);
 
-	out.close();
+		the_section->get_ids(ids);
+
+		the_section->get_naturals(naturals);
+
+		the_section->get_artificials(artificials);
+
+		for (int cz = z0; cz < z1; cz++)
+		for (int cy = y0; cy < y1; cy++)
+		{
+			for (int cx = x0; cx < x1; cx++)
+			{
+				unsigned int i = in->local_index(cx, cy, cz);
+
+				voxel_set_id(row[cx - x0], block_id(ids[i]));
+
+				voxel_set_artificial(row[cx - x0], artificials[i]);
+
+				voxel_set_natural(row[cx - x0], naturals[i]);
+			}
+
+			voxel* target = voxels + (size_t(cz) * in->y_res + cy) * in->x_res + x0;
+
+			if (memcmp(target, row, (x1 - x0) * sizeof(voxel)) != 0)
+			{
+				memcpy(target, row, (x1 - x0) * sizeof(voxel));
+			}
+		}
+	});
+
+	unmap_file(the_file, true);
 }
 
 // Load a world from a file.
+//
+// The file is mapped into memory, and each section is decoded straight from
+// the mapped rows and packed once, instead of setting every voxel on it's
+// own.
 
 void load_world_from_file(world*& out, float& player_x, float& player_y, float& player_z, std::string path)
 {
-	std::ifstream in(path, std::ios::binary);
+	mapped_file the_file;
 
-	// Read the world's size from the input stream.
+	if (!map_file(the_file, path, 0, false) || the_file.size < world_file_header_size)
+	{
+		std::cout << "Could not load a world from " << path << "." << std::endl;
 
-	unsigned int size_data[3];
+		exit(13);
+	}
 
-	in.read((char*)size_data, sizeof(size_data));
+	// Read the world's size and the player's coordinates from the header.
 
-	// Read the player's coordinates from the output stream.
+	unsigned int size_data[3];
 
 	float player_coordinates[3];
 
-	in.read((char*)player_coordinates, sizeof(player_coordinates));
+	memcpy(size_data, the_file.data, sizeof(size_data));
+
+	memcpy(player_coordinates, the_file.data + sizeof(size_data), sizeof(player_coordinates));
 
 	player_x = player_coordinates[0];
 	player_y = player_coordinates[1];
 	player_z = player_coordinates[2];
 
-	// Read the world's voxel data from the input stream after allocating a
-	// new world.
+	// Make sure that the file holds every voxel of a world of that size.
+
+	unsigned long long voxel_count = (unsigned long long)size_data[0] * size_data[1] * size_data[2];
+
+	if (the_file.size - world_file_header_size != voxel_count * sizeof(voxel))
+	{
+		std::cout << "Could not load a world from " << path << ", the file is corrupt." << std::endl;
+
+		exit(19);
+	}
+
+	// Read the world's voxel data after allocating a new world. Voxels of a
+	// section that are outside of the world are left as air.
 
 	out = allocate_world(size_data[0], size_data[1], size_data[2]);
 
-	in.read((char*)out->voxels, out->x_res * out->y_res * out->z_res * sizeof(voxel));
+	const voxel* voxels = (const voxel*)(the_file.data + world_file_header_size);
 
-	// Close the input stream.
+	unsigned short ids[4096];
 
-	in.close();
-}
\ No newline at end of file
+	unsigned char naturals[4096];
+
+	unsigned char artificials[4096];
+
+	#ifndef _WIN32
+
+	posix_madvise(the_file.data, the_file.size, POSIX_MADV_SEQUENTIAL);
+
+	#endif
+
+	for_each_section_in_box(out, 0, 0, 0, out->x_res, out->y_res, out->z_res, [&](int sx, int sy, int sz, int x0, int y0, int z0, int x1, int y1, int z1)
+	{
+		std::fill(ids, ids + 4096, (unsigned short)id_air);
+
+		memset(naturals, 0, sizeof(naturals));
+
+		memset(artificials, 0, sizeof(artificials));
+
+		for (int cz = z0; cz < z1; cz++)
+		for (int cy = y0; cy < y1; cy++)
+		{
+			const voxel* row = voxels + (size_t(cz) * out->y_res + cy) * out->x_res;
+
+			for (int cx = x0; cx < x1; cx++)
+			{
+				unsigned int i = out->local_index(cx, cy, cz);
+
+				ids[i] = voxel_get_id(row[cx]);
+
+				naturals[i] = voxel_get_natural(row[cx]);
+
+				artificials[i] = voxel_get_artificial(row[cx]);
+			}
+		}
+
+		section* the_section = out->writable_section_at(sx, sy, sz);
+
+		the_section->set_ids(ids);
+
+		the_section->set_naturals(naturals);
+
+		the_section->set_artificials(artificials);
+	});
+
+	unmap_file(the_file, false);
+
+	// Build the heightmap of every column.
+
+	for (unsigned int z = 0; z < out->z_res; z += 16)
+	for (unsigned int x = 0; x < out->x_res; x += 16)
+	{
+		out->update_heights_in_box(x, 0, z, std::min(x + 16, out->x_res), out->y_res, std::min(z + 16, out->z_res));
+	}
+}
+
+// Check if there is a file (and not a directory) at path.
+
+bool is_file(std::string path)
+{
+	#ifdef _WIN32
+
+	DWORD attributes = GetFileAttributesA(path.c_str());
+
+	return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+
+	#else
+
+	struct stat file_info;
+
+	return stat(path.c_str(), &file_info) == 0 && S_ISREG(file_info.st_mode);
+
+	#endif
+}
+
+// Check if there is a file or a directory at path.
+
+bool path_exists(std::string path)
+{
+	#ifdef _WIN32
+
+	return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+
+	#else
+
+	struct stat file_info;
+
+	return stat(path.c_str(), &file_info) == 0;
+
+	#endif
+}
+
+// Create a directory, if it does not exist yet.
+
+void make_directory(std::string path)
+{
+	#ifdef _WIN32
+
+	_mkdir(path.c_str());
+
+	#else
+
+	mkdir(path.c_str(), 0755);
+
+	#endif
+}
+
+// Write data to the file at path. The data is written to a temporary file,
+// which is flushed to the disk and then renamed over the file at path, so the
+// file at path always holds either it's old or it's new contents, even if the
+// game crashes while it is written. Returns false if the file could not be
+// written.
+
+bool write_file_atomically(std::string path, const std::string& data)
+{
+	std::string temporary_path = path + ".tmp";
+
+	#ifdef _WIN32
+
+	HANDLE file = CreateFileA(temporary_path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	size_t written = 0;
+
+	while (written < data.size())
+	{
+		DWORD chunk_size = DWORD(std::min<size_t>(data.size() - written, 1 << 30));
+
+		DWORD chunk_written;
+
+		if (!WriteFile(file, data.data() + written, chunk_size, &chunk_written, NULL))
+		{
+			break;
+		}
+
+		written += chunk_written;
+	}
+
+	bool flushed = FlushFileBuffers(file) != 0;
+
+	CloseHandle(file);
+
+	if (written != data.size() || !flushed)
+	{
+		DeleteFileA(temporary_path.c_str());
+
+		return false;
+	}
+
+	return MoveFileExA(temporary_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+
+	#else
+
+	int file = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (file < 0)
+	{
+		return false;
+	}
+
+	size_t written = 0;
+
+	while (written < data.size())
+	{
+		ssize_t chunk_written = write(file, data.data() + written, data.size() - written);
+
+		if (chunk_written <= 0)
+		{
+			break;
+		}
+
+		written += chunk_written;
+	}
+
+	bool flushed = fsync(file) == 0;
+
+	close(file);
+
+	if (written != data.size() || !flushed)
+	{
+		unlink(temporary_path.c_str());
+
+		return false;
+	}
+
+	return rename(temporary_path.c_str(), path.c_str()) == 0;
+
+	#endif
+}
+
+// Write size bytes of data to the existing file at path, starting at offset,
+// and flush them to the disk before returning, so that they are on the disk
+// before anything that is written after them. Returns false if the data
+// could not be written.
+
+bool write_to_file(std::string path, unsigned long long offset, const char* data, size_t size)
+{
+	#ifdef _WIN32
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER position;
+
+	position.QuadPart = offset;
+
+	size_t written = 0;
+
+	if (SetFilePointerEx(file, position, NULL, FILE_BEGIN))
+	{
+		while (written < size)
+		{
+			DWORD chunk_size = DWORD(std::min<size_t>(size - written, 1 << 30));
+
+			DWORD chunk_written;
+
+			if (!WriteFile(file, data + written, chunk_size, &chunk_written, NULL))
+			{
+				break;
+			}
+
+			written += chunk_written;
+		}
+	}
+
+	bool flushed = FlushFileBuffers(file) != 0;
+
+	CloseHandle(file);
+
+	return written == size && flushed;
+
+	#else
+
+	int file = open(path.c_str(), O_WRONLY);
+
+	if (file < 0)
+	{
+		return false;
+	}
+
+	size_t written = 0;
+
+	while (written < size)
+	{
+		ssize_t chunk_written = pwrite(file, data + written, size - written, offset + written);
+
+		if (chunk_written <= 0)
+		{
+			break;
+		}
+
+		written += chunk_written;
+	}
+
+	bool flushed = fsync(file) == 0;
+
+	close(file);
+
+	return written == size && flushed;
+
+	#endif
+}
+
+// Write the block_ids of the column that holds the voxel at the specified X 
+// and Z coordinates to an output stream. Each section is written as it's 
+// palette and it's packed indices. The lighting information is not written,
+// because it is propagated again when the column is read.
+
+void write_column(world* in, unsigned int x, unsigned int z, std::ostream& out)
+{
+	for (unsigned int y = 0; y < in->y_res; y += 16)
+	{
+		section* the_section = in->section_at(x, y, z);
+
+		// Write the amount of bits per index, and the size of the palette (or
+		// the block_id of a uniform section).
+
+		unsigned int header[2];
+
+		header[0] = the_section->bits;
+
+		header[1] = the_section->bits == 0 ? the_section->uniform_id : the_section->palette_size;
+
+		out.write((char*)header, sizeof(header));
+
+		if (the_section->bits != 0)
+		{
+			out.write((char*)the_section->palette, the_section->palette_size * sizeof(unsigned short));
+
+			out.write((char*)the_section->indices, 4096 * the_section->bits / 8);
+		}
+	}
+}
+
+// Read the block_ids of the column that holds the voxel at the specified X and
+// Z coordinates from an input stream. The column must be resident, and it's
+// sections must be uniform. Returns false if the data is corrupt, in which
+// case the column is left partly read (see clear_column).
+
+bool read_column(world* out, unsigned int x, unsigned int z, std::istream& in)
+{
+	for (unsigned int y = 0; y < out->y_res; y += 16)
+	{
+		section* the_section = out->writable_section_at(x, y, z);
+
+		unsigned int header[2];
+
+		in.read((char*)header, sizeof(header));
+
+		unsigned int bits = header[0];
+
+		if (!in.good())
+		{
+			return false;
+		}
+
+		if (bits == 0)
+		{
+			if (header[1] >= id_null)
+			{
+				return false;
+			}
+
+			the_section->uniform_id = header[1];
+
+			continue;
+		}
+
+		// Make sure that the section is valid before it is read.
+
+		if ((bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16) || header[1] > (1u << bits) || header[1] == 0)
+		{
+			return false;
+		}
+
+		the_section->repack(bits);
+
+		the_section->palette_size = header[1];
+
+		in.read((char*)the_section->palette, the_section->palette_size * sizeof(unsigned short));
+
+		in.read((char*)the_section->indices, 4096 * bits / 8);
+
+		if (!in.good() || !the_section->valid())
+		{
+			return false;
+		}
+	}
+
+	// Build the heightmap of the column.
+
+	unsigned int x0 = x & ~15u;
+	unsigned int z0 = z & ~15u;
+
+	out->update_heights_in_box(x0, 0, z0, std::min(x0 + 16, out->x_res), out->y_res, std::min(z0 + 16, out->z_res));
+
+	return true;
+}
+
+// Write the lighting information of the column that holds the voxel at the
+// specified X and Z coordinates to an output stream. Each lighting array of
+// each section is written as a 0 and it's value if it is uniform, or as a 1
+// and it's 2048 bytes of 4-bit values if it is not.
+
+void write_column_lighting(world* in, unsigned int x, unsigned int z, std::ostream& out)
+{
+	for (unsigned int y = 0; y < in->y_res; y += 16)
+	{
+		section* the_section = in->section_at(x, y, z);
+
+		unsigned char* arrays[2] = {the_section->natural, the_section->artificial};
+
+		unsigned char uniforms[2] = {the_section->natural_uniform, the_section->artificial_uniform};
+
+		for (int i = 0; i < 2; i++)
+		{
+			char header[2];
+
+			header[0] = arrays[i] ? 1 : 0;
+
+			header[1] = uniforms[i];
+
+			out.write(header, sizeof(header));
+
+			if (arrays[i])
+			{
+				out.write((char*)arrays[i], 2048);
+			}
+		}
+	}
+}
+
+// Read the lighting information of the column that holds the voxel at the
+// specified X and Z coordinates from an input stream. The column must have
+// been read by read_column. Returns false if the data is corrupt.
+
+bool read_column_lighting(world* out, unsigned int x, unsigned int z, std::istream& in)
+{
+	for (unsigned int y = 0; y < out->y_res; y += 16)
+	{
+		section* the_section = out->writable_section_at(x, y, z);
+
+		unsigned char** arrays[2] = {&the_section->natural, &the_section->artificial};
+
+		unsigned char* uniforms[2] = {&the_section->natural_uniform, &the_section->artificial_uniform};
+
+		for (int i = 0; i < 2; i++)
+		{
+			unsigned char header[2];
+
+			in.read((char*)header, sizeof(header));
+
+			if (!in.good() || header[0] > 1 || header[1] > 15)
+			{
+				return false;
+			}
+
+			if (header[0] == 0)
+			{
+				free(*arrays[i]);
+
+				*arrays[i] = nullptr;
+
+				*uniforms[i] = header[1];
+			}
+			else
+			{
+				if (!*arrays[i])
+				{
+					*arrays[i] = allocate_nibbles(0);
+				}
+
+				in.read((char*)*arrays[i], 2048);
+			}
+		}
+	}
+
+	return in.good();
+}
+
+// Get the compressed data of the column that holds the voxel at the specified
+// X and Z coordinates. If lighting is true, the lighting information of the
+// column is included.
+
+std::string write_column_data(world* in, unsigned int x, unsigned int z, bool lighting)
+{
+	std::ostringstream out;
+
+	write_column(in, x, z, out);
+
+	if (lighting)
+	{
+		write_column_lighting(in, x, z, out);
+	}
+
+	return compress_bytes(out.str());
+}
+
+// Read the column that holds the voxel at the specified X and Z coordinates
+// from data that was returned by write_column_data. The column must be
+// resident, and it's sections must be uniform. Returns false if the data is
+// corrupt, in which case every voxel of the column is set back to id_air.
+
+bool read_column_data(world* out, unsigned int x, unsigned int z, const std::string& data, bool lighting)
+{
+	std::string raw_data;
+
+	bool read = decompress_bytes(data, raw_data);
+
+	if (read)
+	{
+		std::istringstream in(raw_data);
+
+		read = read_column(out, x, z, in) && (!lighting || read_column_lighting(out, x, z, in));
+	}
+
+	if (!read)
+	{
+		std::cout << "Could not read a column, the column data is corrupt." << std::endl;
+
+		clear_column(out, x, z);
+	}
+
+	return read;
+}
+
+// A region file stores the columns of a 32x32 group of columns. It starts
+// with a region_header, which holds the offset (from the start of the file)
+// and the size of the compressed data of each column, followed by the data of
+// the columns in any order. A column with an offset of 0 has not been saved.
+// Columns are compressed on their own, so that one column can be read or
+// written without touching the rest of the region.
+
+const unsigned int region_res = 32;
+
+const unsigned int region_columns = region_res * region_res;
+
+const unsigned int region_magic = 0x4752434d;
+
+const unsigned int region_version = 2;
+
+// If the flags of a region file include region_lighting, the data of it's
+// columns includes their lighting information.
+
+const unsigned int region_lighting = 1;
+
+// A region file is rewritten without it's unused bytes once it is larger than
+// this, and more than half of it is unused.
+
+const unsigned long long region_compact_size = 1024 * 1024;
+
+struct region_header
+{
+	unsigned int magic;
+
+	unsigned int version;
+
+	unsigned int flags;
+
+	unsigned int offsets[region_columns];
+
+	unsigned int sizes[region_columns];
+};
+
+// Get the path of the region file that stores the column that holds the voxel
+// at the specified X and Z coordinates, inside of the level directory at
+// path_to_level.
+
+std::string region_path(std::string path_to_level, unsigned int x, unsigned int z)
+{
+	return path_to_level + "/r." + std::to_string((x >> 4) / region_res) + "." + std::to_string((z >> 4) / region_res);
+}
+
+// Get the index of the column that holds the voxel at the specified X and Z
+// coordinates in the header of it's region file.
+
+inline unsigned int region_index(unsigned int x, unsigned int z)
+{
+	return (x >> 4) % region_res + region_res * ((z >> 4) % region_res);
+}
+
+// Check that a region_header belongs to a region file of file_size bytes, and
+// that the data of every column lies inside of the file.
+
+bool region_header_valid(const region_header& header, unsigned long long file_size)
+{
+	if (header.magic != region_magic || header.version != region_version)
+	{
+		return false;
+	}
+
+	for (unsigned int i = 0; i < region_columns; i++)
+	{
+		if (header.offsets[i] != 0 && (header.offsets[i] < sizeof(region_header) || (unsigned long long)header.offsets[i] + header.sizes[i] > file_size))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Write a whole region file, through write_file_atomically. Each element of
+// columns is the compressed data of the column with that index, or empty if
+// the column has not been saved. Returns false if the file could not be
+// written.
+
+bool write_region_file(std::string path, unsigned int flags, const std::vector<std::string>& columns)
+{
+	region_header* header = new region_header();
+
+	header->magic = region_magic;
+
+	header->version = region_version;
+
+	header->flags = flags;
+
+	unsigned long long offset = sizeof(region_header);
+
+	for (unsigned int i = 0; i < region_columns; i++)
+	{
+		if (!columns[i].empty())
+		{
+			header->offsets[i] = offset;
+
+			header->sizes[i] = columns[i].size();
+
+			offset += columns[i].size();
+		}
+	}
+
+	if (offset > UINT_MAX)
+	{
+		delete header;
+
+		return false;
+	}
+
+	std::string data;
+
+	data.reserve(offset);
+
+	data.append((char*)header, sizeof(region_header));
+
+	for (unsigned int i = 0; i < region_columns; i++)
+	{
+		data.append(columns[i]);
+	}
+
+	delete header;
+
+	return write_file_atomically(path, data);
+}
+
+// Read the header and the compressed data of every column of a region file.
+// Columns that have not been saved are left empty. Returns false if the file
+// does not exist.
+
+bool read_region_file(std::string path, unsigned int& flags, std::vector<std::string>& columns)
+{
+	mapped_file the_file;
+
+	if (!map_file(the_file, path, 0, false))
+	{
+		return false;
+	}
+
+	region_header* header = (region_header*)the_file.data;
+
+	if (the_file.size < sizeof(region_header) || !region_header_valid(*header, the_file.size))
+	{
+		std::cout << "Could not read a region from " << path << ", the file is corrupt." << std::endl;
+
+		exit(19);
+	}
+
+	flags = header->flags;
+
+	columns.assign(region_columns, std::string());
+
+	for (unsigned int i = 0; i < region_columns; i++)
+	{
+		if (header->offsets[i] != 0)
+		{
+			columns[i].assign((char*)the_file.data + header->offsets[i], header->sizes[i]);
+		}
+	}
+
+	unmap_file(the_file, false);
+
+	return true;
+}
+
+// Write the compressed data of the column with the specified index to a
+// region file, creating the file with the specified flags if it does not
+// exist yet. The data is appended to the file and flushed to the disk before
+// the header is changed to point at it, so the column's previous data is
+// kept until the new data is complete, even if the game crashes while it is
+// written. Returns false if the file could not be written.
+
+bool write_region_column(std::string path, unsigned int index, const std::string& data, unsigned int flags)
+{
+	if (!path_exists(path))
+	{
+		std::vector<std::string> columns(region_columns);
+
+		columns[index] = data;
+
+		return write_region_file(path, flags, columns);
+	}
+
+	std::ifstream in(path, std::ios::binary);
+
+	if (!in.good() || !is_file(path))
+	{
+		return false;
+	}
+
+	region_header* header = new region_header();
+
+	in.read((char*)header, sizeof(region_header));
+
+	in.seekg(0, std::ios::end);
+
+	unsigned long long file_size = (unsigned long long)in.tellg();
+
+	if (!in.good() || !region_header_valid(*header, file_size))
+	{
+		std::cout << "Could not read a region from " << path << ", the file is corrupt." << std::endl;
+
+		delete header;
+
+		return false;
+	}
+
+	in.close();
+
+	unsigned long long offset = file_size;
+
+	if (offset + data.size() > UINT_MAX || !write_to_file(path, offset, data.data(), data.size()))
+	{
+		delete header;
+
+		return false;
+	}
+
+	header->offsets[index] = offset;
+
+	header->sizes[index] = data.size();
+
+	bool written = write_to_file(path, 0, (char*)header, sizeof(region_header));
+
+	// Every write leaves the column's previous data unused, so the file is
+	// rewritten once most of it is unused.
+
+	unsigned long long used_size = sizeof(region_header);
+
+	for (unsigned int i = 0; i < region_columns; i++)
+	{
+		used_size += header->sizes[i];
+	}
+
+	flags = header->flags;
+
+	delete header;
+
+	file_size = offset + data.size();
+
+	if (written && file_size > region_compact_size && file_size > used_size * 2)
+	{
+		std::vector<std::string> columns;
+
+		read_region_file(path, flags, columns);
+
+		written = write_region_file(path, flags, columns);
+	}
+
+	return written;
+}
+
+// Read the compressed data of the column with the specified index from a
+// region file, without reading the rest of the file. Returns false if the
+// file does not exist or is corrupt, or the column has not been saved.
+
+bool read_region_column(std::string path, unsigned int index, unsigned int& flags, std::string& data)
+{
+	std::ifstream in(path, std::ios::binary);
+
+	if (!in.good())
+	{
+		return false;
+	}
+
+	region_header* header = new region_header();
+
+	in.read((char*)header, sizeof(region_header));
+
+	in.seekg(0, std::ios::end);
+
+	unsigned long long file_size = (unsigned long long)in.tellg();
+
+	if (!in.good() || !region_header_valid(*header, file_size))
+	{
+		std::cout << "Could not read a region from " << path << ", the file is corrupt." << std::endl;
+
+		delete header;
+
+		return false;
+	}
+
+	unsigned int offset = header->offsets[index];
+
+	unsigned int size = header->sizes[index];
+
+	flags = header->flags;
+
+	delete header;
+
+	if (offset == 0)
+	{
+		return false;
+	}
+
+	data.resize(size);
+
+	in.seekg(offset);
+
+	in.read(&data[0], size);
+
+	return in.good();
+}
+
+// Get the path of the file that stores the column that holds the voxel at 
+// the specified X and Z coordinates, inside of the level directory at 
+// path_to_level.
+
+std::string column_path(std::string path_to_level, unsigned int x, unsigned int z)
+{
+	return path_to_level + "/c." + std::to_string(x >> 4) + "." + std::to_string(z >> 4);
+}
+
+// Save the column that holds the voxel at the specified X and Z coordinates to
+// it's region file in the level directory at path_to_level. Returns false if
+// the column could not be saved.
+
+bool save_column_to_file(world* in, unsigned int x, unsigned int z, std::string path_to_level)
+{
+	if (!write_region_column(region_path(path_to_level, x, z), region_index(x, z), write_column_data(in, x, z, false), 0))
+	{
+		std::cout << "Could not save a column to " << path_to_level << "." << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Load the column that holds the voxel at the specified X and Z coordinates 
+// from the level directory at path_to_level. Returns false if the column has
+// not been saved yet, or if it's data is corrupt (the column is then left
+// empty, see read_column_data).
+
+bool load_column_from_file(world* out, unsigned int x, unsigned int z, std::string path_to_level)
+{
+	unsigned int flags;
+
+	std::string data;
+
+	if (read_region_column(region_path(path_to_level, x, z), region_index(x, z), flags, data))
+	{
+		return read_column_data(out, x, z, data, flags & region_lighting);
+	}
+
+	// Levels that were saved before region files were used store each column
+	// in it's own uncompressed file.
+
+	std::ifstream in(column_path(path_to_level, x, z), std::ios::binary);
+
+	if (!in.good())
+	{
+		return false;
+	}
+
+	if (!read_column(out, x, z, in))
+	{
+		std::cout << "Could not read a column, the column data is corrupt." << std::endl;
+
+		clear_column(out, x, z);
+
+		return false;
+	}
+
+	in.close();
+
+	return true;
+}
+
+// Save the information of a world that is not stored in it's columns to the
+// level directory at path_to_level. The x_res and z_res of a streaming world
+// are saved as 0. The generator tells how the world's columns were generated,
+// as in world::generator.
+
+void save_level_info(std::string path_to_level, unsigned int seed, unsigned int generator, unsigned int x_res, unsigned int y_res, unsigned int z_res, float player_x, float player_y, float player_z)
+{
+	make_directory(path_to_level);
+
+	std::ostringstream out;
+
+	// Write the world's seed and height to the output stream.
+
+	unsigned int world_data[2];
+
+	world_data[0] = seed;
+	world_data[1] = y_res;
+
+	out.write((char*)world_data, sizeof(world_data));
+
+	// Write the player's coordinates to the output stream.
+
+	float player_coordinates[3];
+
+	player_coordinates[0] = player_x;
+	player_coordinates[1] = player_y;
+	player_coordinates[2] = player_z;
+
+	out.write((char*)player_coordinates, sizeof(player_coordinates));
+
+	// Write the world's width and depth to the output stream. They were added
+	// after the other fields, so that older level directories still load as
+	// streaming worlds.
+
+	unsigned int size_data[2];
+
+	size_data[0] = x_res;
+	size_data[1] = z_res;
+
+	out.write((char*)size_data, sizeof(size_data));
+
+	// Write the world's generator to the output stream.
+
+	out.write((char*)&generator, sizeof(generator));
+
+	write_file_atomically(path_to_level + "/level.dat", out.str());
+}
+
+// Load the information of a world that is not stored in it's columns from the
+// level directory at path_to_level. The x_res and z_res of a streaming world
+// are loaded as 0. Returns false if there is no level directory at
+// path_to_level.
+
+bool load_level_info(std::string path_to_level, unsigned int& seed, unsigned int& generator, unsigned int& x_res, unsigned int& y_res, unsigned int& z_res, float& player_x, float& player_y, float& player_z)
+{
+	std::ifstream in(path_to_level + "/level.dat", std::ios::binary);
+
+	if (!in.good())
+	{
+		return false;
+	}
+
+	// Read the world's seed and height from the input stream.
+
+	unsigned int world_data[2];
+
+	in.read((char*)world_data, sizeof(world_data));
+
+	seed = world_data[0];
+	y_res = world_data[1];
+
+	// Read the player's coordinates from the input stream.
+
+	float player_coordinates[3];
+
+	in.read((char*)player_coordinates, sizeof(player_coordinates));
+
+	player_x = player_coordinates[0];
+	player_y = player_coordinates[1];
+	player_z = player_coordinates[2];
+
+	// Read the world's width and depth from the input stream.
+
+	unsigned int size_data[2] = {0, 0};
+
+	in.read((char*)size_data, sizeof(size_data));
+
+	x_res = in.good() ? size_data[0] : 0;
+	z_res = in.good() ? size_data[1] : 0;
+
+	// Read the world's generator from the input stream. Level directories
+	// that were saved before it was added have a streaming world, whose
+	// columns were always generated one at a time, or a world that was
+	// generated by generate_world.
+
+	unsigned int generator_data;
+
+	in.read((char*)&generator_data, sizeof(generator_data));
+
+	if (in.good())
+	{
+		generator = generator_data;
+	}
+	else
+	{
+		generator = x_res == 0 ? generated_by_column : generated_by_world;
+	}
+
+	in.close();
+
+	return true;
+}
+
+// Replace the world file at path_to_level with the level directory that was
+// saved to path_to_level + ".new". The world file is moved aside to
+// path_to_level + ".old" first, and only removed once the level directory is
+// in place, so one of the three paths always holds the whole world, even if
+// the game crashes in between (see recover_level). Returns false if the
+// level directory could not be moved into place, in which case the world file
+// is moved back.
+
+bool replace_world_file(std::string path_to_level)
+{
+	std::string new_path = path_to_level + ".new";
+	std::string old_path = path_to_level + ".old";
+
+	// A world file that is left at old_path was already replaced once, by an
+	// earlier level directory.
+
+	std::remove(old_path.c_str());
+
+	if (std::rename(path_to_level.c_str(), old_path.c_str()) != 0)
+	{
+		return false;
+	}
+
+	if (std::rename(new_path.c_str(), path_to_level.c_str()) != 0)
+	{
+		std::rename(old_path.c_str(), path_to_level.c_str());
+
+		return false;
+	}
+
+	std::remove(old_path.c_str());
+
+	return true;
+}
+
+// Finish a replace_world_file of the world at path_to_level that was cut off
+// by a crash. The world file is only moved aside once the level directory is
+// complete, so if there is nothing at path_to_level but the world file was
+// moved aside, the level directory is moved into place (or the world file is
+// moved back, if the level directory is gone). A world file that was left
+// behind once the level directory was in place is removed. This should be
+// called before the world at path_to_level is loaded.
+
+void recover_level(std::string path_to_level)
+{
+	std::string new_path = path_to_level + ".new";
+	std::string old_path = path_to_level + ".old";
+
+	if (!path_exists(old_path))
+	{
+		return;
+	}
+
+	if (!path_exists(path_to_level))
+	{
+		if (path_exists(new_path) && std::rename(new_path.c_str(), path_to_level.c_str()) == 0)
+		{
+			std::remove(old_path.c_str());
+		}
+		else
+		{
+			std::rename(old_path.c_str(), path_to_level.c_str());
+		}
+	}
+	else if (!is_file(path_to_level))
+	{
+		std::remove(old_path.c_str());
+	}
+}
+
+// Save the columns of a world that were modified since it was last saved to
+// (or loaded from) the level directory at path_to_level, in place of their
+// previous data in their region files. Columns of a world that was generated by
+// generate_column are saved without their lighting information, because
+// loading such a world propagates it's lighting again anyway. Returns false
+// if a column could not be saved.
+
+bool save_modified_columns(world* in, std::string path_to_level)
+{
+	bool lighting = in->generator == generated_by_world;
+
+	unsigned int slot_count = in->window_x_res * in->window_z_res;
+
+	std::vector<unsigned int> slots;
+
+	for (unsigned int i = 0; i < slot_count; i++)
+	{
+		if (in->columns[i] != no_column && in->columns_modified[i])
+		{
+			slots.push_back(i);
+		}
+	}
+
+	// Compress the columns in parallel, and then write them one at a time.
+
+	std::vector<std::string> column_data(slots.size());
+
+	run_in_parallel(slots.size(), [&](size_t i)
+	{
+		unsigned int column = in->columns[slots[i]];
+
+		column_data[i] = write_column_data(in, (column % in->chunk_x_res) * 16, (column / in->chunk_x_res) * 16, lighting);
+	});
+
+	for (size_t i = 0; i < slots.size(); i++)
+	{
+		unsigned int column = in->columns[slots[i]];
+
+		unsigned int x = (column % in->chunk_x_res) * 16;
+		unsigned int z = (column / in->chunk_x_res) * 16;
+
+		if (!write_region_column(region_path(path_to_level, x, z), region_index(x, z), column_data[i], lighting ? region_lighting : 0))
+		{
+			std::cout << "Could not save a world to " << path_to_level << "." << std::endl;
+
+			return false;
+		}
+
+		in->columns_modified[slots[i]] = false;
+	}
+
+	return true;
+}
+
+// Save a world to the level directory at path_to_level, as one region file
+// per 32x32 group of columns. The lighting information is saved too, so that
+// it does not have to be propagated again when the world is loaded. Every
+// column is no longer marked as modified afterwards. Returns false if the
+// world could not be saved.
+//
+// If the world was generated by generate_column, only the seed and the
+// columns that were modified since they were generated are saved, because
+// the other columns can be generated again.
+//
+// If path_to_level is a world file that was saved by save_world_to_file, it is
+// replaced by the level directory.
+
+bool save_world_to_level(world* in, unsigned int seed, float player_x, float player_y, float player_z, std::string path_to_level)
+{
+	std::string path = path_to_level;
+
+	bool replace_file = is_file(path_to_level);
+
+	if (replace_file)
+	{
+		path = path_to_level + ".new";
+	}
+
+	save_level_info(path, seed, in->generator, in->x_res, in->y_res, in->z_res, player_x, player_y, player_z);
+
+	if (in->generator == generated_by_column && !replace_file)
+	{
+		return save_modified_columns(in, path);
+	}
+
+	// Compress every column in parallel. Each column is compressed on it's
+	// own, so the region files do not depend on the amount of threads.
+
+	std::vector<std::string> column_data(size_t(in->chunk_x_res) * in->chunk_z_res);
+
+	run_in_parallel(column_data.size(), [&](size_t i)
+	{
+		column_data[i] = write_column_data(in, (i % in->chunk_x_res) * 16, (i / in->chunk_x_res) * 16, true);
+	});
+
+	for (unsigned int rz = 0; rz < in->chunk_z_res; rz += region_res)
+	for (unsigned int rx = 0; rx < in->chunk_x_res; rx += region_res)
+	{
+		std::vector<std::string> columns(region_columns);
+
+		for (unsigned int cz = rz; cz < std::min(rz + region_res, in->chunk_z_res); cz++)
+		for (unsigned int cx = rx; cx < std::min(rx + region_res, in->chunk_x_res); cx++)
+		{
+			columns[region_index(cx * 16, cz * 16)] = std::move(column_data[cx + size_t(in->chunk_x_res) * cz]);
+		}
+
+		if (!write_region_file(region_path(path, rx * 16, rz * 16), region_lighting, columns))
+		{
+			std::cout << "Could not save a world to " << path_to_level << "." << std::endl;
+
+			return false;
+		}
+	}
+
+	if (replace_file && !replace_world_file(path_to_level))
+	{
+		std::cout << "Could not save a world to " << path_to_level << "." << std::endl;
+
+		return false;
+	}
+
+	memset(in->columns_modified, 0, (size_t)in->window_x_res * in->window_z_res * sizeof(bool));
+
+	return true;
+}
+
+// Save the columns of a world that were modified since it was last saved to
+// (or loaded from) the level directory at path_to_level. Each column is
+// written in place of it's previous data in it's region file, so the cost of a save
+// depends on the amount of modified columns instead of the size of the world.
+//
+// If path_to_level is a world file that was saved by save_world_to_file, the
+// whole world is saved by save_world_to_level instead. Returns false if the
+// world could not be saved.
+
+bool save_modified_columns_to_level(world* in, unsigned int seed, float player_x, float player_y, float player_z, std::string path_to_level)
+{
+	if (is_file(path_to_level))
+	{
+		return save_world_to_level(in, seed, player_x, player_y, player_z, path_to_level);
+	}
+
+	save_level_info(path_to_level, seed, in->generator, in->x_res, in->y_res, in->z_res, player_x, player_y, player_z);
+
+	return save_modified_columns(in, path_to_level);
+}
+
+// Load a world of the specified size from the level directory at
+// path_to_level. If the world was generated by generate_column, the columns
+// that were not saved are generated again from the seed. If any column was
+// saved without it's lighting information, the lighting of the whole world is
+// propagated again.
+
+void load_world_from_level(world*& out, std::string path_to_level, unsigned int seed, unsigned int generator, unsigned int x_res, unsigned int y_res, unsigned int z_res)
+{
+	out = allocate_world(x_res, y_res, z_res);
+
+	out->generator = generator;
+
+	bool lit = true;
+
+	// Read every region file, and keep the compressed data of each column
+	// and whether it has it's lighting information.
+
+	size_t column_count = size_t(out->chunk_x_res) * out->chunk_z_res;
+
+	std::vector<std::string> column_data(column_count);
+
+	std::vector<bool> column_lighting(column_count);
+
+	for (unsigned int rz = 0; rz < out->chunk_z_res; rz += region_res)
+	for (unsigned int rx = 0; rx < out->chunk_x_res; rx += region_res)
+	{
+		unsigned int flags = 0;
+
+		std::vector<std::string> columns;
+
+		if (!read_region_file(region_path(path_to_level, rx * 16, rz * 16), flags, columns))
+		{
+			if (generator != generated_by_column)
+			{
+				std::cout << "Could not load a world from " << path_to_level << "." << std::endl;
+
+				exit(13);
+			}
+
+			// None of the region's columns were modified.
+
+			columns.assign(region_columns, std::string());
+		}
+
+		for (unsigned int cz = rz; cz < std::min(rz + region_res, out->chunk_z_res); cz++)
+		for (unsigned int cx = rx; cx < std::min(rx + region_res, out->chunk_x_res); cx++)
+		{
+			size_t i = cx + size_t(out->chunk_x_res) * cz;
+
+			column_data[i] = std::move(columns[region_index(cx * 16, cz * 16)]);
+
+			column_lighting[i] = flags & region_lighting;
+
+			if (column_data[i].empty())
+			{
+				lit = false;
+			}
+		}
+
+		if (!(flags & region_lighting))
+		{
+			lit = false;
+		}
+	}
+
+	// Decompress (or generate) every column in parallel. Each column only
+	// changes it's own sections and heightmap. Columns whose data is corrupt
+	// are generated again (or left empty, if they can not be), and have no
+	// lighting information.
+
+	std::atomic<bool> corrupt(false);
+
+	run_in_parallel(column_count, [&](size_t i)
+	{
+		unsigned int x = (i % out->chunk_x_res) * 16;
+		unsigned int z = (i / out->chunk_x_res) * 16;
+
+		if (!column_data[i].empty())
+		{
+			bool read = read_column_data(out, x, z, column_data[i], column_lighting[i]);
+
+			std::string().swap(column_data[i]);
+
+			if (read)
+			{
+				return;
+			}
+
+			corrupt = true;
+		}
+
+		if (generator == generated_by_column)
+		{
+			column_terrain terrain(seed, y_res);
+
+			generate_column_voxels(out, terrain, x, z);
+		}
+	});
+
+	if (!lit || corrupt)
+	{
+		propagate_skylight(out);
+
+		// Give back the memory that was used while the sections were filled.
+
+		compact_world(out);
+	}
+}
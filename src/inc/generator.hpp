@@ -166,6 +166,54 @@ void plant_tree_accessor(accessor* out, hitbox player, unsigned int x, unsigned
 	}
 }
 
+// Replace id_air with id in a box of a world. Only the voxels between (min_x,
+// min_z) and (max_x, max_z) are changed.
+
+inline void plant_box(world* out, int x, int y, int z, int x_res, int y_res, int z_res, block_id id, int min_x, int min_z, int max_x, int max_z)
+{
+	int x0 = std::max(x, min_x);
+	int z0 = std::max(z, min_z);
+
+	int x1 = std::min(x + x_res, max_x);
+	int z1 = std::min(z + z_res, max_z);
+
+	replace_in_box(out, x0, y, z0, x1 - x0, y_res, z1 - z0, id_air, id);
+}
+
+// Plant a tree whose trunk starts above (x, y, z). Only the voxels between 
+// (min_x, min_z) and (max_x, max_z) are changed. The rounded tree is one 
+// block taller than the original tree, and has a fifth layer of leaves.
+
+void plant_tree_in_box(world* out, int x, int y, int z, block_id tree_leaf, block_id tree_log, bool rounded, int min_x, int min_z, int max_x, int max_z)
+{
+	int h = rounded ? 1 : 0;
+
+	// This is the trunk.
+
+	plant_box(out, x, y - 5 - h, z, 1, 5 + h, 1, tree_log, min_x, min_z, max_x, max_z);
+
+	// This is the cross at the top.
+
+	plant_box(out, x - 1, y - 6 - h, z, 3, 1, 1, tree_leaf, min_x, min_z, max_x, max_z);
+	plant_box(out, x, y - 6 - h, z - 1, 1, 1, 3, tree_leaf, min_x, min_z, max_x, max_z);
+
+	// This is the square at the layer second from the top, and the squares
+	// at the third and fourth layer from the top. Their centers are already
+	// taken by the trunk.
+
+	plant_box(out, x - 1, y - 5 - h, z - 1, 3, 1, 3, tree_leaf, min_x, min_z, max_x, max_z);
+
+	plant_box(out, x - 2, y - 4 - h, z - 2, 5, 2, 5, tree_leaf, min_x, min_z, max_x, max_z);
+
+	// The rounded tree has a fifth layer with it's corners removed.
+
+	if (rounded)
+	{
+		plant_box(out, x - 2, y - 3, z - 1, 5, 1, 3, tree_leaf, min_x, min_z, max_x, max_z);
+		plant_box(out, x - 1, y - 3, z - 2, 3, 1, 5, tree_leaf, min_x, min_z, max_x, max_z);
+	}
+}
+
 // Generate a world using a seed.
 
 void generate_world(world* out, unsigned int seed)
@@ -192,23 +240,24 @@ void generate_world(world* out, unsigned int seed)
 
 	float frequency = 2.0f;
 
-	for (float x = 0.0f; x < float(out->x_res); x += 1.0f)
-	for (float y = 0.0f; y < float(out->y_res); y += 1.0f)
-	for (float z = 0.0f; z < float(out->z_res); z += 1.0f)
+	transform_in_box(out, 0, 0, 0, out->x_res, out->y_res, out->z_res, [&](float x, float y, float z, block_id id)
 	{
 		if (pow(y / float(out->y_res), 1.1024f) + noise.GetValueFractal(x * frequency, y * frequency, z * frequency) * 0.60f > 0.5f)
 		{
-			out->set_id(int(x), int(y), int(z), id_stone);
+			return id_stone;
 		}
-	}
+
+		return id;
+	});
 
 	// Set the highground blocks.
 
 	for (float x = 0.0f; x < float(out->x_res); x += 1.0f)
 	for (float z = 0.0f; z < float(out->z_res); z += 1.0f)
-	for (float y = 0.0f; y < float(out->y_res); y += 1.0f)
 	{
-		if (out->get_id(int(x), int(y), int(z)) != id_air)
+		float y = float(out->top_non_air(int(x), int(z)));
+
+		if (y < float(out->y_res))
 		{
 			if (y / float(out->y_res) > 0.6f)
 			{
@@ -244,23 +293,30 @@ void generate_world(world* out, unsigned int seed)
 				out->set_id_safe_if_not_air(int(x), int(y) + 2, int(z), id_dirt);
 				out->set_id_safe_if_not_air(int(x), int(y) + 3, int(z), id_dirt);
 			}
-
-			break;
 		}
 	}
 
-	// Create beaches and top-level water.
+	// Create beaches and top-level water. Columns whose highest voxel is
+	// below the water level get water at the water level.
 
 	std::vector<std::tuple<unsigned int, unsigned int, unsigned int>> flood_water;
 
+	float water_level = 0.0f;
+
+	while (water_level < float(out->y_res) && water_level / float(out->y_res) <= 0.5f)
+	{
+		water_level += 1.0f;
+	}
+
 	for (float x = 0.0f; x < float(out->x_res); x += 1.0f)
 	for (float z = 0.0f; z < float(out->z_res); z += 1.0f)
-	for (float y = 0.0f; y < float(out->y_res); y += 1.0f)
 	{
-		block_id current_block = out->get_id(int(x), int(y), int(z));
+		float y = float(out->top_non_air(int(x), int(z)));
 
-		if (current_block != id_air)
+		if (y <= water_level && y < float(out->y_res))
 		{
+			block_id current_block = out->get_id(int(x), int(y), int(z));
+
 			if ((current_block == id_grass || current_block == id_mycelium) && y / float(out->y_res) > 0.5f)
 			{
 				out->set_id(int(x), int(y), int(z), id_sand);
@@ -277,16 +333,12 @@ void generate_world(world* out, unsigned int seed)
 					}
 				}
 			}
-
-			break;
 		}
-		else if (y / float(out->y_res) > 0.5f)
+		else if (water_level < float(out->y_res))
 		{
-			flood_water.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y, z));
+			flood_water.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, water_level, z));
 
-			out->set_id(int(x), int(y), int(z), id_water);
-			
-			break;
+			out->set_id(int(x), int(water_level), int(z), id_water);
 		}
 	}
 
@@ -404,162 +456,23 @@ void generate_world(world* out, unsigned int seed)
 
 		// Find the highest layer.
 
-		for (int y = 0; y < out->y_res; y++)
-		{
-			if (out->get_id(x, y, z) != id_air)
-			{
-				// Okay, found something that is not air.
-
-				if (out->get_id(x, y, z) == id_grass)
-				{
-					// It's grass, we may plant a tree if there are enough 
-					// blocks available above the grass.
-
-					if (rand() % 2 == 0)
-					{
-						// Original tree.
-
-						if (!out->in_bounds(x, y - 6, z))
-						{
-							goto tree;
-						} 
-
-						// This is the trunk.
-
-						out->set_id_safe_if_air(x, y - 1, z, tree_log);
-						out->set_id_safe_if_air(x, y - 2, z, tree_log);
-						out->set_id_safe_if_air(x, y - 3, z, tree_log);
-						out->set_id_safe_if_air(x, y - 4, z, tree_log);
-						out->set_id_safe_if_air(x, y - 5, z, tree_log);
-
-						// This is the cross at the top.
-
-						out->set_id_safe_if_air(x, y - 6, z, tree_leaf);
-
-						out->set_id_safe_if_air(x - 1, y - 6, z, tree_leaf);
-						out->set_id_safe_if_air(x + 1, y - 6, z, tree_leaf);
-
-						out->set_id_safe_if_air(x, y - 6, z - 1, tree_leaf);
-						out->set_id_safe_if_air(x, y - 6, z + 1, tree_leaf);
-
-						// This is the square at the layer second from the 
-						// top.
-
-						for (int j = -1; j <= 1; j++)
-						{
-							for (int k = -1; k <= 1; k++)
-							{
-								if (j == 0 && k == 0)
-								{
-									continue;
-								}
-								
-								out->set_id_safe_if_air(x + j, y - 5, z + k, tree_leaf);
-							}
-						}
-
-						// These are the squares at the third and fourth 
-						// layer from the top.
+		int y = out->top_non_air(x, z);
 
-						for (int j = -2; j <= 2; j++)
-						{
-							for (int k = -2; k <= 2; k++)
-							{
-								if (j == 0 && k == 0)
-								{
-									continue;
-								}
-
-								out->set_id_safe_if_air(x + j, y - 4, z + k, tree_leaf);
-								out->set_id_safe_if_air(x + j, y - 3, z + k, tree_leaf);
-							}
-						}
-					}
-					else
-					{
-						// Rounded tree.
-
-						if (!out->in_bounds(x, y - 7, z))
-						{
-							goto tree;
-						} 
-
-						// This is the trunk.
-
-						out->set_id_safe_if_air(x, y - 1, z, tree_log);
-						out->set_id_safe_if_air(x, y - 2, z, tree_log);
-						out->set_id_safe_if_air(x, y - 3, z, tree_log);
-						out->set_id_safe_if_air(x, y - 4, z, tree_log);
-						out->set_id_safe_if_air(x, y - 5, z, tree_log);
-						out->set_id_safe_if_air(x, y - 6, z, tree_log);
-
-						// This is the cross at the top.
-
-						out->set_id_safe_if_air(x, y - 7, z, tree_leaf);
-
-						out->set_id_safe_if_air(x - 1, y - 7, z, tree_leaf);
-						out->set_id_safe_if_air(x + 1, y - 7, z, tree_leaf);
-
-						out->set_id_safe_if_air(x, y - 7, z - 1, tree_leaf);
-						out->set_id_safe_if_air(x, y - 7, z + 1, tree_leaf);
-
-						// This is the square at the layer second from the 
-						// top.
-
-						for (int j = -1; j <= 1; j++)
-						{
-							for (int k = -1; k <= 1; k++)
-							{
-								if (j == 0 && k == 0)
-								{
-									continue;
-								}
-								
-								out->set_id_safe_if_air(x + j, y - 6, z + k, tree_leaf);
-							}
-						}
-
-						// These are the squares at the third and fourth 
-						// layer from the top.
-
-						for (int j = -2; j <= 2; j++)
-						{
-							for (int k = -2; k <= 2; k++)
-							{
-								if (j == 0 && k == 0)
-								{
-									continue;
-								}
-
-								out->set_id_safe_if_air(x + j, y - 5, z + k, tree_leaf);
-								out->set_id_safe_if_air(x + j, y - 4, z + k, tree_leaf);
-							}
-						}
+		if (y < int(out->y_res) && out->get_id(x, y, z) == id_grass)
+		{
+			// It's grass, we may plant a tree if there are enough blocks
+			// available above the grass.
 
-						// This is the square at the fifth layer from the top.
-						// It has it's corners removed.
+			// The rounded tree is one block taller than the original tree.
 
-						for (int j = -2; j <= 2; j++)
-						{
-							for (int k = -2; k <= 2; k++)
-							{
-								if (j == 0 && k == 0)
-								{
-									continue;
-								}
-								else if ((j == 2 && k == 2) || (j == 2 && k == -2) || (j == -2 && k == 2) || (j == -2 && k == -2))
-								{
-									continue;
-								}
-								
-								out->set_id_safe_if_air(x + j, y - 3, z + k, tree_leaf);
-							}
-						}
-					}
-				}
+			bool rounded = rand() % 2 != 0;
 
-				break;
+			if (!out->in_bounds(x, y - (rounded ? 7 : 6), z))
+			{
+				goto tree;
 			}
+
+			plant_tree_in_box(out, x, y, z, tree_leaf, tree_log, rounded, 0, 0, out->x_res, out->z_res);
 		}
 	}
 
@@ -579,94 +492,88 @@ void generate_world(world* out, unsigned int seed)
 		int x = rand() % out->x_res;
 		int z = rand() % out->z_res;
 
-		for (int y = 0; y < out->y_res; y++)
-		{
-			if (out->get_id(x, y, z) != id_air)
-			{
-				// Okay, found something that is not air.
+		// Find the highest layer.
 
-				if (out->get_id(x, y, z) == id_grass || out->get_id(x, y, z) == id_mycelium)
-				{
-					// It's grass, we may plant a mushroom if there are enough
-					// blocks available above the grass.
+		int y = out->top_non_air(x, z);
 
-					if (!out->in_bounds(x, y - 6, z))
-					{
-						goto mushroom;
-					}
+		if (y < int(out->y_res) && (out->get_id(x, y, z) == id_grass || out->get_id(x, y, z) == id_mycelium))
+		{
+			// It's grass, we may plant a mushroom if there are enough
+			// blocks available above the grass.
 
-					if (rand() % 5 != 0)
-					{
-						// Red mushroom. This is the trunk.
+			if (!out->in_bounds(x, y - 6, z))
+			{
+				goto mushroom;
+			}
 
-						out->set_id_safe_if_air(x, y - 1, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 2, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 3, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 4, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 5, z, id_mushroom_stem);
+			if (rand() % 5 != 0)
+			{
+				// Red mushroom. This is the trunk.
 
-						// These are the five squares.
+				out->set_id_safe_if_air(x, y - 1, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 2, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 3, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 4, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 5, z, id_mushroom_stem);
 
-						for (int j = -1; j <= 1; j++)
-						{
-							for (int k = -1; k <= 1; k++)
-							{
-								// Top square.
+				// These are the five squares.
 
-								out->set_id_safe_if_air(x + j, y - 6, z + k, id_red_mushroom_block);
+				for (int j = -1; j <= 1; j++)
+				{
+					for (int k = -1; k <= 1; k++)
+					{
+						// Top square.
 
-								// Left square.
+						out->set_id_safe_if_air(x + j, y - 6, z + k, id_red_mushroom_block);
 
-								out->set_id_safe_if_air(x - 2, y - 4 + j, z + k, id_red_mushroom_block);
+						// Left square.
 
-								out->set_id_safe_if_air(x - 1, y - 4 + j, z + k, id_air);
+						out->set_id_safe_if_air(x - 2, y - 4 + j, z + k, id_red_mushroom_block);
 
-								// Right square.
+						out->set_id_safe_if_air(x - 1, y - 4 + j, z + k, id_air);
 
-								out->set_id_safe_if_air(x + 2, y - 4 + j, z + k, id_red_mushroom_block);
+						// Right square.
 
-								out->set_id_safe_if_air(x + 1, y - 4 + j, z + k, id_air);
+						out->set_id_safe_if_air(x + 2, y - 4 + j, z + k, id_red_mushroom_block);
 
-								// Front square.
+						out->set_id_safe_if_air(x + 1, y - 4 + j, z + k, id_air);
 
-								out->set_id_safe_if_air(x + k, y - 4 + j, z - 2, id_red_mushroom_block);
+						// Front square.
 
-								out->set_id_safe_if_air(x + k, y - 4 + j, z - 1, id_air);
+						out->set_id_safe_if_air(x + k, y - 4 + j, z - 2, id_red_mushroom_block);
 
-								// Back square.
+						out->set_id_safe_if_air(x + k, y - 4 + j, z - 1, id_air);
 
-								out->set_id_safe_if_air(x + k, y - 4 + j, z + 2, id_red_mushroom_block);
+						// Back square.
 
-								out->set_id_safe_if_air(x + k, y - 4 + j, z + 1, id_air);
-							}
-						}
+						out->set_id_safe_if_air(x + k, y - 4 + j, z + 2, id_red_mushroom_block);
+
+						out->set_id_safe_if_air(x + k, y - 4 + j, z + 1, id_air);
 					}
-					else
-					{
-						// Brown mushroom. This is the trunk.
+				}
+			}
+			else
+			{
+				// Brown mushroom. This is the trunk.
 
-						out->set_id_safe_if_air(x, y - 1, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 2, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 3, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 4, z, id_mushroom_stem);
-						out->set_id_safe_if_air(x, y - 5, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 1, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 2, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 3, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 4, z, id_mushroom_stem);
+				out->set_id_safe_if_air(x, y - 5, z, id_mushroom_stem);
 
-						for (int j = -3; j <= 3; j++)
+				for (int j = -3; j <= 3; j++)
+				{
+					for (int k = -3; k <= 3; k++)
+					{
+						if ((j == 3 && k == 3) || (j == 3 && k == -3) || (j == -3 && k == 3) || (j == -3 && k == -3))
 						{
-							for (int k = -3; k <= 3; k++)
-							{
-								if ((j == 3 && k == 3) || (j == 3 && k == -3) || (j == -3 && k == 3) || (j == -3 && k == -3))
-								{
-									continue;
-								}
-
-								out->set_id_safe_if_air(x + j, y - 6, z + k, id_brown_mushroom_block);
-							}
+							continue;
 						}
+
+						out->set_id_safe_if_air(x + j, y - 6, z + k, id_brown_mushroom_block);
 					}
 				}
-
-				break;
 			}
 		}
 	}
@@ -711,19 +618,11 @@ void generate_world(world* out, unsigned int seed)
 
 			// Find the highest grass block and plant a flower there.
 
-			for (int y = 0; y < out->y_res; y++)
-			{
-				block_id current_block = out->get_id(x, y, z);
+			int y = out->top_non_air(x, z);
 
-				if (current_block != id_air)
-				{
-					if (current_block == id_grass)
-					{
-						out->set_id_safe(x, y - 1, z, flower);
-					}
-
-					break;
-				}
+			if (y < int(out->y_res) && out->get_id(x, y, z) == id_grass)
+			{
+				out->set_id_safe(x, y - 1, z, flower);
 			}
 		}
 	}
@@ -816,19 +715,11 @@ void generate_world(world* out, unsigned int seed)
 			// Find the highest grass block and plant a pumpkin or melon 
 			// there.
 
-			for (int y = 0; y < out->y_res; y++)
-			{
-				block_id current_block = out->get_id(x, y, z);
-
-				if (current_block != id_air)
-				{
-					if (current_block == id_grass)
-					{
-						out->set_id_safe(x, y - 1, z, block);
-					}
+			int y = out->top_non_air(x, z);
 
-					break;
-				}
+			if (y < int(out->y_res) && out->get_id(x, y, z) == id_grass)
+			{
+				out->set_id_safe(x, y - 1, z, block);
 			}
 		}
 	}
@@ -836,11 +727,11 @@ void generate_world(world* out, unsigned int seed)
 	// Add bedrock. This will fill the bottom layer with 100% bedrock, and the
 	// second from bottom layer with ~50% bedrock.
 
+	fill_box(out, 0, out->y_res - 1, 0, out->x_res, 1, out->z_res, id_bedrock);
+
 	for (int x = 0; x < out->x_res; x++)
 	for (int z = 0; z < out->z_res; z++)
 	{
-		out->set_id(x, out->y_res - 1, z, id_bedrock);
-
 		if (rand() % 2 == 0)
 		{
 			out->set_id(x, out->y_res - 2, z, id_bedrock);
@@ -850,4 +741,573 @@ void generate_world(world* out, unsigned int seed)
 	// Propagate skylight.
 
 	propagate_skylight(out);
-}
\ No newline at end of file
+
+	// Give back the memory that was used while the sections were filled.
+
+	compact_world(out);
+}
+// Mix a seed and a pair of coordinates into a well distributed hash. This is
+// used instead of rand() where the result must not depend on the order in
+// which the columns of a streaming world are generated.
+
+inline unsigned int hash_coordinates(unsigned int seed, unsigned int x, unsigned int z)
+{
+	unsigned int h = seed ^ (x * 0x9e3779b1u) ^ (z * 0x85ebca77u);
+
+	h ^= h >> 16;
+
+	h *= 0x7feb352du;
+
+	h ^= h >> 15;
+
+	h *= 0x846ca68bu;
+
+	h ^= h >> 16;
+
+	return h;
+}
+
+// A small random number generator that is seeded with the coordinates of a
+// column. It can be used like rand().
+
+struct column_random
+{
+	unsigned int state;
+
+	column_random(unsigned int seed, unsigned int cx, unsigned int cz)
+	{
+		state = hash_coordinates(seed, cx, cz) | 1;
+	}
+
+	inline int next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		return int(state >> 1);
+	}
+};
+
+// A column_terrain answers questions about the terrain of a streaming world 
+// before any features (such as trees) are added to it. Every answer depends
+// only on the seed and the coordinates, so the terrain of columns that are
+// not resident can be inspected.
+
+struct column_terrain
+{
+	FastNoise noise;
+
+	unsigned int seed;
+
+	unsigned int y_res;
+
+	bool mushroom_world;
+
+	float frequency;
+
+	// The surface heights of a 48x48 area that is centered on the column 
+	// being generated, or -1 if they have not been computed yet.
+
+	unsigned int area_x;
+	unsigned int area_z;
+
+	std::vector<int> area_surfaces;
+
+	column_terrain(unsigned int the_seed, unsigned int the_y_res)
+	{
+		seed = the_seed;
+
+		y_res = the_y_res;
+
+		noise.SetSeed(seed);
+
+		noise.SetNoiseType(FastNoise::SimplexFractal);
+
+		noise.SetFractalOctaves(2);
+
+		frequency = 2.0f;
+
+		// A small easter egg: sometimes mushroom worlds will spawn!
+
+		mushroom_world = hash_coordinates(seed, 0, 0) % 1024 == 0;
+	}
+
+	// Start generating the column that holds the voxel at the specified X 
+	// and Z coordinates.
+
+	void begin_column(unsigned int x, unsigned int z)
+	{
+		area_x = (x & ~15u) - 16;
+		area_z = (z & ~15u) - 16;
+
+		area_surfaces.assign(48 * 48, -1);
+	}
+
+	// Check if the base terrain at the specified coordinates is solid.
+
+	inline bool solid(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return pow(float(y) / float(y_res), 1.1024f) + noise.GetValueFractal(float(x) * frequency, float(y) * frequency, float(z) * frequency) * 0.60f > 0.5f;
+	}
+
+	// Get the Y coordinate of the highest solid voxel of the base terrain at 
+	// the specified X and Z coordinates, or y_res if there is none.
+
+	inline int surface(unsigned int x, unsigned int z)
+	{
+		int* cached = nullptr;
+
+		if (x - area_x < 48 && z - area_z < 48)
+		{
+			cached = &area_surfaces[(x - area_x) + 48 * (z - area_z)];
+
+			if (*cached >= 0)
+			{
+				return *cached;
+			}
+		}
+
+		int y = 0;
+
+		while (y < int(y_res) && !solid(x, y, z))
+		{
+			y++;
+		}
+
+		if (cached)
+		{
+			*cached = y;
+		}
+
+		return y;
+	}
+
+	// Check if the voxel at the specified coordinates is below sea level.
+
+	inline bool below_sea_level(unsigned int y)
+	{
+		return float(y) / float(y_res) > 0.5f;
+	}
+
+	// Check if the voxel at the specified coordinates is water.
+
+	inline bool water(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return below_sea_level(y) && int(y) < surface(x, z);
+	}
+
+	// Get the block_id of the highest voxel at the specified X and Z 
+	// coordinates, given it's Y coordinate.
+
+	inline block_id surface_id(unsigned int x, unsigned int s, unsigned int z)
+	{
+		if (float(s) / float(y_res) > 0.6f)
+		{
+			if (noise.GetValueFractal(float(x) * frequency, float(s) * frequency) >= -0.2f)
+			{
+				return id_sand;
+			}
+			else
+			{
+				return id_gravel;
+			}
+		}
+		else if (below_sea_level(s))
+		{
+			// Beaches.
+
+			return id_sand;
+		}
+		else if (mushroom_world)
+		{
+			return id_mycelium;
+		}
+
+		return id_grass;
+	}
+
+	// Get the block_id of the voxel at the specified coordinates.
+
+	block_id get_id(unsigned int x, unsigned int y, unsigned int z)
+	{
+		// Add bedrock. This will fill the bottom layer with 100% bedrock, and
+		// the second from bottom layer with ~50% bedrock.
+
+		if (y == y_res - 1 || (y == y_res - 2 && hash_coordinates(seed, x, z) % 2 == 0))
+		{
+			return id_bedrock;
+		}
+
+		int s = surface(x, z);
+
+		if (int(y) < s)
+		{
+			// Above the surface is water, or air. Beaches may have reeds.
+
+			if (below_sea_level(y))
+			{
+				return id_water;
+			}
+
+			if (below_sea_level(s) && !below_sea_level(s - 1) && float(s) / float(y_res) <= 0.6f)
+			{
+				unsigned int reeds = hash_coordinates(seed ^ 0x5eed, x, z);
+
+				if (reeds % 2 == 0 && s - int(y) <= int((reeds >> 1) % 4 + 1))
+				{
+					return id_reeds;
+				}
+			}
+
+			return id_air;
+		}
+
+		// The surface itself is known to be solid, so the noise only has to 
+		// be sampled below it.
+
+		if (int(y) > s && !solid(x, y, z))
+		{
+			return id_air;
+		}
+
+		// Solid blocks that touch the water become sand.
+
+		if (below_sea_level(y))
+		{
+			if ((int(y) == s && below_sea_level(y - 1)) || water(x + 1, y, z) || water(x - 1, y, z) || water(x, y, z + 1) || water(x, y, z - 1))
+			{
+				return id_sand;
+			}
+		}
+
+		// Set the highground blocks.
+
+		block_id top = surface_id(x, s, z);
+
+		if (int(y) == s)
+		{
+			return top;
+		}
+		else if (int(y) <= s + 3)
+		{
+			if (float(s) / float(y_res) > 0.6f)
+			{
+				return top == id_sand ? id_sandstone : id_gravel;
+			}
+
+			return id_dirt;
+		}
+
+		return id_stone;
+	}
+};
+
+// Plant a tree whose trunk starts above (x, y, z). Only the voxels inside the
+// column that holds the voxel at (cx, 0, cz) are changed.
+
+void plant_tree_column(world* out, unsigned int cx, unsigned int cz, unsigned int x, unsigned int y, unsigned int z, block_id tree_leaf, block_id tree_log, bool rounded)
+{
+	int x0 = cx & ~15u;
+	int z0 = cz & ~15u;
+
+	plant_tree_in_box(out, x, y, z, tree_leaf, tree_log, rounded, x0, z0, x0 + 16, z0 + 16);
+}
+
+// Plant a large mushroom whose stem starts above (x, y, z). Only the voxels
+// inside the column that holds the voxel at (cx, 0, cz) are changed.
+
+void plant_large_mushroom_column(world* out, unsigned int cx, unsigned int cz, unsigned int x, unsigned int y, unsigned int z, bool red)
+{
+	int x0 = cx & ~15u;
+	int z0 = cz & ~15u;
+
+	int x1 = x0 + 16;
+	int z1 = z0 + 16;
+
+	// This is the trunk.
+
+	plant_box(out, x, y - 5, z, 1, 5, 1, id_mushroom_stem, x0, z0, x1, z1);
+
+	if (red)
+	{
+		// These are the five squares.
+
+		plant_box(out, x - 1, y - 6, z - 1, 3, 1, 3, id_red_mushroom_block, x0, z0, x1, z1);
+
+		plant_box(out, x - 2, y - 5, z - 1, 1, 3, 3, id_red_mushroom_block, x0, z0, x1, z1);
+		plant_box(out, x + 2, y - 5, z - 1, 1, 3, 3, id_red_mushroom_block, x0, z0, x1, z1);
+
+		plant_box(out, x - 1, y - 5, z - 2, 3, 3, 1, id_red_mushroom_block, x0, z0, x1, z1);
+		plant_box(out, x - 1, y - 5, z + 2, 3, 3, 1, id_red_mushroom_block, x0, z0, x1, z1);
+	}
+	else
+	{
+		// This is the cap, with it's corners removed.
+
+		plant_box(out, x - 3, y - 6, z - 2, 7, 1, 5, id_brown_mushroom_block, x0, z0, x1, z1);
+		plant_box(out, x - 2, y - 6, z - 3, 5, 1, 7, id_brown_mushroom_block, x0, z0, x1, z1);
+	}
+}
+
+// Generate the voxels of the column that holds the voxel at the specified X
+// and Z coordinates, without propagating skylight. The column must already be
+// resident. The terrain matches the terrain of neighboring columns, no matter
+// in which order the columns are generated.
+
+void generate_column_voxels(world* out, column_terrain& terrain, unsigned int x, unsigned int z)
+{
+	unsigned int x0 = x & ~15u;
+	unsigned int z0 = z & ~15u;
+
+	terrain.begin_column(x0, z0);
+
+	// Generate the base terrain, the highground blocks, the beaches, the 
+	// water and the bedrock.
+
+	transform_in_box(out, x0, 0, z0, 16, out->y_res, 16, [&](unsigned int cx, unsigned int cy, unsigned int cz, block_id id)
+	{
+		return terrain.get_id(cx, cy, cz);
+	});
+
+	// Plant the features of this column and of it's eight neighbors, since 
+	// trees and mushrooms may reach into this column from it's neighbors.
+	// Each column has it's own random number generator, so a feature always
+	// looks the same from both of the columns that it touches.
+
+	for (int dz = -1; dz <= 1; dz++)
+	for (int dx = -1; dx <= 1; dx++)
+	{
+		unsigned int fx = x0 + dx * 16;
+		unsigned int fz = z0 + dz * 16;
+
+		column_random random(terrain.seed, fx >> 4, fz >> 4);
+
+		bool own_column = dx == 0 && dz == 0;
+
+		// Plant trees.
+
+		for (int i = 0; i < 16 * 16 / 32; i++)
+		{
+			unsigned int tx = fx + random.next() % 16;
+			unsigned int tz = fz + random.next() % 16;
+
+			block_id tree_leaf = id_oak_leaves;
+
+			block_id tree_log = id_oak_log;
+
+			if (random.next() % 3 == 0)
+			{
+				tree_leaf = id_birch_leaves;
+
+				tree_log = id_birch_log;
+			}
+
+			bool rounded = random.next() % 2 != 0;
+
+			// Trees grow on grass, if there are enough blocks available above
+			// the grass.
+
+			int s = terrain.surface(tx, tz);
+
+			if (s >= int(out->y_res) || s < 7 || terrain.surface_id(tx, s, tz) != id_grass)
+			{
+				continue;
+			}
+
+			plant_tree_column(out, x0, z0, tx, s, tz, tree_leaf, tree_log, rounded);
+		}
+
+		// Plant large mushrooms.
+
+		int mushroom_count = random.next() % 4 == 0 ? 1 : 0;
+
+		if (terrain.mushroom_world)
+		{
+			mushroom_count = 16 * 16 / 32;
+		}
+
+		for (int i = 0; i < mushroom_count; i++)
+		{
+			unsigned int mx = fx + random.next() % 16;
+			unsigned int mz = fz + random.next() % 16;
+
+			bool red = random.next() % 5 != 0;
+
+			int s = terrain.surface(mx, mz);
+
+			if (s >= int(out->y_res) || s < 6)
+			{
+				continue;
+			}
+
+			block_id ground = terrain.surface_id(mx, s, mz);
+
+			if (ground == id_grass || ground == id_mycelium)
+			{
+				plant_large_mushroom_column(out, x0, z0, mx, s, mz, red);
+			}
+		}
+
+		// The remaining features are small, so only the ones that start in
+		// this column are planted.
+
+		if (!own_column)
+		{
+			continue;
+		}
+
+		// Plant a patch of flowers on every other column.
+
+		if (random.next() % 2 == 0)
+		{
+			block_id flower = random.next() % 2 == 0 ? id_dandelion : id_rose;
+
+			unsigned int px = fx + random.next() % 16;
+			unsigned int pz = fz + random.next() % 16;
+
+			for (int j = 0; j < 16; j++)
+			{
+				unsigned int cx = px + (random.next() % 6) - (random.next() % 6);
+				unsigned int cz = pz + (random.next() % 6) - (random.next() % 6);
+
+				if ((cx >> 4) != (x0 >> 4) || (cz >> 4) != (z0 >> 4))
+				{
+					continue;
+				}
+
+				unsigned int y = out->top_non_air(cx, cz);
+
+				if (y < out->y_res && y > 0 && out->get_id(cx, y, cz) == id_grass)
+				{
+					out->set_id(cx, y - 1, cz, flower);
+				}
+			}
+		}
+
+		// Plant two patches of mushrooms.
+
+		for (int i = 0; i < 2; i++)
+		{
+			block_id mushroom = random.next() % 2 == 0 ? id_red_mushroom : id_brown_mushroom;
+
+			unsigned int px = fx + random.next() % 16;
+			unsigned int py = random.next() % out->y_res;
+			unsigned int pz = fz + random.next() % 16;
+
+			for (int j = 0; j < 24; j++)
+			{
+				unsigned int cx = px + (random.next() % 6) - (random.next() % 6);
+				unsigned int cy = py + (random.next() % 6) - (random.next() % 6);
+				unsigned int cz = pz + (random.next() % 6) - (random.next() % 6);
+
+				if ((cx >> 4) != (x0 >> 4) || (cz >> 4) != (z0 >> 4) || cy >= out->y_res - 1)
+				{
+					continue;
+				}
+
+				block_id below = out->get_id(cx, cy + 1, cz);
+
+				if (below == id_stone || below == id_grass || below == id_dirt)
+				{
+					out->set_id_if_air(cx, cy, cz, mushroom);
+				}
+			}
+		}
+
+		// Plant a patch of pumpkins or melons.
+
+		block_id block = random.next() % 2 == 0 ? id_pumpkin : id_melon;
+
+		unsigned int px = fx + random.next() % 16;
+		unsigned int pz = fz + random.next() % 16;
+
+		for (int j = 0; j < 8; j++)
+		{
+			unsigned int cx = px + (random.next() % 4) - (random.next() % 4);
+			unsigned int cz = pz + (random.next() % 4) - (random.next() % 4);
+
+			if ((cx >> 4) != (x0 >> 4) || (cz >> 4) != (z0 >> 4))
+			{
+				continue;
+			}
+
+			unsigned int y = out->top_non_air(cx, cz);
+
+			if (y < out->y_res && y > 0 && out->get_id(cx, y, cz) == id_grass)
+			{
+				out->set_id(cx, y - 1, cz, block);
+			}
+		}
+	}
+}
+
+// Generate the column of a streaming world that holds the voxel at the 
+// specified X and Z coordinates. The column must already be resident. The 
+// terrain matches the terrain of neighboring columns, no matter in which 
+// order the columns are generated.
+
+void generate_column(world* out, column_terrain& terrain, unsigned int x, unsigned int z)
+{
+	unsigned int x0 = x & ~15u;
+	unsigned int z0 = z & ~15u;
+
+	generate_column_voxels(out, terrain, x0, z0);
+
+	// Propagate skylight.
+
+	propagate_skylight_column(out, x0, z0);
+
+	// Give back the memory that was used while the sections were filled.
+
+	compact_column(out, x0, z0);
+}
+
+// Generate a world using a seed, one column at a time. Unlike generate_world,
+// every column only depends on the seed and it's coordinates, so the columns
+// that are never modified do not have to be saved.
+
+void generate_world_columns(world* out, unsigned int seed)
+{
+	// The columns are generated in parallel. Each column only changes it's
+	// own voxels, and has it's own column_terrain.
+
+	run_in_parallel(size_t(out->chunk_x_res) * out->chunk_z_res, [&](size_t i)
+	{
+		column_terrain terrain(seed, out->y_res);
+
+		generate_column_voxels(out, terrain, (i % out->chunk_x_res) * 16, (i / out->chunk_x_res) * 16);
+	});
+
+	out->generator = generated_by_column;
+
+	// Propagate skylight.
+
+	propagate_skylight(out);
+
+	// Give back the memory that was used while the sections were filled.
+
+	compact_world(out);
+}
+
+// Get the Y coordinate that the top of a player's hitbox must be at for the
+// player to stand on the highest voxel at the specified X and Z coordinates.
+// If the column is not resident, or has no voxels that are not id_air, the
+// player is put at the top of the world.
+
+float spawn_y(world* the_world, float x, float z)
+{
+	if (!the_world->in_bounds(x, 0, z))
+	{
+		return 0.0f;
+	}
+
+	unsigned int y = the_world->top_non_air(x, z);
+
+	if (y == the_world->y_res)
+	{
+		return 0.0f;
+	}
+
+	return std::max(float(y) - 1.8f, 0.0f);
+}
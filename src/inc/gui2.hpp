@@ -42,7 +42,7 @@ void gui2_vtx(float x, float y, float u, float v, float w, float coeff) {
 
 void gui2(float x_, float y_, float scale, block_id id) {
 	if (is_crop(id) || is_cross(id) || is_fire(id)) {
-		float index = block_face_info[id]->l_top;
+		float index = block_face_info[id].l_top;
 		if (id == id_water || id == id_fire) {
 			index *= -1.0f;
 		}
@@ -109,7 +109,7 @@ void gui2(float x_, float y_, float scale, block_id id) {
 
 		// q-top
 		float qtl = 1.0f;
-		float qti = block_face_info[id]->l_top;
+		float qti = block_face_info[id].l_top;
 		ISOV(vtl_x, vtl_y, 0.0f, 1.0f, qti, qtl);
 		ISOV(vtc_x, vtc_y, 0.0f, 0.0f, qti, qtl);
 		ISOV(vtr_x, vtr_y, 1.0f, 0.0f, qti, qtl);
@@ -119,7 +119,7 @@ void gui2(float x_, float y_, float scale, block_id id) {
 
 		// q-left
 		float qll = 0.9f;
-		float qli = block_face_info[id]->l_front;
+		float qli = block_face_info[id].l_front;
 		ISOV(vtl_x, vtl_y, 0.0f, 0.0f, qli, qll);
 		ISOV(vcc_x, vcc_y, 1.0f, 0.0f, qli, qll);
 		ISOV(vbl_x, vbl_y, 0.0f, hiy, qli, qll);
@@ -129,7 +129,7 @@ void gui2(float x_, float y_, float scale, block_id id) {
 
 		// q-right
 		float qrl = 0.7f;
-		float qri = block_face_info[id]->l_right;
+		float qri = block_face_info[id].l_right;
 		ISOV(vcc_x, vcc_y, 0.0f, 0.0f, qri, qrl);
 		ISOV(vtr_x, vtr_y, 1.0f, 0.0f, qri, qrl);
 		ISOV(vbc_x, vbc_y, 0.0f, hiy, qri, qrl);
@@ -0,0 +1,182 @@
+#include <string>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+
+// A journal struct appends every block edit that is made to a singleplayer
+// world to a file in it's level directory, so that the edits made since the
+// world was last saved can be replayed if the game crashes. Appending one
+// small record per edit is much cheaper than saving the edited column.
+//
+// The journal is kept in two files. Edits are appended to journal.dat. When a
+// save starts, journal.dat is moved to the end of journal.old, and once the
+// save has succeeded, journal.old is removed. The edits in journal.old are
+// replayed before the ones in journal.dat.
+
+struct journal_entry
+{
+	unsigned int x;
+	unsigned int z;
+
+	// The frame in which the edit was made.
+
+	unsigned int tick;
+
+	unsigned short y;
+
+	// The block_ids are as wide as the palette entries of a section.
+
+	unsigned short old_id;
+	unsigned short new_id;
+
+	unsigned short padding;
+};
+
+struct journal
+{
+	std::string path_to_level;
+
+	std::ofstream out;
+
+	// The frame that new entries are recorded in.
+
+	unsigned int tick;
+};
+
+// Get the path of the file that new journal entries are appended to, inside
+// of the level directory at path_to_level.
+
+std::string journal_path(std::string path_to_level)
+{
+	return path_to_level + "/journal.dat";
+}
+
+// Get the path of the file that holds the journal entries that are older than
+// the running save, inside of the level directory at path_to_level.
+
+std::string old_journal_path(std::string path_to_level)
+{
+	return path_to_level + "/journal.old";
+}
+
+// Allocate a journal* that appends to the journal of the level directory at
+// path_to_level. Entries that are already in the journal are kept.
+
+journal* allocate_journal(std::string path_to_level)
+{
+	journal* the_journal = new journal();
+
+	the_journal->path_to_level = path_to_level;
+
+	the_journal->out.open(journal_path(path_to_level), std::ios::binary | std::ios::app);
+
+	the_journal->tick = 0;
+
+	if (!the_journal->out.good())
+	{
+		std::cout << "Could not open the journal of " << path_to_level << "." << std::endl;
+	}
+
+	return the_journal;
+}
+
+// Append an edit to a journal*. The entry is flushed to the operating system
+// right away, so it survives the game crashing.
+
+inline void append_to_journal(journal* the_journal, unsigned int x, unsigned int y, unsigned int z, block_id old_id, block_id new_id)
+{
+	journal_entry entry;
+
+	entry.x = x;
+	entry.z = z;
+
+	entry.y = y;
+
+	entry.old_id = old_id;
+	entry.new_id = new_id;
+
+	entry.tick = the_journal->tick;
+
+	entry.padding = 0;
+
+	the_journal->out.write((char*)&entry, sizeof(journal_entry));
+
+	the_journal->out.flush();
+}
+
+// Move the entries of a journal* to journal.old. This is called when a save
+// starts, so that the entries that are appended during the save are kept once
+// the save has succeeded.
+
+void rotate_journal(journal* the_journal)
+{
+	the_journal->out.close();
+
+	std::string path = journal_path(the_journal->path_to_level);
+
+	{
+		std::ifstream in(path, std::ios::binary);
+
+		std::ofstream old_out(old_journal_path(the_journal->path_to_level), std::ios::binary | std::ios::app);
+
+		if (in.good() && in.peek() != std::ifstream::traits_type::eof())
+		{
+			old_out << in.rdbuf();
+		}
+	}
+
+	the_journal->out.open(path, std::ios::binary | std::ios::trunc);
+}
+
+// Remove the entries of a journal* that were moved to journal.old. This is
+// called after a save that started with rotate_journal has succeeded.
+
+void remove_old_journal(journal* the_journal)
+{
+	std::remove(old_journal_path(the_journal->path_to_level).c_str());
+}
+
+// Remove every entry of a journal*. This is called after a save that saved
+// every edit in the journal has succeeded.
+
+void truncate_journal(journal* the_journal)
+{
+	the_journal->out.close();
+
+	remove_old_journal(the_journal);
+
+	the_journal->out.open(journal_path(the_journal->path_to_level), std::ios::binary | std::ios::trunc);
+}
+
+// Read every entry of the journal of the level directory at path_to_level,
+// oldest first. An entry that was cut off by a crash is ignored.
+
+std::vector<journal_entry> read_journal(std::string path_to_level)
+{
+	std::vector<journal_entry> entries;
+
+	std::string paths[2] = {old_journal_path(path_to_level), journal_path(path_to_level)};
+
+	for (int i = 0; i < 2; i++)
+	{
+		std::ifstream in(paths[i], std::ios::binary);
+
+		journal_entry entry;
+
+		while (in.read((char*)&entry, sizeof(journal_entry)))
+		{
+			entries.push_back(entry);
+		}
+	}
+
+	return entries;
+}
+
+// Deallocate a journal*. It's entries are kept.
+
+void deallocate_journal(journal* to_be_annihilated)
+{
+	to_be_annihilated->out.close();
+
+	delete to_be_annihilated;
+}
@@ -0,0 +1,410 @@
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+// A level_load struct loads a world with a fixed size from a level directory
+// progressively, so that the game can start before every column is loaded.
+// The columns are loaded in order of their distance from the player. Threads
+// of the level_load's own read and decompress (or generate) each column into
+// a world* that only holds that column, and the main thread moves the loaded
+// columns into the world and creates their chunks, a few at a time.
+
+struct level_load
+{
+	world* the_world;
+
+	std::string path_to_level;
+
+	unsigned int seed;
+
+	// The indices of the columns of the world, closest to the player first.
+
+	std::vector<unsigned int> order;
+
+	// The world* that each column of order was loaded into, and whether it
+	// was loaded with it's lighting information. A thread sets the loaded
+	// flag of a column once it is loaded.
+
+	std::vector<world*> column_worlds;
+
+	std::vector<unsigned char> column_lit;
+
+	std::atomic<bool>* loaded;
+
+	// The next column of order that a thread loads, and the amount of columns
+	// of order that were moved into the world.
+
+	std::atomic<size_t> next_column;
+
+	size_t columns_moved;
+
+	std::atomic<bool> cancelled;
+
+	std::vector<std::thread> workers;
+
+	// The time at which the level_load was started, and the time it took to
+	// move every column into the world.
+
+	std::chrono::high_resolution_clock::time_point start_time;
+
+	float total_time_in_ms;
+};
+
+// Load the columns of a level_load*. This runs on the level_load's own
+// threads.
+
+void run_level_load(level_load* the_load)
+{
+	world* the_world = the_load->the_world;
+
+	for (size_t i = the_load->next_column.fetch_add(1); i < the_load->order.size(); i = the_load->next_column.fetch_add(1))
+	{
+		if (the_load->cancelled.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+
+		unsigned int x = (the_load->order[i] % the_world->chunk_x_res) * 16;
+		unsigned int z = (the_load->order[i] / the_world->chunk_x_res) * 16;
+
+		world* column_world = allocate_world_window(the_world->x_res, the_world->y_res, the_world->z_res, 1, 1);
+
+		column_world->generator = the_world->generator;
+
+		allocate_column(column_world, x, z);
+
+		unsigned int flags = 0;
+
+		std::string data;
+
+		bool lit = false;
+
+		if (read_region_column(region_path(the_load->path_to_level, x, z), region_index(x, z), flags, data) && read_column_data(column_world, x, z, data, flags & region_lighting))
+		{
+			lit = flags & region_lighting;
+		}
+		else if (the_world->generator == generated_by_column)
+		{
+			// The column was never modified (or it's data is corrupt), so it
+			// is generated again.
+
+			column_terrain terrain(the_load->seed, the_world->y_res);
+
+			generate_column_voxels(column_world, terrain, x, z);
+		}
+
+		compact_column(column_world, x, z);
+
+		the_load->column_worlds[i] = column_world;
+
+		the_load->column_lit[i] = lit;
+
+		the_load->loaded[i].store(true, std::memory_order_release);
+	}
+}
+
+// Start loading a world of the specified size from the level directory at
+// path_to_level in the background. The world* is allocated right away, but
+// none of it's columns are resident until update_level_load or
+// wait_for_level_load moves them into it.
+
+level_load* start_level_load(world*& out, std::string path_to_level, unsigned int seed, unsigned int generator, unsigned int x_res, unsigned int y_res, unsigned int z_res, float player_x, float player_z)
+{
+	out = allocate_world_window(x_res, y_res, z_res, (x_res + 15) / 16, (z_res + 15) / 16);
+
+	out->generator = generator;
+
+	level_load* the_load = new level_load();
+
+	the_load->the_world = out;
+
+	the_load->path_to_level = path_to_level;
+
+	the_load->seed = seed;
+
+	// Order the columns by the distance between their centers and the
+	// player. Columns at the same distance keep their index order, so the
+	// order does not depend on the sort.
+
+	size_t column_count = size_t(out->chunk_x_res) * out->chunk_z_res;
+
+	std::vector<float> distances(column_count);
+
+	for (size_t i = 0; i < column_count; i++)
+	{
+		float dx = float(i % out->chunk_x_res) * 16.0f + 8.0f - player_x;
+		float dz = float(i / out->chunk_x_res) * 16.0f + 8.0f - player_z;
+
+		distances[i] = dx * dx + dz * dz;
+
+		the_load->order.push_back(i);
+	}
+
+	std::stable_sort(the_load->order.begin(), the_load->order.end(), [&](unsigned int a, unsigned int b)
+	{
+		return distances[a] < distances[b];
+	});
+
+	the_load->column_worlds.assign(column_count, nullptr);
+
+	the_load->column_lit.assign(column_count, 0);
+
+	the_load->loaded = new std::atomic<bool>[column_count];
+
+	for (size_t i = 0; i < column_count; i++)
+	{
+		the_load->loaded[i].store(false, std::memory_order_relaxed);
+	}
+
+	the_load->next_column = 0;
+
+	the_load->columns_moved = 0;
+
+	the_load->cancelled = false;
+
+	the_load->total_time_in_ms = 0.0f;
+
+	the_load->start_time = std::chrono::high_resolution_clock::now();
+
+	// One hardware thread is left to the main thread, which keeps running
+	// the game.
+
+	unsigned int thread_count = std::max(1u, parallel_threads - 1);
+
+	for (unsigned int i = 0; i < thread_count; i++)
+	{
+		the_load->workers.push_back(std::thread(run_level_load, the_load));
+	}
+
+	return the_load;
+}
+
+// Get the amount of columns of a level_load* whose centers are within radius
+// columns of the player. These are the first columns that are loaded.
+
+size_t level_load_columns_within(level_load* the_load, float player_x, float player_z, int radius)
+{
+	world* the_world = the_load->the_world;
+
+	float max_distance = float(radius) * 16.0f;
+
+	size_t count = 0;
+
+	for (unsigned int column: the_load->order)
+	{
+		float dx = float(column % the_world->chunk_x_res) * 16.0f + 8.0f - player_x;
+		float dz = float(column / the_world->chunk_x_res) * 16.0f + 8.0f - player_z;
+
+		if (dx * dx + dz * dz > max_distance * max_distance)
+		{
+			break;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+// Create the chunks of the column that holds the voxel at the specified X and
+// Z coordinates, if the column is resident, has no chunks yet, and every
+// neighbor of it that is within the bounds of the world is resident.
+
+void allocate_column_chunks_if_ready(accessor* the_accessor, unsigned int x, unsigned int z)
+{
+	world* the_world = the_accessor->the_world;
+
+	if (!column_in_bounds(the_world, x, z) || !the_world->column_resident(x, z))
+	{
+		return;
+	}
+
+	if (the_accessor->the_chunks[the_world->section_index(x, 0, z)])
+	{
+		return;
+	}
+
+	if
+	(
+		(column_in_bounds(the_world, x - 16, z) && !the_world->column_resident(x - 16, z)) ||
+		(column_in_bounds(the_world, x + 16, z) && !the_world->column_resident(x + 16, z)) ||
+
+		(column_in_bounds(the_world, x, z - 16) && !the_world->column_resident(x, z - 16)) ||
+		(column_in_bounds(the_world, x, z + 16) && !the_world->column_resident(x, z + 16))
+	)
+	{
+		return;
+	}
+
+	allocate_column_chunks(the_accessor, x, z);
+}
+
+// Move the next column of a level_load* into it's world, which must have been
+// loaded. If the_accessor is not nullptr, the chunks of the column and of
+// it's neighbors are created once their neighbors are resident.
+
+void move_loaded_column(level_load* the_load, accessor* the_accessor)
+{
+	world* the_world = the_load->the_world;
+
+	size_t i = the_load->columns_moved;
+
+	unsigned int x = (the_load->order[i] % the_world->chunk_x_res) * 16;
+	unsigned int z = (the_load->order[i] / the_world->chunk_x_res) * 16;
+
+	move_column(the_load->column_worlds[i], the_world, x, z);
+
+	deallocate_world(the_load->column_worlds[i]);
+
+	the_load->column_worlds[i] = nullptr;
+
+	the_load->columns_moved++;
+
+	// Columns that were loaded without their lighting information exchange
+	// light with their resident neighbors, like the columns of a stream.
+
+	if (!the_load->column_lit[i])
+	{
+		propagate_skylight_column(the_world, x, z);
+
+		compact_column(the_world, x, z);
+	}
+
+	if (!the_accessor)
+	{
+		return;
+	}
+
+	// The faces and lighting at the edges of the neighboring columns may
+	// have changed.
+
+	mark_column_modified(the_accessor, x - 16, z);
+	mark_column_modified(the_accessor, x + 16, z);
+
+	mark_column_modified(the_accessor, x, z - 16);
+	mark_column_modified(the_accessor, x, z + 16);
+
+	allocate_column_chunks_if_ready(the_accessor, x, z);
+
+	allocate_column_chunks_if_ready(the_accessor, x - 16, z);
+	allocate_column_chunks_if_ready(the_accessor, x + 16, z);
+
+	allocate_column_chunks_if_ready(the_accessor, x, z - 16);
+	allocate_column_chunks_if_ready(the_accessor, x, z + 16);
+}
+
+// Check if every column of a level_load* was moved into it's world.
+
+inline bool level_load_done(level_load* the_load)
+{
+	return the_load->columns_moved == the_load->order.size();
+}
+
+// Get the progress of a level_load*, from 0 to 1.
+
+inline float level_load_progress(level_load* the_load)
+{
+	if (the_load->order.empty())
+	{
+		return 1.0f;
+	}
+
+	return float(the_load->columns_moved) / float(the_load->order.size());
+}
+
+// Move the columns of a level_load* that were loaded into it's world, closest
+// to the player first, until budget_in_ms milliseconds have passed or the
+// next column is not loaded yet. Returns true once, when the last column was
+// moved.
+
+bool update_level_load(level_load* the_load, accessor* the_accessor, unsigned int budget_in_ms)
+{
+	if (level_load_done(the_load))
+	{
+		return false;
+	}
+
+	unsigned int start_time = SDL_GetTicks();
+
+	while (!level_load_done(the_load) && the_load->loaded[the_load->columns_moved].load(std::memory_order_acquire))
+	{
+		move_loaded_column(the_load, the_accessor);
+
+		if (SDL_GetTicks() - start_time >= budget_in_ms)
+		{
+			break;
+		}
+	}
+
+	if (level_load_done(the_load))
+	{
+		the_load->total_time_in_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - the_load->start_time).count();
+
+		return true;
+	}
+
+	return false;
+}
+
+// Move the first count columns of a level_load* into it's world, waiting for
+// them to be loaded. Returns true if this moved the last column.
+
+bool wait_for_level_load(level_load* the_load, accessor* the_accessor, size_t count)
+{
+	count = std::min(count, the_load->order.size());
+
+	if (the_load->columns_moved >= count)
+	{
+		return false;
+	}
+
+	while (the_load->columns_moved < count)
+	{
+		if (the_load->loaded[the_load->columns_moved].load(std::memory_order_acquire))
+		{
+			move_loaded_column(the_load, the_accessor);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	if (level_load_done(the_load))
+	{
+		the_load->total_time_in_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - the_load->start_time).count();
+
+		return true;
+	}
+
+	return false;
+}
+
+// Deallocate a level_load*. If it is not done, the columns that were not
+// moved into it's world yet stay missing from it. The world* is not
+// deallocated.
+
+void deallocate_level_load(level_load* to_be_annihilated)
+{
+	to_be_annihilated->cancelled.store(true, std::memory_order_relaxed);
+
+	for (std::thread& worker: to_be_annihilated->workers)
+	{
+		worker.join();
+	}
+
+	for (world* column_world: to_be_annihilated->column_worlds)
+	{
+		if (column_world)
+		{
+			deallocate_world(column_world);
+		}
+	}
+
+	delete[] to_be_annihilated->loaded;
+
+	delete to_be_annihilated;
+}
@@ -16,11 +16,10 @@ inline bool show_face(block_id face, block_id neighbor, int face_id)
 	return hide;
 }
 
-// Convert a subset of a world into a vertex array. The generated vertex 
-// array is stored in target, and it's size in floats is stored in 
-// target_size_in_floats.
+// Returns true if a subset of a world is exactly one section, and that
+// section is resident.
 
-void world_subset_to_mesh
+inline bool is_section_subset
 (
 	world* input,
 
@@ -30,513 +29,1053 @@ void world_subset_to_mesh
 
 	unsigned int x_res,
 	unsigned int y_res,
-	unsigned int z_res,
+	unsigned int z_res
+)
+{
+	return !((x & 15) || (y & 15) || (z & 15) || x_res != 16 || y_res != 16 || z_res != 16 || !input->in_bounds(x, y, z));
+}
 
-	float* target,
+// Get the block_id of every voxel in a subset of a world, if the subset is
+// exactly one uniform section. If not, return id_null.
 
-	unsigned int& target_size_in_floats
+inline block_id uniform_subset_id
+(
+	world* input,
+
+	unsigned int x,
+	unsigned int y,
+	unsigned int z,
+
+	unsigned int x_res,
+	unsigned int y_res,
+	unsigned int z_res
 )
 {
-	float* ptr = target;
+	if (!is_section_subset(input, x, y, z, x_res, y_res, z_res))
+	{
+		return id_null;
+	}
+
+	section* the_section = input->section_at(x, y, z);
+
+	if (the_section->bits != 0)
+	{
+		return id_null;
+	}
+
+	return block_id(the_section->uniform_id);
+}
+
+// Returns true if a subset of a world is exactly one uniform section, and
+// every face of every voxel in it is hidden, either by the section itself or
+// by it's six neighboring sections, which must be uniform too.
 
-	unsigned int fx = x + x_res;
-	unsigned int fy = y + y_res;
-	unsigned int fz = z + z_res;
+inline bool uniform_subset_is_hidden
+(
+	world* input,
+
+	unsigned int x,
+	unsigned int y,
+	unsigned int z,
+
+	unsigned int x_res,
+	unsigned int y_res,
+	unsigned int z_res
+)
+{
+	block_id voxel_id = uniform_subset_id(input, x, y, z, x_res, y_res, z_res);
+
+	if (voxel_id == id_null || show_face(voxel_id, voxel_id, 0))
+	{
+		return false;
+	}
+
+	// Sections that are out of bounds return id_null, which shows every face.
 
-	for (unsigned int cx = x; cx < fx; cx++)
+	block_id neighbors[6] =
 	{
-		for (unsigned int cy = y; cy < fy; cy++)
+		uniform_subset_id(input, x, y - 16, z, 16, 16, 16),
+		uniform_subset_id(input, x, y + 16, z, 16, 16, 16),
+
+		uniform_subset_id(input, x - 16, y, z, 16, 16, 16),
+		uniform_subset_id(input, x + 16, y, z, 16, 16, 16),
+
+		uniform_subset_id(input, x, y, z - 16, 16, 16, 16),
+		uniform_subset_id(input, x, y, z + 16, 16, 16, 16)
+	};
+
+	for (int i = 0; i < 6; i++)
+	{
+		if (neighbors[i] == id_null || show_face(voxel_id, neighbors[i], i))
 		{
-			for (unsigned int cz = z; cz < fz; cz++)
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// The mesher reads the voxels of a subset of a world, and their neighbors,
+// through one of the following two structs. A world_voxels reads them from
+// the world, checking the bounds of the world on every read. A mesh_halo
+// holds a decoded copy of one section and of the voxels around it, so every
+// read is a plain array access. Both return id_null for the block_id of a
+// voxel that is out of bounds, and the lighting of the voxel that is being
+// meshed for the lighting of a neighbor that is out of bounds.
+
+struct world_voxels
+{
+	world* input;
+
+	inline block_id get_id(unsigned int cx, unsigned int cy, unsigned int cz)
+	{
+		return input->get_id_safe(cx, cy, cz);
+	}
+
+	inline unsigned char get_natural(unsigned int cx, unsigned int cy, unsigned int cz)
+	{
+		return input->get_natural(cx, cy, cz);
+	}
+
+	inline unsigned char get_natural_edge(unsigned int x1, unsigned int y1, unsigned int z1, unsigned int x2, unsigned int y2, unsigned int z2)
+	{
+		return input->get_natural_edge(x1, y1, z1, x2, y2, z2);
+	}
+
+	inline unsigned char get_artificial(unsigned int cx, unsigned int cy, unsigned int cz)
+	{
+		return input->get_artificial(cx, cy, cz);
+	}
+
+	inline unsigned char get_artificial_edge(unsigned int x1, unsigned int y1, unsigned int z1, unsigned int x2, unsigned int y2, unsigned int z2)
+	{
+		return input->get_artificial_edge(x1, y1, z1, x2, y2, z2);
+	}
+
+	// Call function(x, y, z, id) for every voxel in a subset of the world.
+
+	template <typename F>
+	void for_each(unsigned int x, unsigned int y, unsigned int z, unsigned int x_res, unsigned int y_res, unsigned int z_res, F function)
+	{
+		for_each_in_box(input, x, y, z, x_res, y_res, z_res, function);
+	}
+};
+
+// The size of a mesh_halo along each axis, one section plus a border of one
+// voxel on every side.
+
+const unsigned int halo_res = 18;
+
+struct mesh_halo
+{
+	// The coordinates of the first voxel of the border.
+
+	unsigned int x;
+	unsigned int y;
+	unsigned int z;
+
+	// The coordinates of the voxel after the last voxel of the section that
+	// is within the bounds of the world.
+
+	unsigned int x_end;
+	unsigned int y_end;
+	unsigned int z_end;
+
+	unsigned short ids[halo_res * halo_res * halo_res];
+
+	unsigned char naturals[halo_res * halo_res * halo_res];
+
+	unsigned char artificials[halo_res * halo_res * halo_res];
+
+	// Get the index of the voxel at the specified coordinates. The
+	// coordinates must be inside of the section or it's border.
+
+	inline unsigned int index(unsigned int cx, unsigned int cy, unsigned int cz)
+	{
+		return (cx - x) + halo_res * ((cy - y) + halo_res * (cz - z));
+	}
+
+	inline block_id get_id(unsigned int cx, unsigned int cy, unsigned int cz)
+	{
+		return block_id(ids[index(cx, cy, cz)]);
+	}
+
+	inline unsigned char get_natural(unsigned int cx, unsigned int cy, unsigned int cz)
+	{
+		return naturals[index(cx, cy, cz)];
+	}
+
+	inline unsigned char get_natural_edge(unsigned int x1, unsigned int y1, unsigned int z1, unsigned int x2, unsigned int y2, unsigned int z2)
+	{
+		return naturals[index(x2, y2, z2)];
+	}
+
+	inline unsigned char get_artificial(unsigned int cx, unsigned int cy, unsigned int cz)
+	{
+		return artificials[index(cx, cy, cz)];
+	}
+
+	inline unsigned char get_artificial_edge(unsigned int x1, unsigned int y1, unsigned int z1, unsigned int x2, unsigned int y2, unsigned int z2)
+	{
+		return artificials[index(x2, y2, z2)];
+	}
+
+	// Decode the section at the specified coordinates, which must be
+	// resident, and the voxels around it. The section is decoded as a
+	// whole, and only the voxels of the neighboring sections that touch it
+	// are read.
+
+	void load(world* input, unsigned int sx, unsigned int sy, unsigned int sz)
+	{
+		x = sx - 1;
+		y = sy - 1;
+		z = sz - 1;
+
+		x_end = std::min(sx + 16, input->x_res);
+		y_end = std::min(sy + 16, input->y_res);
+		z_end = std::min(sz + 16, input->z_res);
+
+		// Voxels of the border that are out of bounds are never filled in
+		// below. Their lighting is marked with 0xff until then.
+
+		std::fill(ids, ids + halo_res * halo_res * halo_res, (unsigned short)id_null);
+
+		memset(naturals, 0xff, sizeof(naturals));
+
+		memset(artificials, 0xff, sizeof(artificials));
+
+		unsigned short section_ids[4096];
+
+		unsigned char section_naturals[4096];
+
+		unsigned char section_artificials[4096];
+
+		for_each_section_in_box(input, int(sx) - 1, int(sy) - 1, int(sz) - 1, halo_res, halo_res, halo_res, [&](int nx, int ny, int nz, int x0, int y0, int z0, int x1, int y1, int z1)
+		{
+			section* the_section = input->section_at(nx, ny, nz);
+
+			if (x1 - x0 == 16 && y1 - y0 == 16 && z1 - z0 == 16)
 			{
-				// Skip voxels that are out of bounds.
+				the_section->get_ids(section_ids);
+
+				the_section->get_naturals(section_naturals);
+
+				the_section->get_artificials(section_artificials);
 
-				if (!input->in_bounds(cx, cy, cz))
+				for (int cz = z0; cz < z1; cz++)
+				for (int cy = y0; cy < y1; cy++)
 				{
-					continue;
+					unsigned int i = input->local_index(x0, cy, cz);
+
+					unsigned int j = index(x0, cy, cz);
+
+					memcpy(ids + j, section_ids + i, 16 * sizeof(unsigned short));
+
+					memcpy(naturals + j, section_naturals + i, 16);
+
+					memcpy(artificials + j, section_artificials + i, 16);
 				}
 
-				// Get the current voxel's block_id.
+				return;
+			}
+
+			for (int cz = z0; cz < z1; cz++)
+			for (int cy = y0; cy < y1; cy++)
+			for (int cx = x0; cx < x1; cx++)
+			{
+				unsigned int i = input->local_index(cx, cy, cz);
+
+				unsigned int j = index(cx, cy, cz);
+
+				ids[j] = the_section->get_id(i);
+
+				naturals[j] = the_section->get_natural(i);
+
+				artificials[j] = the_section->get_artificial(i);
+			}
+		});
+
+		// A neighbor that is out of bounds has the lighting of the voxel of
+		// the section that it touches, which is found by clamping it's
+		// coordinates to the part of the section that is within bounds.
+
+		unsigned int max_hx = x_end - x - 1;
+		unsigned int max_hy = y_end - y - 1;
+		unsigned int max_hz = z_end - z - 1;
+
+		for (unsigned int hz = 0; hz < halo_res; hz++)
+		for (unsigned int hy = 0; hy < halo_res; hy++)
+		for (unsigned int hx = 0; hx < halo_res; hx++)
+		{
+			unsigned int j = hx + halo_res * (hy + halo_res * hz);
+
+			if (naturals[j] != 0xff)
+			{
+				continue;
+			}
+
+			unsigned int k = std::min(std::max(hx, 1u), max_hx) + halo_res * (std::min(std::max(hy, 1u), max_hy) + halo_res * std::min(std::max(hz, 1u), max_hz));
+
+			naturals[j] = naturals[k];
+
+			artificials[j] = artificials[k];
+		}
+	}
+
+	// Call function(x, y, z, id) for every voxel in the section that is
+	// within the bounds of the world.
+
+	template <typename F>
+	void for_each(unsigned int sx, unsigned int sy, unsigned int sz, unsigned int x_res, unsigned int y_res, unsigned int z_res, F function)
+	{
+		for (unsigned int cz = sz; cz < z_end; cz++)
+		for (unsigned int cy = sy; cy < y_end; cy++)
+		{
+			unsigned short* row = ids + index(sx, cy, cz);
+
+			for (unsigned int cx = sx; cx < x_end; cx++)
+			{
+				function(cx, cy, cz, block_id(row[cx - sx]));
+			}
+		}
+	}
+};
+
+// If greedy_meshing is true, the visible faces of full cubes that are next to
+// each other, face the same way, and have the same layer and lighting are
+// merged into one larger quad, whose texture repeats once per voxel.
+
+bool greedy_meshing = true;
+
+// The faces of full cubes that are merged by the greedy mesher are recorded
+// in a face_key each, one per voxel and per face. A face_key of 0 means that
+// the face is not visible. Each thread has it's own array of face_keys, which
+// is all zeroes between two calls of the mesher, and it's own flags that mark
+// the slices of voxels (along the axis that each face points along) that
+// have any face_keys, so that the other slices are skipped.
+
+typedef unsigned short face_key;
+
+thread_local std::vector<face_key> greedy_face_keys;
+
+thread_local std::vector<unsigned char> greedy_slices;
+
+// Get the face_key of a visible face with the specified layer and light
+// level (0 to 15).
+
+inline face_key make_face_key(float layer, unsigned char light)
+{
+	return face_key(((int(layer) + 1) << 4 | light) + 1);
+}
+
+// The index of the lighting coefficient of each face, in the order of
+// show_face. The coefficients (1, 0.65, 0.75 and 0.9) are in
+// face_coefficients in block_vertex.glsl, where they are multiplied by the
+// light levels.
+
+const unsigned int face_coefficient_indices[6] = {0, 1, 2, 2, 3, 3};
+
+// Get the lighting value of a vertex of the face that faces the specified
+// way (in the order of show_face) with the specified light level (0 to 15).
+// It is the index of the face's lighting coefficient in bits 4 and 5 and the
+// light level in bits 0 to 3, so it is packed as it is, and the coefficient
+// is applied on the GPU.
+
+inline float face_lighting(int face_id, unsigned char light)
+{
+	return float(face_coefficient_indices[face_id] << 4 | light);
+}
+
+// Write a quad to a vertex array as it's 4 corners. The corners a, b, c and d
+// are ordered like the corners of the faces of a voxel, so the quad has the
+// same winding, and it's texture coordinates go from 0 to u and from 0 to v.
+
+inline float* write_quad(float* ptr, const float* a, const float* b, const float* c, const float* d, float u, float v, float layer, float lighting)
+{
+	*(ptr++) = a[0]; *(ptr++) = a[1]; *(ptr++) = a[2]; *(ptr++) = u; *(ptr++) = 0.0f; *(ptr++) = layer; *(ptr++) = lighting;
+	*(ptr++) = b[0]; *(ptr++) = b[1]; *(ptr++) = b[2]; *(ptr++) = u; *(ptr++) = v; *(ptr++) = layer; *(ptr++) = lighting;
+	*(ptr++) = c[0]; *(ptr++) = c[1]; *(ptr++) = c[2]; *(ptr++) = 0.0f; *(ptr++) = v; *(ptr++) = layer; *(ptr++) = lighting;
+	*(ptr++) = d[0]; *(ptr++) = d[1]; *(ptr++) = d[2]; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer; *(ptr++) = lighting;
+
+	return ptr;
+}
+
+// Write the face of a box of voxels that faces the specified way (in the
+// order of show_face) as one quad. The box starts at the voxel x, y, z, and
+// is w, h and d voxels large.
+
+inline float* write_box_face(float* ptr, int face_id, unsigned int x, unsigned int y, unsigned int z, unsigned int w, unsigned int h, unsigned int d, float layer, float lighting)
+{
+	// The Y axis of the vertices points the other way, so the top of the box
+	// is at -y.
+
+	float x0 = float(x);
+	float x1 = float(x + w);
+
+	float y0 = -float(y);
+	float y1 = -float(y + h);
+
+	float z0 = float(z);
+	float z1 = float(z + d);
 
-				block_id voxel_id = input->get_id(cx, cy, cz);
+	if (face_id == 0)
+	{
+		float a[3] = {x1, y0, z1}; float b[3] = {x0, y0, z1}; float c[3] = {x0, y0, z0}; float e[3] = {x1, y0, z0};
+
+		return write_quad(ptr, a, b, c, e, float(d), float(w), layer, lighting);
+	}
+	else if (face_id == 1)
+	{
+		float a[3] = {x0, y1, z0}; float b[3] = {x0, y1, z1}; float c[3] = {x1, y1, z1}; float e[3] = {x1, y1, z0};
+
+		return write_quad(ptr, a, b, c, e, float(w), float(d), layer, lighting);
+	}
+	else if (face_id == 2)
+	{
+		float a[3] = {x0, y0, z1}; float b[3] = {x0, y1, z1}; float c[3] = {x0, y1, z0}; float e[3] = {x0, y0, z0};
 
-				// Ignore voxels that have a block_id equivalent to id_air or 
-				// id_water.
+		return write_quad(ptr, a, b, c, e, float(d), float(h), layer, lighting);
+	}
+	else if (face_id == 3)
+	{
+		float a[3] = {x1, y0, z0}; float b[3] = {x1, y1, z0}; float c[3] = {x1, y1, z1}; float e[3] = {x1, y0, z1};
+
+		return write_quad(ptr, a, b, c, e, float(d), float(h), layer, lighting);
+	}
+	else if (face_id == 4)
+	{
+		float a[3] = {x0, y0, z0}; float b[3] = {x0, y1, z0}; float c[3] = {x1, y1, z0}; float e[3] = {x1, y0, z0};
+
+		return write_quad(ptr, a, b, c, e, float(w), float(h), layer, lighting);
+	}
+	else
+	{
+		float a[3] = {x1, y0, z1}; float b[3] = {x1, y1, z1}; float c[3] = {x0, y1, z1}; float e[3] = {x0, y0, z1};
+
+		return write_quad(ptr, a, b, c, e, float(w), float(h), layer, lighting);
+	}
+}
+
+// Merge the faces that were recorded in greedy_face_keys for a subset of a
+// world, and write them to a vertex array. Each face is grown along one axis
+// of it's plane as far as the next faces have the same face_key, and then
+// along the other axis as far as every face of the next row does. The
+// face_keys of the faces that were written are set back to 0.
+
+float* write_greedy_faces(float* ptr, unsigned int x, unsigned int y, unsigned int z, unsigned int x_res, unsigned int y_res, unsigned int z_res)
+{
+	// The axis that each face points along, and the two axes of it's plane.
+	// The first axis of the plane is the one that face_keys are grown along
+	// first.
 
-				if (voxel_id == id_air || voxel_id == id_water)
+	const int normal_axes[6] = {1, 1, 0, 0, 2, 2};
+
+	const int first_axes[6] = {0, 0, 1, 1, 0, 0};
+
+	const int second_axes[6] = {2, 2, 2, 2, 1, 1};
+
+	unsigned int res[3] = {x_res, y_res, z_res};
+
+	unsigned int strides[3] = {1, x_res, x_res * y_res};
+
+	size_t voxel_count = size_t(x_res) * y_res * z_res;
+
+	unsigned int slice_count = std::max(x_res, std::max(y_res, z_res));
+
+	for (int face_id = 0; face_id < 6; face_id++)
+	{
+		face_key* keys = greedy_face_keys.data() + face_id * voxel_count;
+
+		unsigned char* slices = greedy_slices.data() + face_id * slice_count;
+
+		int n = normal_axes[face_id];
+		int p = first_axes[face_id];
+		int q = second_axes[face_id];
+
+		for (unsigned int s = 0; s < res[n]; s++)
+		{
+			if (!slices[s])
+			{
+				continue;
+			}
+
+			slices[s] = 0;
+
+			for (unsigned int b = 0; b < res[q]; b++)
+			for (unsigned int a = 0; a < res[p]; a++)
+			{
+				size_t i = s * strides[n] + b * strides[q] + a * strides[p];
+
+				face_key key = keys[i];
+
+				if (key == 0)
 				{
 					continue;
 				}
 
-				// Handle mesh building specific to the current voxel's 
-				// block_id.
+				// Grow the face along the first axis of it's plane.
 
-				if (is_cross(voxel_id) || is_crop(voxel_id) || is_fire(voxel_id))
-				{
-					// Get the face_info* object that matches the block_id of 
-					// the current voxel.
+				unsigned int w = 1;
 
-					face_info* cube_face_info = block_face_info[voxel_id];
+				while (a + w < res[p] && keys[i + w * strides[p]] == key)
+				{
+					w++;
+				}
 
-					// Get the layer (w coordinate) corresponding to every 
-					// face of the current voxel.
+				// Grow the face along the second axis of it's plane, one
+				// row at a time.
 
-					float layer_all = cube_face_info->l_top;
+				unsigned int h = 1;
 
-					// Calculate the lighting value of every face by using the
-					// maximum lighting component of the current voxel.
+				for (; b + h < res[q]; h++)
+				{
+					size_t row = i + h * strides[q];
 
-					float lighting_all = std::max(input->get_natural(cx, cy, cz) / 15.0f, input->get_artificial(cx, cy, cz) / 15.0f);
+					unsigned int k = 0;
 
-					// Generate all of the faces and write them to the target 
-					// array, using ptr as a 'stream writer'.
+					while (k < w && keys[row + k * strides[p]] == key)
+					{
+						k++;
+					}
 
-					if (is_fire(voxel_id))
+					if (k < w)
 					{
-						layer_all = -layer_all;
+						break;
+					}
+				}
+
+				for (unsigned int j = 0; j < h; j++)
+				for (unsigned int k = 0; k < w; k++)
+				{
+					keys[i + j * strides[q] + k * strides[p]] = 0;
+				}
 
-						{
-							// Face 1.
+				// Write the merged face.
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				unsigned int start[3];
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				start[n] = s;
+				start[p] = a;
+				start[q] = b;
 
-							// Face 2.
+				unsigned int size[3] = {1, 1, 1};
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				size[p] = w;
+				size[q] = h;
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+				unsigned int light = (key - 1) & 15;
 
-						{
-							// Face 3.
+				float layer = float(((key - 1) >> 4) - 1);
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				ptr = write_box_face(ptr, face_id, x + start[0], y + start[1], z + start[2], size[0], size[1], size[2], layer, face_lighting(face_id, light));
+			}
+		}
+	}
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+	return ptr;
+}
 
-							// Face 4.
+// Convert a subset of a world into a vertex array, reading it's voxels
+// through voxels (a world_voxels or a mesh_halo). The generated vertex array
+// is stored in target, and it's size in floats is stored in
+// target_size_in_floats.
+//
+// Every face is written as a quad of 4 vertices, whose triangles are it's
+// corners 0, 1, 2 and 0, 2, 3, like the indices of the quad index buffer.
+// Each vertex is 7 floats: X, Y (pointing up), Z, U, V, the layer (negative
+// for animated textures), and the lighting value (see face_lighting).
+
+template <typename V>
+void voxels_to_mesh
+(
+	V& voxels,
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+	unsigned int x,
+	unsigned int y,
+	unsigned int z,
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+	unsigned int x_res,
+	unsigned int y_res,
+	unsigned int z_res,
 
-						{
-							float front_x = 1.0f / 16.0f;
+	float* target,
 
-							// Face 5.
+	unsigned int& target_size_in_floats
+)
+{
+	float* ptr = target;
 
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+	// Make room for the face_keys of every face of the subset.
 
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+	size_t voxel_count = size_t(x_res) * y_res * z_res;
 
-							// Face 6.
+	unsigned int slice_count = std::max(x_res, std::max(y_res, z_res));
 
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+	if (greedy_meshing && greedy_face_keys.size() < 6 * voxel_count)
+	{
+		greedy_face_keys.assign(6 * voxel_count, 0);
+	}
 
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+	if (greedy_meshing && greedy_slices.size() < 6 * slice_count)
+	{
+		greedy_slices.assign(6 * slice_count, 0);
+	}
 
-						{
-							float back_x = 15.0f / 16.0f;
+	// Walk the voxels of the subset in the order that they are stored in.
 
-							// Face 7.
+	voxels.for_each(x, y, z, x_res, y_res, z_res, [&](unsigned int cx, unsigned int cy, unsigned int cz, block_id voxel_id)
+	{
+		// Ignore voxels that have a block_id equivalent to id_air or 
+		// id_water.
 
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+		if (voxel_id == id_air || voxel_id == id_water)
+		{
+			return;
+		}
 
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+		// Handle mesh building specific to the current voxel's 
+		// block_id.
 
-							// Face 8.
+		if (is_cross(voxel_id) || is_crop(voxel_id) || is_fire(voxel_id))
+		{
+			// Get the face_info that matches the block_id of 
+			// the current voxel.
 
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+			face_info& cube_face_info = block_face_info[voxel_id];
 
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+			// Get the layer (w coordinate) corresponding to every 
+			// face of the current voxel.
 
-						{
-							float front_z = 1.0f / 16.0f;
+			float layer_all = cube_face_info.l_top;
 
-							// Face 9.
+			// Calculate the lighting value of every face by using the
+			// maximum lighting component of the current voxel, with the
+			// lighting coefficient of top faces.
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+			float lighting_all = face_lighting(0, std::max(voxels.get_natural(cx, cy, cz), voxels.get_artificial(cx, cy, cz)));
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+			// Generate all of the faces and write them to the target 
+			// array, using ptr as a 'stream writer'.
 
-							// Face 10.
+			if (is_fire(voxel_id))
+			{
+				layer_all = -layer_all;
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				{
+					// Face 1.
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-						{
-							float back_z = 15.0f / 16.0f;
+					// Face 2.
 
-							// Face 11.
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				{
+					// Face 3.
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-							// Face 12.
+					// Face 4.
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
-					}
-					else if (is_cross(voxel_id))
-					{
-						{
-							// Face 1.
+				{
+					float front_x = 1.0f / 16.0f;
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 5.
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-							// Face 2.
+					// Face 6.
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+				{
+					float back_x = 15.0f / 16.0f;
 
-						{
-							// Face 3.
+					// Face 7.
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 8.
 
-							// Face 4.
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				{
+					float front_z = 1.0f / 16.0f;
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
-					}
-					else
-					{
-						{
-							float front_x = 4.0f / 16.0f;
+					// Face 9.
 
-							// Face 1.
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 10.
 
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							// Face 2.
+				{
+					float back_z = 15.0f / 16.0f;
 
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 11.
 
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-						{
-							float back_x = 12.0f / 16.0f;
+					// Face 12.
 
-							// Face 3.
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
+			}
+			else if (is_cross(voxel_id))
+			{
+				{
+					// Face 1.
 
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 2.
 
-							// Face 4.
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				{
+					// Face 3.
 
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-						{
-							float front_z = 4.0f / 16.0f;
+					// Face 4.
 
-							// Face 5.
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
+			}
+			else
+			{
+				{
+					float front_x = 4.0f / 16.0f;
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 1.
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-							// Face 6.
+					// Face 2.
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = front_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
+				{
+					float back_x = 12.0f / 16.0f;
 
-						{
-							float back_z = 12.0f / 16.0f;
+					// Face 3.
 
-							// Face 7.
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 4.
 
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = back_x + cx; *(ptr++) = -0.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
 
-							// Face 8.
+				{
+					float front_z = 4.0f / 16.0f;
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					// Face 5.
 
-							*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-							*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
-						}
-					}
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+
+					// Face 6.
+
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = front_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 				}
-				else
+
 				{
-					// Get the face_info* object that matches the block_id of 
-					// the current voxel.
+					float back_z = 12.0f / 16.0f;
 
-					face_info* cube_face_info = block_face_info[voxel_id];
+					// Face 7.
 
-					// Get the layer (w coordinate) corresponding to each face
-					// of the current voxel.
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
 
-					float layer_top = cube_face_info->l_top;
+					// Face 8.
 
-					float layer_bottom = cube_face_info->l_bottom;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 1.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+					*(ptr++) = 0.0f + cx; *(ptr++) = -0.0f - cy; *(ptr++) = back_z + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_all; *(ptr++) = lighting_all;
+				}
+			}
+		}
+		else
+		{
+			// Get the face_info that matches the block_id of 
+			// the current voxel.
 
-					float layer_left = cube_face_info->l_left;
+			face_info& cube_face_info = block_face_info[voxel_id];
 
-					float layer_right = cube_face_info->l_right;
+			// Get the layer (w coordinate) corresponding to each face
+			// of the current voxel.
 
-					float layer_front = cube_face_info->l_front;
+			float layer_top = cube_face_info.l_top;
 
-					float layer_back = cube_face_info->l_back;
+			float layer_bottom = cube_face_info.l_bottom;
 
-					// Calculate the lighting value of each face by 
-					// multiplying the final lighting value of the neighboring
-					// voxels by a constant coefficient.
+			float layer_left = cube_face_info.l_left;
 
-					float lighting_top = 1.0f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy - 1, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy - 1, cz) / 15.0f);
+			float layer_right = cube_face_info.l_right;
 
-					float lighting_bottom = 0.65f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy + 1, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy + 1, cz) / 15.0f);
+			float layer_front = cube_face_info.l_front;
 
-					float lighting_left = 0.75f * std::max(input->get_natural_edge(cx, cy, cz, cx - 1, cy, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx - 1, cy, cz) / 15.0f);
+			float layer_back = cube_face_info.l_back;
 
-					float lighting_right = 0.75f * std::max(input->get_natural_edge(cx, cy, cz, cx + 1, cy, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx + 1, cy, cz) / 15.0f);
+			// Find the light level of each face, which is the final
+			// lighting value of the neighboring voxel.
 
-					float lighting_front = 0.9f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy, cz - 1) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy, cz - 1) / 15.0f);
+			unsigned char light_top = std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy - 1, cz), voxels.get_artificial_edge(cx, cy, cz, cx, cy - 1, cz));
 
-					float lighting_back = 0.9f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy, cz + 1) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy, cz + 1) / 15.0f);
+			unsigned char light_bottom = std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy + 1, cz), voxels.get_artificial_edge(cx, cy, cz, cx, cy + 1, cz));
 
-					// Do hidden face culling. This optimization will cause 
-					// faces that are never going to be rendered (hidden 
-					// faces) to be culled.
+			unsigned char light_left = std::max(voxels.get_natural_edge(cx, cy, cz, cx - 1, cy, cz), voxels.get_artificial_edge(cx, cy, cz, cx - 1, cy, cz));
 
-					bool visible_top = show_face(voxel_id, input->get_id_safe(cx, cy - 1, cz), 0);
+			unsigned char light_right = std::max(voxels.get_natural_edge(cx, cy, cz, cx + 1, cy, cz), voxels.get_artificial_edge(cx, cy, cz, cx + 1, cy, cz));
 
-					bool visible_bottom = show_face(voxel_id, input->get_id_safe(cx, cy + 1, cz), 1);
+			unsigned char light_front = std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy, cz - 1), voxels.get_artificial_edge(cx, cy, cz, cx, cy, cz - 1));
 
-					bool visible_left = show_face(voxel_id, input->get_id_safe(cx - 1, cy, cz), 2);
+			unsigned char light_back = std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy, cz + 1), voxels.get_artificial_edge(cx, cy, cz, cx, cy, cz + 1));
 
-					bool visible_right = show_face(voxel_id, input->get_id_safe(cx + 1, cy, cz), 3);
+			// Calculate the lighting value of each face from it's
+			// light level and it's lighting coefficient.
 
-					bool visible_front = show_face(voxel_id, input->get_id_safe(cx, cy, cz - 1), 4);
+			float lighting_top = face_lighting(0, light_top);
 
-					bool visible_back = show_face(voxel_id, input->get_id_safe(cx, cy, cz + 1), 5);
+			float lighting_bottom = face_lighting(1, light_bottom);
 
-					// Find the height of the current block.
+			float lighting_left = face_lighting(2, light_left);
 
-					float vtx_high = 0.0f;
+			float lighting_right = face_lighting(3, light_right);
 
-					float tex_high = 0.0f;
+			float lighting_front = face_lighting(4, light_front);
 
-					if (is_slab(voxel_id))
-					{
-						// Slabs are half as tall as a normal block, and 
-						// reside on the bottom half of their unit cube.
+			float lighting_back = face_lighting(5, light_back);
 
-						vtx_high = 0.5f;
+			// Do hidden face culling. This optimization will cause 
+			// faces that are never going to be rendered (hidden 
+			// faces) to be culled.
 
-						tex_high = 0.5f;
+			bool visible_top = show_face(voxel_id, voxels.get_id(cx, cy - 1, cz), 0);
 
-						// Slab tops cannot be hidden.
+			bool visible_bottom = show_face(voxel_id, voxels.get_id(cx, cy + 1, cz), 1);
 
-						visible_top = true;
-					}
+			bool visible_left = show_face(voxel_id, voxels.get_id(cx - 1, cy, cz), 2);
 
-					// Generate visible faces and write them to the target 
-					// array, using ptr as a 'stream writer'.
+			bool visible_right = show_face(voxel_id, voxels.get_id(cx + 1, cy, cz), 3);
 
-					if (visible_top)
-					{
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+			bool visible_front = show_face(voxel_id, voxels.get_id(cx, cy, cz - 1), 4);
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-					}
+			bool visible_back = show_face(voxel_id, voxels.get_id(cx, cy, cz + 1), 5);
 
-					if (visible_bottom)
-					{
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-						
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-					}
+			// The visible faces of full cubes are recorded, and merged
+			// with their neighbors once every voxel was walked.
 
-					if (visible_left)
-					{
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+			if (greedy_meshing && !is_slab(voxel_id))
+			{
+				size_t i = (cx - x) + x_res * ((cy - y) + y_res * (cz - z));
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+				face_key* keys = greedy_face_keys.data();
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+				unsigned char* slices = greedy_slices.data();
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+				if (visible_top)
+				{
+					keys[i] = make_face_key(layer_top, light_top);
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_left; *(ptr++) = lighting_left;
-					}
+					slices[cy - y] = 1;
+				}
 
-					if (visible_right)
-					{
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+				if (visible_bottom)
+				{
+					keys[voxel_count + i] = make_face_key(layer_bottom, light_bottom);
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+					slices[slice_count + cy - y] = 1;
+				}
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+				if (visible_left)
+				{
+					keys[2 * voxel_count + i] = make_face_key(layer_left, light_left);
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+					slices[2 * slice_count + cx - x] = 1;
+				}
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_right; *(ptr++) = lighting_right;
-					}
+				if (visible_right)
+				{
+					keys[3 * voxel_count + i] = make_face_key(layer_right, light_right);
 
-					if (visible_front)
-					{
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+					slices[3 * slice_count + cx - x] = 1;
+				}
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+				if (visible_front)
+				{
+					keys[4 * voxel_count + i] = make_face_key(layer_front, light_front);
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+					slices[4 * slice_count + cz - z] = 1;
+				}
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+				if (visible_back)
+				{
+					keys[5 * voxel_count + i] = make_face_key(layer_back, light_back);
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_front; *(ptr++) = lighting_front;
-					}
+					slices[5 * slice_count + cz - z] = 1;
+				}
 
-					if (visible_back)
-					{
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+				return;
+			}
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+			// Find the height of the current block.
 
-						*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+			float vtx_high = 0.0f;
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+			float tex_high = 0.0f;
 
-						*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_back; *(ptr++) = lighting_back;
-					}
-				}
+			if (is_slab(voxel_id))
+			{
+				// Slabs are half as tall as a normal block, and 
+				// reside on the bottom half of their unit cube.
+
+				vtx_high = 0.5f;
+
+				tex_high = 0.5f;
+
+				// Slab tops cannot be hidden.
+
+				visible_top = true;
+			}
+
+			// Generate visible faces and write them to the target 
+			// array, using ptr as a 'stream writer'.
+
+			if (visible_top)
+			{
+				*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+			}
+
+			if (visible_bottom)
+			{
+				*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+			}
+
+			if (visible_left)
+			{
+				*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+			}
+
+			if (visible_right)
+			{
+				*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+			}
+
+			if (visible_front)
+			{
+				*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+			}
+
+			if (visible_back)
+			{
+				*(ptr++) = 1.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = tex_high; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+				*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+				*(ptr++) = 0.0f + cx; *(ptr++) = -vtx_high - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = tex_high; *(ptr++) = layer_back; *(ptr++) = lighting_back;
 			}
 		}
+	});
+
+	// Merge the faces of the full cubes.
+
+	if (greedy_meshing)
+	{
+		ptr = write_greedy_faces(ptr, x, y, z, x_res, y_res, z_res);
 	}
 
 	// Calculate the amount of floats that were written to target, and store
@@ -545,13 +1084,15 @@ void world_subset_to_mesh
 	target_size_in_floats = ptr - target;
 }
 
-// Convert a subset of a world into a water vertex array. The generated water
-// vertex array is stored in water_target, and it's size in floats is stored 
+// Convert a subset of a world into a water vertex array, reading it's
+// voxels through voxels (a world_voxels or a mesh_halo). The generated water
+// vertex array is stored in water_target, and it's size in floats is stored
 // in water_target_size_in_floats.
 
-void world_subset_to_water_mesh
+template <typename V>
+void voxels_to_water_mesh
 (
-	world* input,
+	V& voxels,
 
 	unsigned int x,
 	unsigned int y,
@@ -568,177 +1109,234 @@ void world_subset_to_water_mesh
 {
 	float* ptr = water_target;
 
-	unsigned int fx = x + x_res;
-	unsigned int fy = y + y_res;
-	unsigned int fz = z + z_res;
+	// Walk the voxels of the subset in the order that they are stored in.
 
-	for (unsigned int cx = x; cx < fx; cx++)
+	voxels.for_each(x, y, z, x_res, y_res, z_res, [&](unsigned int cx, unsigned int cy, unsigned int cz, block_id voxel_id)
 	{
-		for (unsigned int cy = y; cy < fy; cy++)
+		// Ignore voxels that have a block_id that is not equivalent
+		// to water.
+
+		if (voxel_id != id_water)
 		{
-			for (unsigned int cz = z; cz < fz; cz++)
-			{
-				// Skip voxels that are out of bounds.
+			return;
+		}
 
-				if (!input->in_bounds(cx, cy, cz))
-				{
-					continue;
-				}
+		// Get the face_info that matches the block_id of the
+		// current voxel.
 
-				// Get the current voxel's block_id.
+		face_info& cube_face_info = block_face_info[voxel_id];
 
-				block_id voxel_id = input->get_id(cx, cy, cz);
+		// Get the layer (w coordinate) corresponding to each face of 
+		// the current voxel.
 
-				// Ignore voxels that have a block_id that is not equivalent
-				// to water.
+		float layer_top = -cube_face_info.l_top;
 
-				if (voxel_id != id_water)
-				{
-					continue;
-				}
+		float layer_bottom = -cube_face_info.l_bottom;
 
-				// Get the face_info* object that matches the block_id of the
-				// current voxel.
+		float layer_left = -cube_face_info.l_left;
 
-				face_info* cube_face_info = block_face_info[voxel_id];
+		float layer_right = -cube_face_info.l_right;
 
-				// Get the layer (w coordinate) corresponding to each face of 
-				// the current voxel.
+		float layer_front = -cube_face_info.l_front;
 
-				float layer_top = -cube_face_info->l_top;
+		float layer_back = -cube_face_info.l_back;
 
-				float layer_bottom = -cube_face_info->l_bottom;
+		// Calculate the lighting value of each face from the final
+		// lighting value of the neighboring voxels and the face's
+		// lighting coefficient.
 
-				float layer_left = -cube_face_info->l_left;
+		float lighting_top = face_lighting(0, std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy - 1, cz), voxels.get_artificial_edge(cx, cy, cz, cx, cy - 1, cz)));
 
-				float layer_right = -cube_face_info->l_right;
+		float lighting_bottom = face_lighting(1, std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy + 1, cz), voxels.get_artificial_edge(cx, cy, cz, cx, cy + 1, cz)));
 
-				float layer_front = -cube_face_info->l_front;
+		float lighting_left = face_lighting(2, std::max(voxels.get_natural_edge(cx, cy, cz, cx - 1, cy, cz), voxels.get_artificial_edge(cx, cy, cz, cx - 1, cy, cz)));
 
-				float layer_back = -cube_face_info->l_back;
+		float lighting_right = face_lighting(3, std::max(voxels.get_natural_edge(cx, cy, cz, cx + 1, cy, cz), voxels.get_artificial_edge(cx, cy, cz, cx + 1, cy, cz)));
 
-				// Calculate the lighting value of each face by multiplying 
-				// the final lighting value of the neighboring voxels by a 
-				// constant coefficient.
+		float lighting_front = face_lighting(4, std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy, cz - 1), voxels.get_artificial_edge(cx, cy, cz, cx, cy, cz - 1)));
 
-				float lighting_top = 1.0f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy - 1, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy - 1, cz) / 15.0f);
+		float lighting_back = face_lighting(5, std::max(voxels.get_natural_edge(cx, cy, cz, cx, cy, cz + 1), voxels.get_artificial_edge(cx, cy, cz, cx, cy, cz + 1)));
 
-				float lighting_bottom = 0.65f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy + 1, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy + 1, cz) / 15.0f);
+		// Do hidden face culling. This optimization will cause faces
+		// that are never going to be rendered (hidden faces) to be 
+		// culled.
 
-				float lighting_left = 0.75f * std::max(input->get_natural_edge(cx, cy, cz, cx - 1, cy, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx - 1, cy, cz) / 15.0f);
+		bool visible_top = show_face(voxel_id, voxels.get_id(cx, cy - 1, cz), 0);
 
-				float lighting_right = 0.75f * std::max(input->get_natural_edge(cx, cy, cz, cx + 1, cy, cz) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx + 1, cy, cz) / 15.0f);
+		bool visible_bottom = show_face(voxel_id, voxels.get_id(cx, cy + 1, cz), 1);
 
-				float lighting_front = 0.9f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy, cz - 1) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy, cz - 1) / 15.0f);
+		bool visible_left = show_face(voxel_id, voxels.get_id(cx - 1, cy, cz), 2);
 
-				float lighting_back = 0.9f * std::max(input->get_natural_edge(cx, cy, cz, cx, cy, cz + 1) / 15.0f, input->get_artificial_edge(cx, cy, cz, cx, cy, cz + 1) / 15.0f);
+		bool visible_right = show_face(voxel_id, voxels.get_id(cx + 1, cy, cz), 3);
 
-				// Do hidden face culling. This optimization will cause faces
-				// that are never going to be rendered (hidden faces) to be 
-				// culled.
+		bool visible_front = show_face(voxel_id, voxels.get_id(cx, cy, cz - 1), 4);
 
-				bool visible_top = show_face(voxel_id, input->get_id_safe(cx, cy - 1, cz), 0);
+		bool visible_back = show_face(voxel_id, voxels.get_id(cx, cy, cz + 1), 5);
 
-				bool visible_bottom = show_face(voxel_id, input->get_id_safe(cx, cy + 1, cz), 1);
+		// Top level water should be rendered as a short block (15/16 pixels tall).
 
-				bool visible_left = show_face(voxel_id, input->get_id_safe(cx - 1, cy, cz), 2);
+		float top_level_water = 0.0f;
 
-				bool visible_right = show_face(voxel_id, input->get_id_safe(cx + 1, cy, cz), 3);
+		// Generate visible faces and write them to the target array,
+		// using ptr as a 'stream writer'.
 
-				bool visible_front = show_face(voxel_id, input->get_id_safe(cx, cy, cz - 1), 4);
+		if (visible_top)
+		{
+			*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+		}
 
-				bool visible_back = show_face(voxel_id, input->get_id_safe(cx, cy, cz + 1), 5);
+		if (visible_bottom)
+		{
+			*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+		}
 
-				// Top level water should be rendered as a short block (15/16 pixels tall).
+		if (visible_left)
+		{
+			*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+		}
 
-				float top_level_water = 0.0f;
+		if (visible_right)
+		{
+			*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+		}
 
-				// Generate visible faces and write them to the target array,
-				// using ptr as a 'stream writer'.
+		if (visible_front)
+		{
+			*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+		}
 
-				if (visible_top)
-				{
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
+		if (visible_back)
+		{
+			*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+			*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+			*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+		}
+	});
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_top; *(ptr++) = lighting_top;
-				}
+	// Calculate the amount of floats that were written to water_target, and 
+	// store that value in water_target_size_in_floats.
 
-				if (visible_bottom)
-				{
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
+	water_target_size_in_floats = ptr - water_target;
+}
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_bottom; *(ptr++) = lighting_bottom;
-				}
+// Convert a subset of a world into a vertex array. The generated vertex 
+// array is stored in target, and it's size in floats is stored in 
+// target_size_in_floats.
 
-				if (visible_left)
-				{
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+void world_subset_to_mesh
+(
+	world* input,
+
+	unsigned int x,
+	unsigned int y,
+	unsigned int z,
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+	unsigned int x_res,
+	unsigned int y_res,
+	unsigned int z_res,
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+	float* target,
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
+	unsigned int& target_size_in_floats
+)
+{
+	// Uniform sections of air or water have nothing to add to this mesh, and
+	// uniform sections that are hidden by their neighbors can be skipped 
+	// without checking each voxel.
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_left; *(ptr++) = lighting_left;
-				}
+	block_id uniform_id = uniform_subset_id(input, x, y, z, x_res, y_res, z_res);
 
-				if (visible_right)
-				{
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+	if (uniform_id == id_air || uniform_id == id_water || uniform_subset_is_hidden(input, x, y, z, x_res, y_res, z_res))
+	{
+		target_size_in_floats = 0;
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+		return;
+	}
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+	// A subset that is exactly one section is decoded into a mesh_halo once,
+	// instead of unpacking each voxel and it's neighbors up to seven times.
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
+	if (is_section_subset(input, x, y, z, x_res, y_res, z_res))
+	{
+		mesh_halo halo;
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_right; *(ptr++) = lighting_right;
-				}
+		halo.load(input, x, y, z);
 
-				if (visible_front)
-				{
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+		voxels_to_mesh(halo, x, y, z, x_res, y_res, z_res, target, target_size_in_floats);
+	}
+	else
+	{
+		world_voxels voxels = {input};
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+		voxels_to_mesh(voxels, x, y, z, x_res, y_res, z_res, target, target_size_in_floats);
+	}
+}
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+// Convert a subset of a world into a water vertex array. The generated water
+// vertex array is stored in water_target, and it's size in floats is stored 
+// in water_target_size_in_floats.
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
+void world_subset_to_water_mesh
+(
+	world* input,
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 0.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_back; *(ptr++) = lighting_back;
-				}
+	unsigned int x,
+	unsigned int y,
+	unsigned int z,
 
-				if (visible_back)
-				{
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+	unsigned int x_res,
+	unsigned int y_res,
+	unsigned int z_res,
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+	float* water_target,
 
-					*(ptr++) = 1.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 1.0f; *(ptr++) = 0.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+	unsigned int& water_target_size_in_floats
+)
+{
+	// Uniform sections of anything but water have nothing to add to this
+	// mesh, and neither do uniform sections of water that are hidden by their
+	// neighbors.
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -1.0f - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 1.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
+	block_id uniform_id = uniform_subset_id(input, x, y, z, x_res, y_res, z_res);
 
-					*(ptr++) = 0.0f + cx; *(ptr++) = -top_level_water - cy; *(ptr++) = 1.0f + cz; *(ptr++) = 0.0f; *(ptr++) = 0.0f; *(ptr++) = layer_front; *(ptr++) = lighting_front;
-				}
-			}
-		}
+	if ((uniform_id != id_null && uniform_id != id_water) || uniform_subset_is_hidden(input, x, y, z, x_res, y_res, z_res))
+	{
+		water_target_size_in_floats = 0;
+
+		return;
 	}
 
-	// Calculate the amount of floats that were written to water_target, and 
-	// store that value in water_target_size_in_floats.
+	// A subset that is exactly one section is decoded into a mesh_halo once,
+	// instead of unpacking each voxel and it's neighbors up to seven times.
 
-	water_target_size_in_floats = ptr - water_target;
-}
\ No newline at end of file
+	if (is_section_subset(input, x, y, z, x_res, y_res, z_res))
+	{
+		mesh_halo halo;
+
+		halo.load(input, x, y, z);
+
+		voxels_to_water_mesh(halo, x, y, z, x_res, y_res, z_res, water_target, water_target_size_in_floats);
+	}
+	else
+	{
+		world_voxels voxels = {input};
+
+		voxels_to_water_mesh(voxels, x, y, z, x_res, y_res, z_res, water_target, water_target_size_in_floats);
+	}
+}
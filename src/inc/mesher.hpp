@@ -0,0 +1,363 @@
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+// A mesher struct meshes the modified chunks of an accessor on a pool of
+// threads of it's own, so that the frames that change many chunks at once
+// (like spreading fire or growing trees) do not stall the main thread. The
+// chunks are meshed from a snapshot of the world, so the world keeps
+// changing while they are, and only uploading the meshes to the GPU happens
+// on the main thread.
+
+// The modified chunks that a mesher finds in one frame are meshed from the
+// same snapshot of the world, which is deallocated by the thread that meshes
+// the last of them.
+
+struct mesh_batch
+{
+	world* snapshot;
+
+	std::atomic<size_t> remaining;
+};
+
+// A chunk that a mesher meshes again. The id of a mesh_job is stored in the
+// chunk while the job runs, so if the chunk is deallocated (or replaced)
+// before the job is done, the job's chunk_mesh is thrown away.
+
+struct mesh_job
+{
+	mesh_batch* batch;
+
+	unsigned long long id;
+
+	size_t chunk_index;
+
+	unsigned int x;
+	unsigned int y;
+	unsigned int z;
+
+	chunk_mesh* the_mesh;
+};
+
+struct mesher
+{
+	std::vector<std::thread> workers;
+
+	// The jobs that no thread has started yet, and the jobs that are done
+	// but were not uploaded yet, guarded by lock.
+
+	std::mutex lock;
+
+	std::condition_variable wake;
+
+	std::deque<mesh_job> queued_jobs;
+
+	std::vector<mesh_job> finished_jobs;
+
+	bool stopping;
+
+	// The jobs that were taken from finished_jobs but were not uploaded yet,
+	// because the frame's upload budget was spent. These are only used by
+	// the main thread.
+
+	std::deque<mesh_job> ready_jobs;
+
+	// The amount of jobs that were started but not uploaded (or thrown away)
+	// yet, and the id of the last job.
+
+	size_t jobs_in_flight;
+
+	unsigned long long last_job;
+
+	// The most jobs that may be in flight at once.
+
+	size_t max_jobs_in_flight;
+};
+
+// Let a mesh_job's mesh_batch know that the job is done with it's snapshot.
+
+inline void release_mesh_batch(mesh_batch* the_batch)
+{
+	if (the_batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		deallocate_world(the_batch->snapshot);
+
+		delete the_batch;
+	}
+}
+
+// Mesh the queued jobs of a mesher*. This runs on the mesher's own threads.
+
+void run_mesher(mesher* the_mesher)
+{
+	while (true)
+	{
+		mesh_job job;
+
+		{
+			std::unique_lock<std::mutex> guard(the_mesher->lock);
+
+			the_mesher->wake.wait(guard, [&]()
+			{
+				return the_mesher->stopping || !the_mesher->queued_jobs.empty();
+			});
+
+			if (the_mesher->stopping)
+			{
+				return;
+			}
+
+			job = the_mesher->queued_jobs.front();
+
+			the_mesher->queued_jobs.pop_front();
+		}
+
+		job.the_mesh = allocate_chunk_mesh(job.batch->snapshot, job.x, job.y, job.z, 16, 16, 16);
+
+		release_mesh_batch(job.batch);
+
+		job.batch = nullptr;
+
+		{
+			std::lock_guard<std::mutex> guard(the_mesher->lock);
+
+			the_mesher->finished_jobs.push_back(job);
+		}
+	}
+}
+
+// Create a mesher* and start it's threads.
+
+mesher* allocate_mesher()
+{
+	mesher* the_mesher = new mesher();
+
+	the_mesher->stopping = false;
+
+	the_mesher->jobs_in_flight = 0;
+
+	the_mesher->last_job = 0;
+
+	// One hardware thread is left to the main thread, which keeps running
+	// the game.
+
+	unsigned int thread_count = std::max(1u, parallel_threads - 1);
+
+	// Every thread is given a few jobs at a time, so it has the next one
+	// ready while the main thread uploads the last ones.
+
+	the_mesher->max_jobs_in_flight = size_t(thread_count) * 4;
+
+	for (unsigned int i = 0; i < thread_count; i++)
+	{
+		the_mesher->workers.push_back(std::thread(run_mesher, the_mesher));
+	}
+
+	return the_mesher;
+}
+
+// Upload the chunks that a mesher* has meshed to the GPU, at most max_uploads
+// of them, and then start meshing the modified chunks of an accessor*.
+// Chunks that are modified again while they are meshed stay modified, and
+// are meshed again once their first mesh is uploaded.
+
+void update_mesher(mesher* the_mesher, accessor* the_accessor, unsigned int max_uploads)
+{
+	world* the_world = the_accessor->the_world;
+
+	{
+		std::lock_guard<std::mutex> guard(the_mesher->lock);
+
+		for (mesh_job& job: the_mesher->finished_jobs)
+		{
+			the_mesher->ready_jobs.push_back(job);
+		}
+
+		the_mesher->finished_jobs.clear();
+	}
+
+	unsigned int uploads = 0;
+
+	while (!the_mesher->ready_jobs.empty() && uploads < max_uploads)
+	{
+		mesh_job job = the_mesher->ready_jobs.front();
+
+		the_mesher->ready_jobs.pop_front();
+
+		the_mesher->jobs_in_flight--;
+
+		chunk*& the_chunk = the_accessor->the_chunks[job.chunk_index];
+
+		if (the_chunk && the_chunk->mesh_job == job.id)
+		{
+			chunk* new_chunk = allocate_chunk(job.the_mesh);
+
+			// Keep the changes that were made while the chunk was meshed.
+
+			new_chunk->modified = the_chunk->modified;
+
+			new_chunk->changes = the_chunk->changes;
+
+			memcpy(new_chunk->changed_voxels, the_chunk->changed_voxels, sizeof(new_chunk->changed_voxels));
+
+			deallocate_chunk(the_chunk);
+
+			the_chunk = new_chunk;
+
+			uploads++;
+		}
+
+		deallocate_chunk_mesh(job.the_mesh);
+	}
+
+	// Find the modified chunks that are not being meshed yet.
+
+	if (the_mesher->jobs_in_flight >= the_mesher->max_jobs_in_flight)
+	{
+		return;
+	}
+
+	std::vector<mesh_job> new_jobs;
+
+	for (size_t i = 0; i < the_accessor->chunk_count; i++)
+	{
+		chunk* the_chunk = the_accessor->the_chunks[i];
+
+		if (the_chunk && the_chunk->modified && the_chunk->mesh_job == 0)
+		{
+			// Changes that can not change the chunk's meshes are dropped.
+
+			if (!chunk_needs_meshing(the_world, the_chunk))
+			{
+				the_chunk->modified = false;
+
+				the_chunk->changes = 0;
+
+				memset(the_chunk->changed_voxels, 0, sizeof(the_chunk->changed_voxels));
+
+				continue;
+			}
+
+			mesh_job job;
+
+			job.batch = nullptr;
+
+			job.id = ++the_mesher->last_job;
+
+			job.chunk_index = i;
+
+			job.x = the_chunk->x;
+			job.y = the_chunk->y;
+			job.z = the_chunk->z;
+
+			job.the_mesh = nullptr;
+
+			new_jobs.push_back(job);
+
+			// The changes are recorded again from now on.
+
+			the_chunk->mesh_job = job.id;
+
+			the_chunk->modified = false;
+
+			the_chunk->changes = 0;
+
+			memset(the_chunk->changed_voxels, 0, sizeof(the_chunk->changed_voxels));
+
+			if (the_mesher->jobs_in_flight + new_jobs.size() == the_mesher->max_jobs_in_flight)
+			{
+				break;
+			}
+		}
+	}
+
+	if (new_jobs.empty())
+	{
+		return;
+	}
+
+	// Only the columns of the new jobs' chunks, and the columns next to them,
+	// which the meshes of their borders look into, are snapshotted.
+
+	std::vector<unsigned int> snapshot_columns;
+
+	for (mesh_job& job: new_jobs)
+	{
+		int cx = job.x / 16;
+		int cz = job.z / 16;
+
+		for (int nz = std::max(cz - 1, 0); nz <= std::min(cz + 1, int(the_world->chunk_z_res) - 1); nz++)
+		for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, int(the_world->chunk_x_res) - 1); nx++)
+		{
+			snapshot_columns.push_back(nx + the_world->chunk_x_res * nz);
+		}
+	}
+
+	mesh_batch* the_batch = new mesh_batch();
+
+	the_batch->snapshot = snapshot_world(the_world, snapshot_columns);
+
+	the_batch->remaining = new_jobs.size();
+
+	{
+		std::lock_guard<std::mutex> guard(the_mesher->lock);
+
+		for (mesh_job& job: new_jobs)
+		{
+			job.batch = the_batch;
+
+			the_mesher->queued_jobs.push_back(job);
+		}
+	}
+
+	the_mesher->jobs_in_flight += new_jobs.size();
+
+	the_mesher->wake.notify_all();
+}
+
+// Check if a mesher* has no jobs in flight.
+
+inline bool mesher_idle(mesher* the_mesher)
+{
+	return the_mesher->jobs_in_flight == 0;
+}
+
+// Deallocate a mesher*. The jobs that were not uploaded yet are thrown away,
+// and the chunks that they were meshing stay as they are.
+
+void deallocate_mesher(mesher* to_be_annihilated)
+{
+	{
+		std::lock_guard<std::mutex> guard(to_be_annihilated->lock);
+
+		to_be_annihilated->stopping = true;
+	}
+
+	to_be_annihilated->wake.notify_all();
+
+	for (std::thread& worker: to_be_annihilated->workers)
+	{
+		worker.join();
+	}
+
+	for (mesh_job& job: to_be_annihilated->queued_jobs)
+	{
+		release_mesh_batch(job.batch);
+	}
+
+	for (mesh_job& job: to_be_annihilated->finished_jobs)
+	{
+		deallocate_chunk_mesh(job.the_mesh);
+	}
+
+	for (mesh_job& job: to_be_annihilated->ready_jobs)
+	{
+		deallocate_chunk_mesh(job.the_mesh);
+	}
+
+	delete to_be_annihilated;
+}
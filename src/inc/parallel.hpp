@@ -0,0 +1,198 @@
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+// The amount of threads that run_in_parallel uses, including the calling
+// thread. It defaults to the amount of threads that the hardware can run at
+// once.
+
+unsigned int parallel_threads = std::max(1u, std::thread::hardware_concurrency());
+
+// A call of run_in_parallel that the threads of the parallel_pool can help
+// with. It lives on the stack of the calling thread.
+
+struct parallel_job
+{
+	// Calls work(i), where work is the function that was given to
+	// run_in_parallel.
+
+	void (*call)(void* work, size_t i);
+
+	void* work;
+
+	size_t count;
+
+	// The next i that no thread has taken yet.
+
+	std::atomic<size_t> next;
+
+	// The amount of threads of the pool that may still start helping, and
+	// the amount of threads of the pool that are helping, guarded by the
+	// pool's lock.
+
+	size_t helpers_wanted;
+
+	size_t helpers;
+};
+
+// The threads that run_in_parallel spreads it's work over, besides the
+// calling thread. They are started the first time they are needed, and then
+// wait for the next call, so a call does not pay for starting threads.
+
+struct parallel_pool
+{
+	std::vector<std::thread> workers;
+
+	// The jobs that may still take helpers, guarded by lock.
+
+	std::mutex lock;
+
+	std::deque<parallel_job*> jobs;
+
+	// Wakes the workers when a job is added, and the calling threads when a
+	// worker is done helping.
+
+	std::condition_variable wake;
+
+	std::condition_variable done;
+};
+
+// Take the next i of a parallel_job* and call work(i), until there are none
+// left. Threads that get cheap calls take more of them.
+
+inline void run_parallel_job(parallel_job* job)
+{
+	for (size_t i = job->next.fetch_add(1, std::memory_order_relaxed); i < job->count; i = job->next.fetch_add(1, std::memory_order_relaxed))
+	{
+		job->call(job->work, i);
+	}
+}
+
+// Help with the jobs of a parallel_pool*. This runs on the pool's own threads.
+
+void run_parallel_worker(parallel_pool* the_pool)
+{
+	std::unique_lock<std::mutex> guard(the_pool->lock);
+
+	while (true)
+	{
+		the_pool->wake.wait(guard, [&]()
+		{
+			return !the_pool->jobs.empty();
+		});
+
+		parallel_job* job = the_pool->jobs.front();
+
+		job->helpers++;
+
+		if (--job->helpers_wanted == 0)
+		{
+			the_pool->jobs.pop_front();
+		}
+
+		guard.unlock();
+
+		run_parallel_job(job);
+
+		guard.lock();
+
+		if (--job->helpers == 0)
+		{
+			the_pool->done.notify_all();
+		}
+	}
+}
+
+// Get the parallel_pool*, and start threads until it has at least
+// worker_count of them. The pool is never deallocated, so it's threads wait
+// for work until the game exits.
+
+parallel_pool* get_parallel_pool(size_t worker_count)
+{
+	static parallel_pool* the_pool = new parallel_pool();
+
+	std::lock_guard<std::mutex> guard(the_pool->lock);
+
+	while (the_pool->workers.size() < worker_count)
+	{
+		the_pool->workers.push_back(std::thread(run_parallel_worker, the_pool));
+	}
+
+	return the_pool;
+}
+
+// Call work(i) for every i from 0 to count - 1, spread over parallel_threads
+// threads (or over max_threads threads, if that is less). The calling thread
+// does it's share of the work, and returns once every call has returned. The
+// calls are made in no particular order, so each call must only change the
+// state that belongs to it's i. Results that are stored by i do not depend on
+// the amount of threads.
+//
+// The other threads come from the parallel_pool, which several threads may
+// call run_in_parallel on at once.
+
+template <typename F>
+void run_in_parallel(size_t count, F work, unsigned int max_threads = parallel_threads)
+{
+	size_t thread_count = std::min<size_t>(std::min(parallel_threads, max_threads), count);
+
+	if (thread_count <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			work(i);
+		}
+
+		return;
+	}
+
+	parallel_pool* the_pool = get_parallel_pool(parallel_threads - 1);
+
+	parallel_job job;
+
+	job.call = [](void* work, size_t i)
+	{
+		(*(F*)work)(i);
+	};
+
+	job.work = &work;
+
+	job.count = count;
+
+	job.next = 0;
+
+	job.helpers_wanted = thread_count - 1;
+
+	job.helpers = 0;
+
+	{
+		std::lock_guard<std::mutex> guard(the_pool->lock);
+
+		the_pool->jobs.push_back(&job);
+	}
+
+	the_pool->wake.notify_all();
+
+	run_parallel_job(&job);
+
+	// Every i was taken, so no more threads may start helping, and the ones
+	// that did are waited for.
+
+	std::unique_lock<std::mutex> guard(the_pool->lock);
+
+	auto queued = std::find(the_pool->jobs.begin(), the_pool->jobs.end(), &job);
+
+	if (queued != the_pool->jobs.end())
+	{
+		the_pool->jobs.erase(queued);
+	}
+
+	the_pool->done.wait(guard, [&]()
+	{
+		return job.helpers == 0;
+	});
+}
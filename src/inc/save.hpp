@@ -0,0 +1,555 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+// A level_save struct saves a world to a level directory on a thread of it's
+// own, so that the game keeps running while the world is saved. The thread
+// saves a snapshot of the world, so the world may keep changing, and every
+// region file that it writes replaces the previous one atomically, so a crash
+// during the save never leaves a partly written file behind.
+
+struct level_save
+{
+	// The snapshot of the world that is saved, and the information of the
+	// world that is not stored in it's columns.
+
+	world* snapshot;
+
+	unsigned int seed;
+
+	float player_x;
+	float player_y;
+	float player_z;
+
+	std::string path_to_level;
+
+	// The indices of the columns that are saved. If replace_file is true,
+	// path_to_level is a world file that was saved by save_world_to_file, and
+	// is replaced by a level directory once every column was saved.
+
+	std::vector<unsigned int> columns;
+
+	bool replace_file;
+
+	// The progress of the save. When done is true, succeeded tells if every
+	// column was saved.
+
+	std::atomic<size_t> columns_saved;
+
+	std::atomic<bool> done;
+
+	bool succeeded;
+
+	std::chrono::high_resolution_clock::time_point start_time;
+
+	std::thread worker;
+};
+
+// Save the columns of a level_save*. This runs on the level_save's own thread.
+
+void run_level_save(level_save* the_save)
+{
+	world* in = the_save->snapshot;
+
+	std::string path = the_save->path_to_level;
+
+	if (the_save->replace_file)
+	{
+		path = path + ".new";
+	}
+
+	make_directory(path);
+
+	// Group the columns by their region file, so that each region file is read
+	// and written once.
+
+	std::map<std::pair<unsigned int, unsigned int>, std::vector<unsigned int>> regions;
+
+	for (unsigned int column: the_save->columns)
+	{
+		unsigned int cx = column % in->chunk_x_res;
+		unsigned int cz = column / in->chunk_x_res;
+
+		regions[std::make_pair(cz / region_res, cx / region_res)].push_back(column);
+	}
+
+	the_save->succeeded = true;
+
+	// The columns of a world that was generated by generate_column are saved
+	// without their lighting information, like save_modified_columns does.
+
+	bool lighting = in->generator == generated_by_world;
+
+	// The game keeps running during the save, and the main thread and the
+	// threads of the mesher need the hardware threads as well, so the save
+	// only uses half of them (including it's own thread).
+
+	unsigned int save_threads = std::max(1u, parallel_threads / 2);
+
+	for (auto& region: regions)
+	{
+		std::string the_region_path = region_path(path, region.first.second * region_res * 16, region.first.first * region_res * 16);
+
+		// Keep the columns of the region that are not saved.
+
+		unsigned int flags;
+
+		std::vector<std::string> data;
+
+		if (!read_region_file(the_region_path, flags, data))
+		{
+			data.assign(region_columns, std::string());
+
+			flags = lighting ? region_lighting : 0;
+		}
+
+		// The columns of the region are compressed in parallel, on at most
+		// save_threads threads.
+
+		auto save_column = [&](size_t i)
+		{
+			unsigned int x = (region.second[i] % in->chunk_x_res) * 16;
+			unsigned int z = (region.second[i] / in->chunk_x_res) * 16;
+
+			data[region_index(x, z)] = write_column_data(in, x, z, lighting);
+
+			the_save->columns_saved.fetch_add(1, std::memory_order_relaxed);
+		};
+
+		run_in_parallel(region.second.size(), save_column, save_threads);
+
+		if (!write_region_file(the_region_path, flags, data))
+		{
+			the_save->succeeded = false;
+
+			break;
+		}
+	}
+
+	// The level information is saved last, so that a new level directory
+	// is only loaded once all of it's region files exist.
+
+	if (the_save->succeeded)
+	{
+		save_level_info(path, the_save->seed, in->generator, in->x_res, in->y_res, in->z_res, the_save->player_x, the_save->player_y, the_save->player_z);
+
+		if (the_save->replace_file && !replace_world_file(the_save->path_to_level))
+		{
+			the_save->succeeded = false;
+		}
+	}
+
+	deallocate_world(the_save->snapshot);
+
+	the_save->snapshot = nullptr;
+
+	the_save->done.store(true, std::memory_order_release);
+}
+
+// Start saving a world to the level directory at path_to_level in the
+// background. Only the columns that were modified since the world was last
+// saved are saved, unless there is no level directory at path_to_level yet.
+// Taking the snapshot of those columns only copies pointers, so this returns
+// quickly.
+
+level_save* start_level_save(world* in, unsigned int seed, float player_x, float player_y, float player_z, std::string path_to_level)
+{
+	level_save* the_save = new level_save();
+
+	the_save->seed = seed;
+
+	the_save->player_x = player_x;
+	the_save->player_y = player_y;
+	the_save->player_z = player_z;
+
+	the_save->path_to_level = path_to_level;
+
+	the_save->replace_file = is_file(path_to_level);
+
+	// The columns of a world that was generated by generate_column that
+	// were never modified are not saved, even in a new level directory.
+
+	bool save_everything = the_save->replace_file || (in->generator == generated_by_world && !std::ifstream(path_to_level + "/level.dat").good());
+
+	// The columns that are saved are no longer marked as modified. If the
+	// save fails, finish_level_save marks them again.
+
+	unsigned int slot_count = in->window_x_res * in->window_z_res;
+
+	for (unsigned int i = 0; i < slot_count; i++)
+	{
+		if (in->columns[i] != no_column && (save_everything || in->columns_modified[i]))
+		{
+			the_save->columns.push_back(in->columns[i]);
+
+			in->columns_modified[i] = false;
+		}
+	}
+
+	// Only the columns that are saved are snapshotted.
+
+	the_save->snapshot = snapshot_world(in, the_save->columns);
+
+	the_save->columns_saved = 0;
+
+	the_save->done = false;
+
+	the_save->succeeded = false;
+
+	the_save->start_time = std::chrono::high_resolution_clock::now();
+
+	the_save->worker = std::thread(run_level_save, the_save);
+
+	return the_save;
+}
+
+// Check if a level_save* is done.
+
+inline bool level_save_done(level_save* the_save)
+{
+	return the_save->done.load(std::memory_order_acquire);
+}
+
+// Get the progress of a level_save*, from 0 to 1.
+
+inline float level_save_progress(level_save* the_save)
+{
+	if (the_save->columns.empty())
+	{
+		return 1.0f;
+	}
+
+	return float(the_save->columns_saved.load(std::memory_order_relaxed)) / float(the_save->columns.size());
+}
+
+// Wait for a level_save* to be done, and deallocate it. If the save failed,
+// it's columns are marked as modified in the world again. Returns true if the
+// save succeeded.
+
+bool finish_level_save(world* in, level_save* the_save)
+{
+	the_save->worker.join();
+
+	bool succeeded = the_save->succeeded;
+
+	if (!succeeded)
+	{
+		for (unsigned int column: the_save->columns)
+		{
+			in->columns_modified[in->column_slot((column % in->chunk_x_res) * 16, (column / in->chunk_x_res) * 16)] = true;
+		}
+	}
+
+	delete the_save;
+
+	return succeeded;
+}
+
+// An autosave struct saves the modified columns of a singleplayer world
+// periodically, so that a crash only loses the changes since the last
+// autosave. Worlds with a fixed size are saved by a level_save on it's own
+// thread, so the frame that starts an autosave only takes a snapshot. The
+// columns of a streaming world are saved by the main thread, at most
+// columns_per_frame columns per frame, so the frame time stays flat.
+
+struct autosave
+{
+	world* the_world;
+
+	// The stream* of a streaming world, or nullptr.
+
+	stream* the_stream;
+
+	// The journal* of the world, or nullptr. It is rotated when an autosave
+	// starts, and the entries that it had then are removed once the autosave
+	// has succeeded.
+
+	journal* the_journal;
+
+	unsigned int seed;
+
+	std::string path_to_level;
+
+	// The time between the start of two autosaves. If it is 0, the world is
+	// only saved when an autosave is requested.
+
+	unsigned int interval_in_ms;
+
+	unsigned int columns_per_frame;
+
+	std::chrono::high_resolution_clock::time_point last_start;
+
+	// Whether an autosave is running, the slot that it continues at (for
+	// streaming worlds) and it's level_save* (for other worlds).
+
+	bool running;
+
+	bool requested;
+
+	bool succeeded;
+
+	unsigned int next_slot;
+
+	level_save* the_save;
+
+	// The cost of the running autosave, or of the last one once it is done.
+
+	size_t columns_saved;
+
+	unsigned int frames;
+
+	float frame_time_in_ms;
+
+	float max_frame_time_in_ms;
+
+	float total_time_in_ms;
+};
+
+// Allocate an autosave* that saves a world to the level directory at
+// path_to_level. If the world is a streaming world, it's stream* must be
+// given, and if edits to the world are journaled, it's journal* must be given.
+
+autosave* allocate_autosave(world* the_world, stream* the_stream, journal* the_journal, unsigned int seed, std::string path_to_level, unsigned int interval_in_ms, unsigned int columns_per_frame)
+{
+	autosave* the_autosave = new autosave();
+
+	the_autosave->the_world = the_world;
+
+	the_autosave->the_stream = the_stream;
+
+	the_autosave->the_journal = the_journal;
+
+	the_autosave->seed = seed;
+
+	the_autosave->path_to_level = path_to_level;
+
+	the_autosave->interval_in_ms = interval_in_ms;
+
+	the_autosave->columns_per_frame = std::max(columns_per_frame, 1u);
+
+	the_autosave->last_start = std::chrono::high_resolution_clock::now();
+
+	the_autosave->running = false;
+
+	the_autosave->requested = false;
+
+	the_autosave->the_save = nullptr;
+
+	return the_autosave;
+}
+
+// Start an autosave on the next call to update_autosave, if none is running.
+
+void request_autosave(autosave* the_autosave)
+{
+	the_autosave->requested = true;
+}
+
+// Get the progress of the running autosave of an autosave*, from 0 to 1.
+
+float autosave_progress(autosave* the_autosave)
+{
+	if (!the_autosave->running)
+	{
+		return 1.0f;
+	}
+
+	if (the_autosave->the_save)
+	{
+		return level_save_progress(the_autosave->the_save);
+	}
+
+	world* the_world = the_autosave->the_world;
+
+	return float(the_autosave->next_slot) / float(the_world->window_x_res * the_world->window_z_res);
+}
+
+// Continue the running autosave of an autosave*, or start a new one if it is
+// time to. This should be called once per frame. Returns true if an autosave
+// finished during this call.
+
+bool update_autosave(autosave* the_autosave, float player_x, float player_y, float player_z)
+{
+	std::chrono::high_resolution_clock::time_point frame_start = std::chrono::high_resolution_clock::now();
+
+	world* the_world = the_autosave->the_world;
+
+	if (!the_autosave->running)
+	{
+		float since_last_start = std::chrono::duration<float, std::milli>(frame_start - the_autosave->last_start).count();
+
+		if (!the_autosave->requested && (the_autosave->interval_in_ms == 0 || since_last_start < the_autosave->interval_in_ms))
+		{
+			return false;
+		}
+
+		// Start a new autosave.
+
+		the_autosave->running = true;
+
+		the_autosave->requested = false;
+
+		the_autosave->last_start = frame_start;
+
+		the_autosave->next_slot = 0;
+
+		the_autosave->columns_saved = 0;
+
+		the_autosave->frames = 0;
+
+		the_autosave->frame_time_in_ms = 0.0f;
+
+		the_autosave->max_frame_time_in_ms = 0.0f;
+
+		the_autosave->succeeded = true;
+
+		if (the_autosave->the_journal)
+		{
+			rotate_journal(the_autosave->the_journal);
+		}
+
+		if (the_autosave->the_stream)
+		{
+			save_level_info(the_autosave->path_to_level, the_autosave->seed, the_world->generator, 0, the_world->y_res, 0, player_x, player_y, player_z);
+		}
+		else
+		{
+			the_autosave->the_save = start_level_save(the_world, the_autosave->seed, player_x, player_y, player_z, the_autosave->path_to_level);
+
+			the_autosave->columns_saved = the_autosave->the_save->columns.size();
+		}
+	}
+
+	bool done;
+
+	if (the_autosave->the_save)
+	{
+		done = level_save_done(the_autosave->the_save);
+
+		if (done)
+		{
+			if (!finish_level_save(the_world, the_autosave->the_save))
+			{
+				std::cout << "Could not save the world to " << the_autosave->path_to_level << "." << std::endl;
+
+				the_autosave->succeeded = false;
+			}
+
+			the_autosave->the_save = nullptr;
+		}
+	}
+	else
+	{
+		// Save the next modified columns of the streaming world. Columns
+		// that are evicted before the autosave reaches them are saved by
+		// evict_column, or parked if that fails.
+
+		unsigned int slot_count = the_world->window_x_res * the_world->window_z_res;
+
+		unsigned int saved = 0;
+
+		while (the_autosave->next_slot < slot_count && saved < the_autosave->columns_per_frame)
+		{
+			unsigned int slot = the_autosave->next_slot++;
+
+			unsigned int column = the_world->columns[slot];
+
+			if (column != no_column && the_world->columns_modified[slot])
+			{
+				if (save_column_to_file(the_world, (column % the_world->chunk_x_res) * 16, (column / the_world->chunk_x_res) * 16, the_autosave->path_to_level))
+				{
+					the_world->columns_modified[slot] = false;
+				}
+				else
+				{
+					the_autosave->succeeded = false;
+				}
+
+				saved++;
+			}
+		}
+
+		the_autosave->columns_saved += saved;
+
+		done = the_autosave->next_slot == slot_count;
+
+		// The edits of parked columns are only on disk once the columns
+		// are saved, so the journal is kept if one of them is not.
+
+		if (done && !save_parked_columns(the_autosave->the_stream))
+		{
+			the_autosave->succeeded = false;
+		}
+	}
+
+	// Keep track of the cost of the autosave.
+
+	std::chrono::high_resolution_clock::time_point frame_end = std::chrono::high_resolution_clock::now();
+
+	float frame_time = std::chrono::duration<float, std::milli>(frame_end - frame_start).count();
+
+	the_autosave->frames++;
+
+	the_autosave->frame_time_in_ms += frame_time;
+
+	the_autosave->max_frame_time_in_ms = std::max(the_autosave->max_frame_time_in_ms, frame_time);
+
+	if (done)
+	{
+		the_autosave->running = false;
+
+		if (the_autosave->the_journal && the_autosave->succeeded)
+		{
+			remove_old_journal(the_autosave->the_journal);
+		}
+
+		the_autosave->total_time_in_ms = std::chrono::duration<float, std::milli>(frame_end - the_autosave->last_start).count();
+	}
+
+	return done;
+}
+
+// Deallocate an autosave*, after waiting for it's level_save* (if any) to
+// finish. The world and the stream are not deallocated.
+
+void deallocate_autosave(autosave* to_be_annihilated)
+{
+	if (to_be_annihilated->the_save)
+	{
+		finish_level_save(to_be_annihilated->the_world, to_be_annihilated->the_save);
+	}
+
+	delete to_be_annihilated;
+}
+
+// Replay the edits that were read from the journal of a level directory (see
+// read_journal) on the world of an accessor*. If the world is a streaming
+// world, it's stream* must be given, and the columns that the edits were made
+// in are made resident. The edits stay in the journal until the world is
+// saved, so the accessor* must not append them to it's journal* again.
+// Returns the amount of replayed edits.
+
+size_t replay_journal(accessor* the_accessor, stream* the_stream, const std::vector<journal_entry>& entries)
+{
+	world* the_world = the_accessor->the_world;
+
+	for (const journal_entry& entry: entries)
+	{
+		if (entry.x >= the_world->x_res || entry.y >= the_world->y_res || entry.z >= the_world->z_res)
+		{
+			continue;
+		}
+
+		if (the_stream && !the_world->column_resident(entry.x, entry.z))
+		{
+			make_column_resident(the_stream, entry.x, entry.z);
+		}
+
+		the_accessor->set_id_safe(entry.x, entry.y, entry.z, block_id(entry.new_id));
+	}
+
+	return entries.size();
+}
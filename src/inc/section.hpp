@@ -0,0 +1,906 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+// Allocate an array of 4096 4-bit values (2048 bytes), each set to value.
+
+unsigned char* allocate_nibbles(unsigned char value)
+{
+	unsigned char* nibbles = (unsigned char*)malloc(2048);
+
+	if (!nibbles)
+	{
+		std::cout << "Could not allocate enough memory for a new section." << std::endl;
+
+		exit(18);
+	}
+
+	memset(nibbles, (value & 0xf) | ((value & 0xf) << 4), 2048);
+
+	return nibbles;
+}
+
+// Get the table that section::set_ids uses to find the palette index of each
+// block_id, on this thread. It has an entry for every value of a palette
+// entry, and every entry is 0xffff between calls.
+
+std::vector<unsigned short>& palette_lookup()
+{
+	thread_local std::vector<unsigned short> lookup(65536, 0xffff);
+
+	return lookup;
+}
+
+// A section holds the voxels of one 16x16x16 brick of a world. The voxels are
+// ordered X first, then Y, then Z.
+//
+// The block_ids are not stored directly. Instead, each section has a small
+// palette of the block_ids it contains, and each voxel stores an index into
+// that palette. The indices are packed into 1, 2, 4, 8 or 16 bits each,
+// depending on the size of the palette, so a section that only contains air,
+// stone and dirt costs 2 bits per voxel instead of 8. When a block_id that is
+// not in the palette is placed and the palette is full, the indices are
+// repacked with twice as many bits.
+//
+// A section where every voxel has the same block_id is uniform. It uses 0
+// bits per voxel, and only stores that block_id in uniform_id. The palette and
+// the indices are allocated the first time a different block_id is placed.
+//
+// The natural and artificial lighting information is stored in two separate
+// arrays of 4-bit values. While every voxel in a section has the same
+// lighting value, the array is not allocated and only that value is kept.
+//
+// A section may be shared by a world and any number of it's snapshots. It is
+// only changed while it has one reference, see world::writable_section_at.
+
+struct section
+{
+	// The amount of worlds (and snapshots of worlds) that reference this
+	// section.
+
+	std::atomic<unsigned int> references;
+
+	// The palette of block_ids. It has room for 1 << bits entries, of which
+	// palette_size are used. It is nullptr if the section is uniform.
+
+	unsigned short* palette;
+
+	unsigned int palette_size;
+
+	// The block_id of every voxel, if the section is uniform.
+
+	unsigned short uniform_id;
+
+	// The amount of bits used by each packed index, or 0 if the section is
+	// uniform.
+
+	unsigned int bits;
+
+	// The packed indices (4096 * bits / 32 words), or nullptr if the section
+	// is uniform.
+
+	unsigned int* indices;
+
+	// The natural lighting information, or nullptr if every voxel has a
+	// natural lighting value of natural_uniform.
+
+	unsigned char* natural;
+
+	unsigned char natural_uniform;
+
+	// The artificial lighting information, or nullptr if every voxel has an
+	// artificial lighting value of artificial_uniform.
+
+	unsigned char* artificial;
+
+	unsigned char artificial_uniform;
+
+	// Get the palette index of the voxel at the specified index.
+
+	inline unsigned int get_index(unsigned int i)
+	{
+		if (bits == 0)
+		{
+			return 0;
+		}
+
+		unsigned int bit = i * bits;
+
+		return (indices[bit >> 5] >> (bit & 31)) & ((1u << bits) - 1);
+	}
+
+	// Set the palette index of the voxel at the specified index.
+
+	inline void set_index(unsigned int i, unsigned int entry)
+	{
+		unsigned int bit = i * bits;
+
+		unsigned int mask = ((1u << bits) - 1) << (bit & 31);
+
+		indices[bit >> 5] = (indices[bit >> 5] & ~mask) | (entry << (bit & 31));
+	}
+
+	// Repack the indices using the specified amount of bits. If the section
+	// is uniform, this allocates the palette and the indices.
+
+	void repack(unsigned int new_bits)
+	{
+		unsigned int* new_indices = (unsigned int*)calloc(4096 * new_bits / 32, sizeof(unsigned int));
+
+		unsigned short* new_palette = (unsigned short*)malloc((1u << new_bits) * sizeof(unsigned short));
+
+		if (!new_indices || !new_palette)
+		{
+			std::cout << "Could not allocate enough memory for a new section." << std::endl;
+
+			exit(18);
+		}
+
+		if (bits == 0)
+		{
+			new_palette[0] = uniform_id;
+		}
+		else
+		{
+			for (unsigned int i = 0; i < 4096; i++)
+			{
+				unsigned int bit = i * new_bits;
+
+				new_indices[bit >> 5] |= get_index(i) << (bit & 31);
+			}
+
+			memcpy(new_palette, palette, palette_size * sizeof(unsigned short));
+		}
+
+		free(indices);
+
+		free(palette);
+
+		indices = new_indices;
+
+		palette = new_palette;
+
+		bits = new_bits;
+	}
+
+	// Get the palette index of a block_id. If the block_id is not in the
+	// palette, it is added, and the indices are repacked if the palette is
+	// full.
+
+	inline unsigned int palette_entry(block_id id)
+	{
+		if (bits == 0)
+		{
+			if (uniform_id == id)
+			{
+				return 0;
+			}
+
+			repack(1);
+		}
+
+		for (unsigned int i = 0; i < palette_size; i++)
+		{
+			if (palette[i] == id)
+			{
+				return i;
+			}
+		}
+
+		if (palette_size == 1u << bits)
+		{
+			repack(bits * 2);
+		}
+
+		palette[palette_size] = id;
+
+		return palette_size++;
+	}
+
+	// Get the block_id information of the voxel at the specified index.
+
+	inline block_id get_id(unsigned int i)
+	{
+		if (bits == 0)
+		{
+			return block_id(uniform_id);
+		}
+
+		return block_id(palette[get_index(i)]);
+	}
+
+	// Set the block_id information of the voxel at the specified index.
+
+	inline void set_id(unsigned int i, block_id id)
+	{
+		if (bits == 0 && uniform_id == id)
+		{
+			return;
+		}
+
+		set_index(i, palette_entry(id));
+	}
+
+	// Get the natural lighting information of the voxel at the specified
+	// index.
+
+	inline unsigned char get_natural(unsigned int i)
+	{
+		if (!natural)
+		{
+			return natural_uniform;
+		}
+
+		return (natural[i >> 1] >> ((i & 1) << 2)) & 0xf;
+	}
+
+	// Set the natural lighting information of the voxel at the specified
+	// index.
+
+	inline void set_natural(unsigned int i, unsigned char value)
+	{
+		if (!natural)
+		{
+			if ((value & 0xf) == natural_uniform)
+			{
+				return;
+			}
+
+			natural = allocate_nibbles(natural_uniform);
+		}
+
+		unsigned int shift = (i & 1) << 2;
+
+		natural[i >> 1] = (natural[i >> 1] & ~(0xf << shift)) | ((value & 0xf) << shift);
+	}
+
+	// Get the artificial lighting information of the voxel at the specified
+	// index.
+
+	inline unsigned char get_artificial(unsigned int i)
+	{
+		if (!artificial)
+		{
+			return artificial_uniform;
+		}
+
+		return (artificial[i >> 1] >> ((i & 1) << 2)) & 0xf;
+	}
+
+	// Set the artificial lighting information of the voxel at the specified
+	// index.
+
+	inline void set_artificial(unsigned int i, unsigned char value)
+	{
+		if (!artificial)
+		{
+			if ((value & 0xf) == artificial_uniform)
+			{
+				return;
+			}
+
+			artificial = allocate_nibbles(artificial_uniform);
+		}
+
+		unsigned int shift = (i & 1) << 2;
+
+		artificial[i >> 1] = (artificial[i >> 1] & ~(0xf << shift)) | ((value & 0xf) << shift);
+	}
+
+	// Decode the block_id information of every voxel into an array of 4096
+	// values, as wide as the palette entries. Only the packed indices are
+	// read, so loops that only need the block_ids do not touch any lighting
+	// information.
+
+	void get_ids(unsigned short* ids)
+	{
+		if (bits == 0)
+		{
+			std::fill(ids, ids + 4096, uniform_id);
+
+			return;
+		}
+
+		unsigned int mask = (1u << bits) - 1;
+
+		for (unsigned int w = 0; w < 4096 * bits / 32; w++)
+		{
+			unsigned int word = indices[w];
+
+			for (unsigned int k = 0; k < 32 / bits; k++)
+			{
+				*ids++ = palette[word & mask];
+
+				word >>= bits;
+			}
+		}
+	}
+
+	// Check that the section only holds valid block_ids, and that every packed
+	// index points at an entry of the palette that is in use. Sections that
+	// were read from a file are checked, so that corrupt data can not make
+	// get_id read palette entries that were never filled.
+
+	bool valid()
+	{
+		if (bits == 0)
+		{
+			return uniform_id < id_null;
+		}
+
+		for (unsigned int i = 0; i < palette_size; i++)
+		{
+			if (palette[i] >= id_null)
+			{
+				return false;
+			}
+		}
+
+		unsigned int mask = (1u << bits) - 1;
+
+		for (unsigned int w = 0; w < 4096 * bits / 32; w++)
+		{
+			unsigned int word = indices[w];
+
+			for (unsigned int k = 0; k < 32 / bits; k++)
+			{
+				if ((word & mask) >= palette_size)
+				{
+					return false;
+				}
+
+				word >>= bits;
+			}
+		}
+
+		return true;
+	}
+
+	// Replace the block_id information of every voxel with an array of 4096
+	// values, as wide as the palette entries. The palette is rebuilt from
+	// scratch, so the section ends up as small as it can be.
+
+	void set_ids(const unsigned short* ids)
+	{
+		// Find the palette index of every block_id that is used. The lookup
+		// table of this thread covers every possible block_id, and only the
+		// entries of the block_ids that were found are set back afterwards.
+
+		std::vector<unsigned short>& lookup = palette_lookup();
+
+		unsigned short new_palette[4096];
+
+		unsigned int new_palette_size = 0;
+
+		for (unsigned int i = 0; i < 4096; i++)
+		{
+			if (lookup[ids[i]] == 0xffff)
+			{
+				lookup[ids[i]] = new_palette_size;
+
+				new_palette[new_palette_size++] = ids[i];
+			}
+		}
+
+		if (new_palette_size == 1)
+		{
+			lookup[ids[0]] = 0xffff;
+
+			fill(block_id(ids[0]));
+
+			return;
+		}
+
+		// Pack the indices with as few bits as possible.
+
+		unsigned int new_bits = 1;
+
+		while ((1u << new_bits) < new_palette_size)
+		{
+			new_bits *= 2;
+		}
+
+		unsigned int* new_indices = (unsigned int*)malloc(4096 * new_bits / 8);
+
+		unsigned short* new_palette_copy = (unsigned short*)malloc((1u << new_bits) * sizeof(unsigned short));
+
+		if (!new_indices || !new_palette_copy)
+		{
+			std::cout << "Could not allocate enough memory for a new section." << std::endl;
+
+			exit(18);
+		}
+
+		for (unsigned int w = 0; w < 4096 * new_bits / 32; w++)
+		{
+			unsigned int word = 0;
+
+			for (unsigned int k = 0; k < 32 / new_bits; k++)
+			{
+				word |= lookup[*ids++] << (k * new_bits);
+			}
+
+			new_indices[w] = word;
+		}
+
+		for (unsigned int i = 0; i < new_palette_size; i++)
+		{
+			lookup[new_palette[i]] = 0xffff;
+		}
+
+		memcpy(new_palette_copy, new_palette, new_palette_size * sizeof(unsigned short));
+
+		free(indices);
+
+		free(palette);
+
+		indices = new_indices;
+
+		palette = new_palette_copy;
+
+		palette_size = new_palette_size;
+
+		bits = new_bits;
+	}
+
+	// Set the block_id information of every voxel, which makes the section
+	// uniform.
+
+	void fill(block_id id)
+	{
+		free(indices);
+
+		free(palette);
+
+		indices = nullptr;
+
+		palette = nullptr;
+
+		palette_size = 1;
+
+		bits = 0;
+
+		uniform_id = id;
+	}
+
+	// Set the palette index of count voxels, starting at the specified index.
+	// Whole words of indices are written at once.
+
+	void fill_run(unsigned int i, unsigned int count, unsigned int entry)
+	{
+		unsigned int pattern = 0;
+
+		for (unsigned int b = 0; b < 32; b += bits)
+		{
+			pattern |= entry << b;
+		}
+
+		unsigned int bit = i * bits;
+
+		unsigned int end = (i + count) * bits;
+
+		while (bit < end && (bit & 31))
+		{
+			set_index(bit / bits, entry);
+
+			bit += bits;
+		}
+
+		while (end - bit >= 32)
+		{
+			indices[bit >> 5] = pattern;
+
+			bit += 32;
+		}
+
+		while (bit < end)
+		{
+			set_index(bit / bits, entry);
+
+			bit += bits;
+		}
+	}
+
+	// Change every packed index that is equal to from into to. Whole words of
+	// indices are compared at once.
+
+	void replace_entry(unsigned int from, unsigned int to)
+	{
+		// The highest bit of every index, and the remaining bits.
+
+		unsigned int high = 0;
+
+		unsigned int from_pattern = 0;
+
+		unsigned int to_pattern = 0;
+
+		for (unsigned int b = 0; b < 32; b += bits)
+		{
+			high |= 1u << (b + bits - 1);
+
+			from_pattern |= from << b;
+
+			to_pattern |= to << b;
+		}
+
+		unsigned int low = ~high;
+
+		unsigned int mask = (1u << bits) - 1;
+
+		for (unsigned int w = 0; w < 4096 * bits / 32; w++)
+		{
+			// Indices that are equal to from become 0 in difference. The 
+			// highest bit of every non-zero index is then set in non_zero,
+			// without carrying into the neighboring index.
+
+			unsigned int difference = indices[w] ^ from_pattern;
+
+			unsigned int non_zero = (((difference & low) + low) | difference) & high;
+
+			unsigned int equal = ((~non_zero & high) >> (bits - 1)) * mask;
+
+			indices[w] = (indices[w] & ~equal) | (to_pattern & equal);
+		}
+	}
+
+	// Decode the natural lighting information of every voxel into an array
+	// of 4096 bytes.
+
+	void get_naturals(unsigned char* values)
+	{
+		if (!natural)
+		{
+			memset(values, natural_uniform, 4096);
+
+			return;
+		}
+
+		for (unsigned int i = 0; i < 2048; i++)
+		{
+			values[i * 2 + 0] = natural[i] & 0xf;
+			values[i * 2 + 1] = natural[i] >> 4;
+		}
+	}
+
+	// Decode the artificial lighting information of every voxel into an
+	// array of 4096 bytes.
+
+	void get_artificials(unsigned char* values)
+	{
+		if (!artificial)
+		{
+			memset(values, artificial_uniform, 4096);
+
+			return;
+		}
+
+		for (unsigned int i = 0; i < 2048; i++)
+		{
+			values[i * 2 + 0] = artificial[i] & 0xf;
+			values[i * 2 + 1] = artificial[i] >> 4;
+		}
+	}
+
+	// Replace the natural lighting information of every voxel with an array
+	// of 4096 values. If every value is the same, the array is freed.
+
+	void set_naturals(const unsigned char* values)
+	{
+		unsigned int i = 1;
+
+		while (i < 4096 && values[i] == values[0])
+		{
+			i++;
+		}
+
+		if (i == 4096)
+		{
+			free(natural);
+
+			natural = nullptr;
+
+			natural_uniform = values[0] & 0xf;
+
+			return;
+		}
+
+		if (!natural)
+		{
+			natural = allocate_nibbles(0);
+		}
+
+		for (i = 0; i < 2048; i++)
+		{
+			natural[i] = (values[i * 2 + 0] & 0xf) | ((values[i * 2 + 1] & 0xf) << 4);
+		}
+	}
+
+	// Replace the artificial lighting information of every voxel with an array
+	// of 4096 values. If every value is the same, the array is freed.
+
+	void set_artificials(const unsigned char* values)
+	{
+		unsigned int i = 1;
+
+		while (i < 4096 && values[i] == values[0])
+		{
+			i++;
+		}
+
+		if (i == 4096)
+		{
+			free(artificial);
+
+			artificial = nullptr;
+
+			artificial_uniform = values[0] & 0xf;
+
+			return;
+		}
+
+		if (!artificial)
+		{
+			artificial = allocate_nibbles(0);
+		}
+
+		for (i = 0; i < 2048; i++)
+		{
+			artificial[i] = (values[i * 2 + 0] & 0xf) | ((values[i * 2 + 1] & 0xf) << 4);
+		}
+	}
+};
+
+// Allocate a uniform section* where every voxel is set to the specified
+// block_id and has no lighting.
+
+section* allocate_section(block_id id)
+{
+	section* new_section = new section();
+
+	new_section->bits = 0;
+
+	new_section->palette = nullptr;
+
+	new_section->indices = nullptr;
+
+	new_section->uniform_id = id;
+
+	new_section->palette_size = 1;
+
+	new_section->natural = nullptr;
+
+	new_section->natural_uniform = 0;
+
+	new_section->artificial = nullptr;
+
+	new_section->artificial_uniform = 0;
+
+	new_section->references = 1;
+
+	return new_section;
+}
+
+// Copy an array of 4096 4-bit values, if it is allocated.
+
+unsigned char* copy_nibbles(unsigned char* nibbles)
+{
+	if (!nibbles)
+	{
+		return nullptr;
+	}
+
+	unsigned char* new_nibbles = allocate_nibbles(0);
+
+	memcpy(new_nibbles, nibbles, 2048);
+
+	return new_nibbles;
+}
+
+// Allocate a new section* that holds the same voxels as an existing section*.
+
+section* copy_section(section* the_section)
+{
+	section* new_section = allocate_section(block_id(the_section->uniform_id));
+
+	if (the_section->bits != 0)
+	{
+		new_section->repack(the_section->bits);
+
+		memcpy(new_section->palette, the_section->palette, (1u << the_section->bits) * sizeof(unsigned short));
+
+		memcpy(new_section->indices, the_section->indices, 4096 * the_section->bits / 8);
+	}
+
+	new_section->palette_size = the_section->palette_size;
+
+	new_section->natural = copy_nibbles(the_section->natural);
+
+	new_section->natural_uniform = the_section->natural_uniform;
+
+	new_section->artificial = copy_nibbles(the_section->artificial);
+
+	new_section->artificial_uniform = the_section->artificial_uniform;
+
+	return new_section;
+}
+
+// Deallocate a section*.
+
+void deallocate_section(section* to_be_annihilated)
+{
+	free(to_be_annihilated->palette);
+
+	free(to_be_annihilated->indices);
+
+	free(to_be_annihilated->natural);
+
+	free(to_be_annihilated->artificial);
+
+	delete to_be_annihilated;
+}
+
+// Drop one reference to a section*, and deallocate it if that was the last
+// one. This may be called from any thread.
+
+void release_section(section* the_section)
+{
+	if (the_section->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		deallocate_section(the_section);
+	}
+}
+
+// If every value in an array of 4-bit values is the same, free the array and
+// store that value in uniform instead.
+
+void compact_nibbles(unsigned char*& nibbles, unsigned char& uniform)
+{
+	if (!nibbles)
+	{
+		return;
+	}
+
+	for (unsigned int i = 1; i < 2048; i++)
+	{
+		if (nibbles[i] != nibbles[0])
+		{
+			return;
+		}
+	}
+
+	if ((nibbles[0] & 0xf) != (nibbles[0] >> 4))
+	{
+		return;
+	}
+
+	uniform = nibbles[0] & 0xf;
+
+	free(nibbles);
+
+	nibbles = nullptr;
+}
+
+// Remove unused block_ids from the palette of a section*, repack its indices
+// with as few bits as possible, and drop its lighting arrays if they are
+// uniform.
+
+void compact_section(section* the_section)
+{
+	// Drop the lighting arrays if they are uniform.
+
+	compact_nibbles(the_section->natural, the_section->natural_uniform);
+
+	compact_nibbles(the_section->artificial, the_section->artificial_uniform);
+
+	if (the_section->bits == 0)
+	{
+		return;
+	}
+
+	// Find out which palette entries are still used, and give each of them a
+	// new palette index.
+
+	std::vector<int> remap(the_section->palette_size, -1);
+
+	for (unsigned int i = 0; i < 4096; i++)
+	{
+		remap[the_section->get_index(i)] = 0;
+	}
+
+	unsigned int new_palette_size = 0;
+
+	for (unsigned int i = 0; i < the_section->palette_size; i++)
+	{
+		if (remap[i] == 0)
+		{
+			the_section->palette[new_palette_size] = the_section->palette[i];
+
+			remap[i] = new_palette_size++;
+		}
+	}
+
+	// If only one block_id is left, make the section uniform.
+
+	if (new_palette_size == 1)
+	{
+		the_section->uniform_id = the_section->palette[0];
+
+		free(the_section->palette);
+
+		free(the_section->indices);
+
+		the_section->palette = nullptr;
+
+		the_section->indices = nullptr;
+
+		the_section->palette_size = 1;
+
+		the_section->bits = 0;
+
+		return;
+	}
+
+	// Find the smallest amount of bits that can hold the new palette.
+
+	unsigned int new_bits = 1;
+
+	while ((1u << new_bits) < new_palette_size)
+	{
+		new_bits *= 2;
+	}
+
+	// Repack the indices.
+
+	unsigned int* new_indices = (unsigned int*)calloc(4096 * new_bits / 32, sizeof(unsigned int));
+
+	if (!new_indices)
+	{
+		std::cout << "Could not allocate enough memory for a new section." << std::endl;
+
+		exit(18);
+	}
+
+	for (unsigned int i = 0; i < 4096; i++)
+	{
+		unsigned int bit = i * new_bits;
+
+		new_indices[bit >> 5] |= remap[the_section->get_index(i)] << (bit & 31);
+	}
+
+	free(the_section->indices);
+
+	the_section->indices = new_indices;
+
+	the_section->bits = new_bits;
+
+	the_section->palette = (unsigned short*)realloc(the_section->palette, (1u << new_bits) * sizeof(unsigned short));
+
+	the_section->palette_size = new_palette_size;
+}
+
+// Get the amount of bytes of memory used by a section*.
+
+unsigned int section_memory_usage(section* the_section)
+{
+	unsigned int bytes = sizeof(section);
+
+	if (the_section->bits != 0)
+	{
+		bytes += (1u << the_section->bits) * sizeof(unsigned short);
+
+		bytes += 4096 * the_section->bits / 8;
+	}
+
+	if (the_section->natural)
+	{
+		bytes += 2048;
+	}
+
+	if (the_section->artificial)
+	{
+		bytes += 2048;
+	}
+
+	return bytes;
+}
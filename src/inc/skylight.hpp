@@ -1,5 +1,61 @@
 #include <vector>
 #include <tuple>
+#include <algorithm>
+
+// Set the natural lighting information of every vertical strip of land in the
+// column of a world that holds the voxel at the specified X and Z
+// coordinates. Every voxel down to (and including) the highest block that is
+// not permeable to light is set to 15, and everything below it is set to 0.
+//
+// The highest block of each strip is read from the world's heightmap, so the
+// block_ids of the column are never read. Sections that are completely above
+// or below the highest block of every strip become uniform.
+
+void propagate_skylight_strips(world* out, unsigned int x, unsigned int z)
+{
+	unsigned int x0 = x & ~15u;
+	unsigned int z0 = z & ~15u;
+
+	unsigned short tops[256];
+
+	unsigned int min_top = out->y_res;
+	unsigned int max_top = 0;
+
+	for (unsigned int i = 0; i < 256; i++)
+	{
+		tops[i] = out->top_opaque(x0 + (i & 15), z0 + (i >> 4));
+
+		min_top = std::min(min_top, (unsigned int)tops[i]);
+		max_top = std::max(max_top, (unsigned int)tops[i]);
+	}
+
+	unsigned char naturals[4096];
+
+	for (unsigned int y0 = 0; y0 < out->y_res; y0 += 16)
+	{
+		if (y0 + 15 <= min_top)
+		{
+			memset(naturals, 15, 4096);
+		}
+		else if (y0 > max_top)
+		{
+			memset(naturals, 0, 4096);
+		}
+		else
+		{
+			// The voxels of a section are ordered X first, then Y, then Z.
+
+			for (unsigned int i = 0; i < 4096; i++)
+			{
+				unsigned int strip = (i & 15) | ((i >> 4) & 0xf0);
+
+				naturals[i] = y0 + ((i >> 4) & 15) <= tops[strip] ? 15 : 0;
+			}
+		}
+
+		out->writable_section_at(x0, y0, z0)->set_naturals(naturals);
+	}
+}
 
 // Propagate skylight throughout an entire world.
 
@@ -7,49 +63,63 @@ void propagate_skylight(world* out)
 {
 	// For each vertical strip of land, start with a lighting value of 15. Go
 	// downwards, if the block is permeable to light, stay at light level 15. 
-	// If not, set everything below it to 0. Add all X and Z neighbors to the 
-	// queue.
+	// If not, set everything below it to 0.
 
-	for (int x = 0; x < out->x_res; x++)
+	for (unsigned int x = 0; x < out->x_res; x += 16)
+	for (unsigned int z = 0; z < out->z_res; z += 16)
 	{
-		for (int z = 0; z < out->z_res; z++)
+		if (out->column_resident(x, z))
 		{
-			unsigned char natural = 15;
-
-			for (int y = 0; y < out->y_res; y++)
-			{
-				out->set_natural(x, y, z, natural);
-
-				if (is_not_permeable_light(out->get_id(x, y, z)))
-				{
-					natural = 0;
-				}
-			}
+			propagate_skylight_strips(out, x, z);
 		}
 	}
 
 	// All blocks that are of light level 0 that have one or more neighbors 
-	// that have a light level of 15 are added to the light_queue.
+	// that have a light level of 15 are added to the light_queue. In each
+	// strip, these are the block right below the highest block that is not
+	// permeable to light, and the blocks below it that are next to a lit
+	// block of a neighboring strip, so they are found using the heightmap.
 
 	std::vector<std::tuple<unsigned int, unsigned int, unsigned int>> light_queue;
 
-	for (unsigned int x = 0; x < out->x_res; x++)
-	for (unsigned int y = 0; y < out->y_res; y++)
-	for (unsigned int z = 0; z < out->z_res; z++)
+	for (unsigned int x0 = 0; x0 < out->x_res; x0 += 16)
+	for (unsigned int z0 = 0; z0 < out->z_res; z0 += 16)
 	{
-		if (out->get_natural(x, y, z) == 0)
+		if (!out->column_resident(x0, z0))
+		{
+			continue;
+		}
+
+		for (unsigned int x = x0; x < std::min(x0 + 16, out->x_res); x++)
+		for (unsigned int z = z0; z < std::min(z0 + 16, out->z_res); z++)
 		{
-			if 
-			(
-				out->get_natural_safe(x + 1, y, z) == 15 ||
-				out->get_natural_safe(x - 1, y, z) == 15 ||
+			unsigned int top = out->top_opaque(x, z);
 
-				out->get_natural_safe(x, y + 1, z) == 15 ||
-				out->get_natural_safe(x, y - 1, z) == 15 ||
+			unsigned int bottom = top + 2;
 
-				out->get_natural_safe(x, y, z + 1) == 15 ||
-				out->get_natural_safe(x, y, z - 1) == 15
-			)
+			if (out->in_bounds(x + 1, 0, z))
+			{
+				bottom = std::max(bottom, out->top_opaque(x + 1, z) + 1);
+			}
+
+			if (out->in_bounds(x - 1, 0, z))
+			{
+				bottom = std::max(bottom, out->top_opaque(x - 1, z) + 1);
+			}
+
+			if (out->in_bounds(x, 0, z + 1))
+			{
+				bottom = std::max(bottom, out->top_opaque(x, z + 1) + 1);
+			}
+
+			if (out->in_bounds(x, 0, z - 1))
+			{
+				bottom = std::max(bottom, out->top_opaque(x, z - 1) + 1);
+			}
+
+			bottom = std::min(bottom, out->y_res);
+
+			for (unsigned int y = top + 1; y < bottom; y++)
 			{
 				out->set_natural(x, y, z, 14);
 
@@ -130,8 +200,112 @@ void propagate_skylight(world* out)
 	}
 }
 
-// Propagate skylight throughout a vertical strip of a world. Set the modified
-// flag of every accessed chunk to true.
+// Propagate skylight throughout the column of a world that holds the voxel at
+// the specified X and Z coordinates. Light is exchanged with the resident 
+// columns around it, so this should be called whenever a column becomes 
+// resident.
+
+void propagate_skylight_column(world* out, unsigned int x, unsigned int z)
+{
+	unsigned int x0 = x & ~15u;
+	unsigned int z0 = z & ~15u;
+
+	// For each vertical strip of land in the column, start with a lighting
+	// value of 15. Go downwards, if the block is permeable to light, stay at
+	// light level 15. If not, set everything below it to 0.
+
+	propagate_skylight_strips(out, x0, z0);
+
+	// Add every voxel of the column, and every resident voxel that touches
+	// the column, to the light_queue. This lets light flow into the column 
+	// from it's neighbors, and out of the column into it's neighbors.
+
+	std::vector<std::tuple<unsigned int, unsigned int, unsigned int>> light_queue;
+
+	for (unsigned int cx = x0 - 1; cx != x0 + 17; cx++)
+	for (unsigned int cz = z0 - 1; cz != z0 + 17; cz++)
+	for (unsigned int y = 0; y < out->y_res; y++)
+	{
+		if (out->in_bounds(cx, y, cz))
+		{
+			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(cx, y, cz));
+		}
+	}
+
+	// Pop the top off of the queue. We'll call this the 'current block'. 
+	// Check it's six neighbors, if any of them have a light value less than 
+	// the current block's light value minus one, set that neighbors light 
+	// value to the current block's light value minus one, and add that 
+	// neighbor to the queue. Keep doing this until the queue is empty.
+
+	while (light_queue.size() > 0)
+	{
+		int x = std::get<0>(light_queue[light_queue.size() - 1]);
+		int y = std::get<1>(light_queue[light_queue.size() - 1]);
+		int z = std::get<2>(light_queue[light_queue.size() - 1]);
+
+		light_queue.pop_back();
+
+		unsigned char current_value = out->get_natural(x, y, z);
+
+		// Right neighbor.
+
+		if (out->in_bounds(x + 1, y, z) && out->get_natural(x + 1, y, z) < current_value - 1)
+		{
+			out->set_natural(x + 1, y, z, current_value - 1);
+
+			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x + 1, y, z));
+		}
+
+		// Left neighbor.
+
+		if (out->in_bounds(x - 1, y, z) && out->get_natural(x - 1, y, z) < current_value - 1)
+		{
+			out->set_natural(x - 1, y, z, current_value - 1);
+
+			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x - 1, y, z));
+		}
+
+		// Bottom neighbor.
+
+		if (out->in_bounds(x, y + 1, z) && out->get_natural(x, y + 1, z) < current_value - 1)
+		{
+			out->set_natural(x, y + 1, z, current_value - 1);
+
+			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y + 1, z));
+		}
+
+		// Top neighbor.
+
+		if (out->in_bounds(x, y - 1, z) && out->get_natural(x, y - 1, z) < current_value - 1)
+		{
+			out->set_natural(x, y - 1, z, current_value - 1);
+
+			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y - 1, z));
+		}
+
+		// Front neighbor.
+
+		if (out->in_bounds(x, y, z + 1) && out->get_natural(x, y, z + 1) < current_value - 1)
+		{
+			out->set_natural(x, y, z + 1, current_value - 1);
+
+			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y, z + 1));
+		}
+
+		// Back neighbor.
+
+		if (out->in_bounds(x, y, z - 1) && out->get_natural(x, y, z - 1) < current_value - 1)
+		{
+			out->set_natural(x, y, z - 1, current_value - 1);
+
+			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y, z - 1));
+		}
+	}
+}
+
+// Propagate skylight throughout a vertical strip of a world. Mark every voxel
+// whose lighting changed in it's chunk.
 
 void propagate_skylight_strip
 (
@@ -139,10 +313,6 @@ void propagate_skylight_strip
 
 	chunk**& the_chunks,
 
-	unsigned int chunk_x_res,
-	unsigned int chunk_y_res,
-	unsigned int chunk_z_res,
-
 	int cx,
 	int cz
 )
@@ -161,17 +331,20 @@ void propagate_skylight_strip
 	{
 		for (int z = cz; z < fz; z++)
 		{
-			unsigned char natural = 15;
+			int top = the_world->top_opaque(x, z);
 
 			for (int y = 0; y < the_world->y_res; y++)
 			{
-				the_world->set_natural(x, y, z, natural);
+				// Only voxels whose lighting actually changes mark their 
+				// chunk.
 
-				the_chunks[(x / 16) + chunk_x_res * ((y / 16) + chunk_y_res * (z / 16))]->modified = true;
+				unsigned char natural = y <= top ? 15 : 0;
 
-				if (is_not_permeable_light(the_world->get_id(x, y, z)))
+				if (the_world->get_natural(x, y, z) != natural)
 				{
-					natural = 0;
+					the_world->set_natural(x, y, z, natural);
+
+					mark_chunk_light_modified(the_world, the_chunks, x, y, z);
 				}
 
 				light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y, z));
@@ -207,7 +380,7 @@ void propagate_skylight_strip
 		{
 			the_world->set_natural_safe(x + 1, y, z, current_value - 1);
 
-			the_chunks[((x + 1) / 16) + chunk_x_res * ((y / 16) + chunk_y_res * (z / 16))]->modified = true;
+			mark_chunk_light_modified(the_world, the_chunks, x + 1, y, z);
 
 			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x + 1, y, z));
 		}
@@ -218,7 +391,7 @@ void propagate_skylight_strip
 		{
 			the_world->set_natural_safe(x - 1, y, z, current_value - 1);
 
-			the_chunks[((x - 1) / 16) + chunk_x_res * ((y / 16) + chunk_y_res * (z / 16))]->modified = true;
+			mark_chunk_light_modified(the_world, the_chunks, x - 1, y, z);
 
 			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x - 1, y, z));
 		}
@@ -229,7 +402,7 @@ void propagate_skylight_strip
 		{
 			the_world->set_natural_safe(x, y + 1, z, current_value - 1);
 
-			the_chunks[(x / 16) + chunk_x_res * (((y + 1) / 16) + chunk_y_res * (z / 16))]->modified = true;
+			mark_chunk_light_modified(the_world, the_chunks, x, y + 1, z);
 
 			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y + 1, z));
 		}
@@ -240,7 +413,7 @@ void propagate_skylight_strip
 		{
 			the_world->set_natural_safe(x, y - 1, z, current_value - 1);
 
-			the_chunks[(x / 16) + chunk_x_res * (((y - 1) / 16) + chunk_y_res * (z / 16))]->modified = true;
+			mark_chunk_light_modified(the_world, the_chunks, x, y - 1, z);
 
 			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y - 1, z));
 		}
@@ -251,7 +424,7 @@ void propagate_skylight_strip
 		{
 			the_world->set_natural_safe(x, y, z + 1, current_value - 1);
 
-			the_chunks[(x / 16) + chunk_x_res * ((y / 16) + chunk_y_res * ((z + 1) / 16))]->modified = true;
+			mark_chunk_light_modified(the_world, the_chunks, x, y, z + 1);
 
 			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y, z + 1));
 		}
@@ -262,7 +435,7 @@ void propagate_skylight_strip
 		{
 			the_world->set_natural_safe(x, y, z - 1, current_value - 1);
 
-			the_chunks[(x / 16) + chunk_x_res * ((y / 16) + chunk_y_res * ((z - 1) / 16))]->modified = true;
+			mark_chunk_light_modified(the_world, the_chunks, x, y, z - 1);
 
 			light_queue.push_back(std::tuple<unsigned int, unsigned int, unsigned int>(x, y, z - 1));
 		}
@@ -0,0 +1,381 @@
+#include <string>
+#include <unordered_map>
+
+// The largest radius (in columns) that a stream can keep around the player.
+
+const int max_stream_radius = 32;
+
+// A stream struct pages the columns of a streaming world in and out around
+// the player. Columns are loaded (or generated, if they were never saved) as
+// the player approaches them, get chunks once they are inside the render
+// distance, and are saved and evicted when the player moves away from them.
+// The memory used by a stream depends on the render distance, not on the
+// size of the world.
+
+struct stream
+{
+	accessor* the_accessor;
+
+	column_terrain* terrain;
+
+	// The level directory that columns are saved to. If it is empty, the
+	// columns that were modified are kept (compressed) in parked_columns when
+	// they are evicted, and all other columns are generated again when they
+	// are needed. Modified columns that could not be saved when they were
+	// evicted are parked too, until save_parked_columns saves them.
+
+	std::string path_to_level;
+
+	std::unordered_map<unsigned int, std::string> parked_columns;
+};
+
+// Allocate a world* that can be used by a stream.
+
+world* allocate_streaming_world(unsigned int y_res)
+{
+	// The window must hold every column that a stream keeps resident, which
+	// is every column within max_stream_radius + 2 columns of the player.
+
+	unsigned int window_res = 2 * (max_stream_radius + 2) + 1;
+
+	world* new_world = allocate_world_window(streaming_world_res, y_res, streaming_world_res, window_res, window_res);
+
+	new_world->generator = generated_by_column;
+
+	return new_world;
+}
+
+// Allocate a stream* that pages the columns of the world of an accessor*. If
+// path_to_level is empty, the columns are never saved to disk.
+
+stream* allocate_stream(accessor* the_accessor, unsigned int seed, std::string path_to_level)
+{
+	stream* the_stream = new stream();
+
+	the_stream->the_accessor = the_accessor;
+
+	the_stream->terrain = new column_terrain(seed, the_accessor->the_world->y_res);
+
+	the_stream->path_to_level = path_to_level;
+
+	return the_stream;
+}
+
+// Save the column in the specified slot, if it was modified, and then evict
+// it and destroy it's chunks. A modified column that cannot be saved is
+// parked instead, so that it's changes are not lost.
+
+void evict_column(stream* the_stream, unsigned int slot)
+{
+	world* the_world = the_stream->the_accessor->the_world;
+
+	unsigned int column = the_world->columns[slot];
+
+	if (column == no_column)
+	{
+		return;
+	}
+
+	unsigned int x = (column % the_world->chunk_x_res) * 16;
+	unsigned int z = (column / the_world->chunk_x_res) * 16;
+
+	if (the_world->columns_modified[slot])
+	{
+		if (the_stream->path_to_level.empty() || !save_column_to_file(the_world, x, z, the_stream->path_to_level))
+		{
+			the_stream->parked_columns[column] = write_column_data(the_world, x, z, false);
+		}
+	}
+
+	deallocate_column_chunks(the_stream->the_accessor, slot);
+
+	deallocate_column_slot(the_world, slot);
+}
+
+// Set the modified flag of every chunk of the column that holds the voxel at
+// the specified X and Z coordinates, if the column is resident. A neighboring
+// column was made resident, so every voxel is recorded as changed.
+
+void mark_column_modified(accessor* the_accessor, unsigned int x, unsigned int z)
+{
+	world* the_world = the_accessor->the_world;
+
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	{
+		mark_whole_chunk_modified(the_world, the_accessor->the_chunks, x, y, z, change_neighbor);
+	}
+}
+
+// Make the column that holds the voxel at the specified X and Z coordinates
+// resident, evicting the column that used it's slot (if any). The column is
+// loaded if it was saved before, and generated if it was not.
+
+void make_column_resident(stream* the_stream, unsigned int x, unsigned int z)
+{
+	world* the_world = the_stream->the_accessor->the_world;
+
+	unsigned int slot = the_world->column_slot(x, z);
+
+	evict_column(the_stream, slot);
+
+	allocate_column(the_world, x, z);
+
+	unsigned int column = (x >> 4) + the_world->chunk_x_res * (z >> 4);
+
+	std::unordered_map<unsigned int, std::string>::iterator parked = the_stream->parked_columns.find(column);
+
+	bool loaded = false;
+
+	if (parked != the_stream->parked_columns.end())
+	{
+		// The column was modified and parked. It stays modified, so that it
+		// is parked (or saved) again when it is evicted.
+
+		loaded = read_column_data(the_world, x, z, parked->second, false);
+
+		the_stream->parked_columns.erase(parked);
+
+		the_world->columns_modified[slot] = loaded;
+	}
+	else if (!the_stream->path_to_level.empty())
+	{
+		loaded = load_column_from_file(the_world, x, z, the_stream->path_to_level);
+	}
+
+	if (loaded)
+	{
+		propagate_skylight_column(the_world, x, z);
+
+		compact_column(the_world, x, z);
+	}
+	else
+	{
+		// Newly generated columns are not saved, because they can be
+		// generated again. Columns whose data is corrupt are generated
+		// again too.
+
+		generate_column(the_world, *the_stream->terrain, x, z);
+	}
+
+	// The faces and lighting at the edges of the neighboring columns may
+	// have changed.
+
+	mark_column_modified(the_stream->the_accessor, x - 16, z);
+	mark_column_modified(the_stream->the_accessor, x + 16, z);
+
+	mark_column_modified(the_stream->the_accessor, x, z - 16);
+	mark_column_modified(the_stream->the_accessor, x, z + 16);
+}
+
+// Check if the column that holds the voxel at the specified X and Z
+// coordinates is within the bounds of the world.
+
+inline bool column_in_bounds(world* the_world, unsigned int x, unsigned int z)
+{
+	return x < the_world->x_res && z < the_world->z_res;
+}
+
+// Update a stream* around the player. Columns further than radius + 2 columns
+// from the player are evicted, columns within radius + 1 columns are made
+// resident, and columns within radius columns get chunks. The closest columns
+// are handled first. The columns right around the player are always made
+// resident, everything else stops once budget_in_ms milliseconds have passed.
+
+void update_stream(stream* the_stream, float player_x, float player_z, int radius, unsigned int budget_in_ms)
+{
+	unsigned int start_time = SDL_GetTicks();
+
+	accessor* the_accessor = the_stream->the_accessor;
+
+	world* the_world = the_accessor->the_world;
+
+	if (radius > max_stream_radius)
+	{
+		radius = max_stream_radius;
+	}
+
+	int player_cx = int(player_x) >> 4;
+	int player_cz = int(player_z) >> 4;
+
+	// Evict the columns that are too far away.
+
+	unsigned int slot_count = the_world->window_x_res * the_world->window_z_res;
+
+	for (unsigned int i = 0; i < slot_count; i++)
+	{
+		unsigned int column = the_world->columns[i];
+
+		if (column == no_column)
+		{
+			continue;
+		}
+
+		int cx = column % the_world->chunk_x_res;
+		int cz = column / the_world->chunk_x_res;
+
+		if (abs(cx - player_cx) > radius + 2 || abs(cz - player_cz) > radius + 2)
+		{
+			evict_column(the_stream, i);
+		}
+	}
+
+	// Make the columns within radius + 1 columns resident, one ring at a
+	// time, starting at the player.
+
+	for (int ring = 0; ring <= radius + 1; ring++)
+	{
+		for (int dz = -ring; dz <= ring; dz++)
+		for (int dx = -ring; dx <= ring; dx++)
+		{
+			if (abs(dx) != ring && abs(dz) != ring)
+			{
+				continue;
+			}
+
+			unsigned int x = (player_cx + dx) * 16;
+			unsigned int z = (player_cz + dz) * 16;
+
+			if (!column_in_bounds(the_world, x, z) || the_world->column_resident(x, z))
+			{
+				continue;
+			}
+
+			if (ring > 1 && SDL_GetTicks() - start_time >= budget_in_ms)
+			{
+				return;
+			}
+
+			make_column_resident(the_stream, x, z);
+		}
+	}
+
+	// Create the chunks of the columns within radius columns whose neighbors
+	// are all resident, one ring at a time, starting at the player.
+
+	for (int ring = 0; ring <= radius; ring++)
+	{
+		for (int dz = -ring; dz <= ring; dz++)
+		for (int dx = -ring; dx <= ring; dx++)
+		{
+			if (abs(dx) != ring && abs(dz) != ring)
+			{
+				continue;
+			}
+
+			unsigned int x = (player_cx + dx) * 16;
+			unsigned int z = (player_cz + dz) * 16;
+
+			if (!column_in_bounds(the_world, x, z) || !the_world->column_resident(x, z))
+			{
+				continue;
+			}
+
+			if (the_accessor->the_chunks[the_world->section_index(x, 0, z)])
+			{
+				continue;
+			}
+
+			if
+			(
+				(column_in_bounds(the_world, x - 16, z) && !the_world->column_resident(x - 16, z)) ||
+				(column_in_bounds(the_world, x + 16, z) && !the_world->column_resident(x + 16, z)) ||
+
+				(column_in_bounds(the_world, x, z - 16) && !the_world->column_resident(x, z - 16)) ||
+				(column_in_bounds(the_world, x, z + 16) && !the_world->column_resident(x, z + 16))
+			)
+			{
+				continue;
+			}
+
+			if (SDL_GetTicks() - start_time >= budget_in_ms)
+			{
+				return;
+			}
+
+			allocate_column_chunks(the_accessor, x, z);
+		}
+	}
+}
+
+// Save the columns of a stream* that were parked because evict_column could
+// not save them, to it's level directory. The columns that were saved are no
+// longer parked. Returns false if a column could not be saved.
+
+bool save_parked_columns(stream* the_stream)
+{
+	world* the_world = the_stream->the_accessor->the_world;
+
+	bool saved = true;
+
+	std::unordered_map<unsigned int, std::string>::iterator parked = the_stream->parked_columns.begin();
+
+	while (parked != the_stream->parked_columns.end())
+	{
+		unsigned int x = (parked->first % the_world->chunk_x_res) * 16;
+		unsigned int z = (parked->first / the_world->chunk_x_res) * 16;
+
+		if (write_region_column(region_path(the_stream->path_to_level, x, z), region_index(x, z), parked->second, 0))
+		{
+			parked = the_stream->parked_columns.erase(parked);
+		}
+		else
+		{
+			std::cout << "Could not save a column to " << the_stream->path_to_level << "." << std::endl;
+
+			saved = false;
+
+			parked++;
+		}
+	}
+
+	return saved;
+}
+
+// Save every resident column of a stream* that was modified, the columns
+// that were parked because they could not be saved when they were evicted,
+// and the information of it's world that is not stored in it's columns.
+// Returns false if a column could not be saved.
+
+bool save_stream(stream* the_stream, float player_x, float player_y, float player_z)
+{
+	if (the_stream->path_to_level.empty())
+	{
+		return false;
+	}
+
+	world* the_world = the_stream->the_accessor->the_world;
+
+	save_level_info(the_stream->path_to_level, the_stream->terrain->seed, the_world->generator, 0, the_world->y_res, 0, player_x, player_y, player_z);
+
+	unsigned int slot_count = the_world->window_x_res * the_world->window_z_res;
+
+	bool saved = true;
+
+	for (unsigned int i = 0; i < slot_count; i++)
+	{
+		unsigned int column = the_world->columns[i];
+
+		if (column != no_column && the_world->columns_modified[i])
+		{
+			if (save_column_to_file(the_world, (column % the_world->chunk_x_res) * 16, (column / the_world->chunk_x_res) * 16, the_stream->path_to_level))
+			{
+				the_world->columns_modified[i] = false;
+			}
+			else
+			{
+				saved = false;
+			}
+		}
+	}
+
+	return save_parked_columns(the_stream) && saved;
+}
+
+// Deallocate a stream*. The accessor* and the world* are not deallocated.
+
+void deallocate_stream(stream* to_be_annihilated)
+{
+	delete to_be_annihilated->terrain;
+
+	delete to_be_annihilated;
+}
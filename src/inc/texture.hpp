@@ -21,6 +21,15 @@ GLuint load_block_texture_array()
 
 	GLsizei layers = all_tex.size();
 
+	// The vertices of chunks store the layer in 8 bits.
+
+	if (layers > 256)
+	{
+		std::cout << "Could not create a texture array of " << layers << " layers, at most 256 layers are supported." << std::endl;
+
+		exit(11);
+	}
+
 	// Allocate space for the texels.
 
 	GLubyte* texels = (GLubyte*)malloc(x_res * y_res * channels * layers * sizeof(GLubyte));
@@ -98,8 +107,11 @@ GLuint load_block_texture_array()
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	// The texture repeats, because the faces that the greedy mesher merges
+	// have texture coordinates that go past 1.
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
 	// Unbind the texture array from the current state.
 
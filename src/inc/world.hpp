@@ -1,18 +1,122 @@
 #include <iostream>
 #include <vector>
+#include <climits>
+#include <cassert>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
 
 // A world struct holds information about a world's dimensions and block data.
 // It makes it easy and efficient to modify and read the properties of every
 // voxel it contains.
+//
+// The voxels are stored in sections, one per 16x16x16 chunk. See section.hpp 
+// for the way each section stores its voxels.
+//
+// A world does not have to keep all of it's sections in memory. The sections
+// are grouped into columns, which are vertical stacks of sections, and only 
+// the columns inside a window of window_x_res by window_z_res columns are 
+// resident. Column (cx, cz) always lives in slot (cx % window_x_res, cz %
+// window_z_res) of the window, so a window that follows the player can page
+// columns in and out without moving any other columns. A fixed size world 
+// uses a window that is large enough to hold every column.
+//
+// Columns of a world can be snapshotted (see snapshot_world). A snapshot
+// shares the sections of those columns with the world, and the world copies a
+// shared section the first time it changes it, so the snapshot stays
+// consistent while the world keeps changing.
+//
+// Voxels are addressed through their section, so no index ever grows with
+// the total amount of voxels. Section and slot counts, which do, are 64-bit.
+// The tables of section pointers and heightmaps are allocated up front with
+// reserve_memory, which only gives them physical memory as they are touched,
+// and the sections of a new column all share one uniform id_air section until
+// they are changed, so huge worlds can be created without touching all of
+// their memory. On Windows, the tables do count against the commit limit in
+// full (see reserve_memory).
+//
+// Every resident column also keeps a heightmap of it's highest voxels, which
+// is updated whenever a voxel is changed, so that code which needs the top of
+// a column does not have to scan the column from Y = 0.
+
+// The value of an empty slot in world::columns.
+
+const unsigned int no_column = 0xffffffff;
+
+// The horizontal size of a streaming world. Streaming worlds are not limited 
+// by memory, only by the precision of the floating point player position.
+
+const unsigned int streaming_world_res = 1 << 16;
+
+// The ways that the columns of a world can have been generated. The columns
+// that generate_world generates depend on each other, so every column of such
+// a world must be saved. The columns that generate_column generates only
+// depend on the seed and their coordinates, so the columns of such a world
+// that were never modified are generated again when it is loaded, instead of
+// being saved. If generate_column ever changes the terrain it generates, it
+// needs a new value, so that older worlds do not change.
+
+const unsigned int generated_by_world = 0;
+const unsigned int generated_by_column = 1;
+
+// The heightmap of a column. For every X and Z coordinate in the column, it
+// stores the Y coordinate of the highest voxel that is not id_air, and of the
+// highest voxel that is not permeable to light, or y_res if there is no such
+// voxel. Y grows downwards, so the highest voxel has the lowest Y coordinate.
+
+struct column_heights
+{
+	unsigned short non_air[256];
+
+	unsigned short opaque[256];
+};
 
 struct world
 {
-	voxel* voxels;
+	section** sections;
 
 	unsigned int x_res;
 	unsigned int y_res;
 	unsigned int z_res;
 
+	// The number of sections along each axis.
+
+	unsigned int chunk_x_res;
+	unsigned int chunk_y_res;
+	unsigned int chunk_z_res;
+
+	// The number of column slots along the X and Z axes. Both are powers of 
+	// two.
+
+	unsigned int window_x_res;
+	unsigned int window_z_res;
+
+	// The index (cx + chunk_x_res * cz) of the column that is resident in 
+	// each slot, or no_column if the slot is empty.
+
+	unsigned int* columns;
+
+	// How the columns of the world were generated, generated_by_world or
+	// generated_by_column.
+
+	unsigned int generator;
+
+	// Whether the column in each slot was changed since it was generated or
+	// loaded.
+
+	bool* columns_modified;
+
+	// The heightmap of the column in each slot, or nullptr if the slot is
+	// empty or every voxel of the column has always been id_air. Snapshots
+	// do not have heightmaps, so this is nullptr in a snapshot.
+
+	column_heights** heights;
+
 	// A list of plants that are growing.
 
 	std::vector<growing_plant> growing_plants;
@@ -21,11 +125,258 @@ struct world
 
 	std::vector<burning_fire> burning_fires;
 
+	// Get the slot of the column that holds the voxel at the specified X and
+	// Z coordinates.
+
+	inline unsigned int column_slot(unsigned int x, unsigned int z)
+	{
+		return ((x >> 4) & (window_x_res - 1)) + window_x_res * ((z >> 4) & (window_z_res - 1));
+	}
+
+	// Check if the column that holds the voxel at the specified X and Z
+	// coordinates is resident.
+
+	inline bool column_resident(unsigned int x, unsigned int z)
+	{
+		return columns[column_slot(x, z)] == (x >> 4) + chunk_x_res * (z >> 4);
+	}
+
+	// Get the index of the section that holds the voxel at the specified 
+	// coordinates in sections. The chunks of an accessor use the same order.
+
+	inline size_t section_index(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return ((x >> 4) & (window_x_res - 1)) + size_t(window_x_res) * ((y >> 4) + size_t(chunk_y_res) * ((z >> 4) & (window_z_res - 1)));
+	}
+
+	// Get the index of the section with the specified Y coordinate (in 
+	// sections) of the column in the specified slot.
+
+	inline size_t slot_section_index(unsigned int slot, unsigned int cy)
+	{
+		return (slot & (window_x_res - 1)) + size_t(window_x_res) * (cy + size_t(chunk_y_res) * (slot / window_x_res));
+	}
+
+	// Get the section* that holds the voxel at the specified coordinates.
+
+	inline section* section_at(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return sections[section_index(x, y, z)];
+	}
+
+	// Get the section* that holds the voxel at the specified coordinates, so
+	// that it can be changed. If the section is shared with a snapshot, the
+	// world gets it's own copy first.
+
+	inline section* writable_section_at(unsigned int x, unsigned int y, unsigned int z)
+	{
+		section*& the_section = sections[section_index(x, y, z)];
+
+		if (the_section->references.load(std::memory_order_acquire) > 1)
+		{
+			section* copy = copy_section(the_section);
+
+			release_section(the_section);
+
+			the_section = copy;
+		}
+
+		return the_section;
+	}
+
+	// Get the index of the voxel at the specified coordinates inside of it's
+	// section.
+
+	inline unsigned int local_index(unsigned int x, unsigned int y, unsigned int z)
+	{
+		return (x & 15) | ((y & 15) << 4) | ((z & 15) << 8);
+	}
+
+	// Get the Y coordinate of the highest voxel at the specified X and Z
+	// coordinates that is not id_air, or y_res if there is none. The column
+	// must be resident, and the world must not be a snapshot.
+
+	inline unsigned int top_non_air(unsigned int x, unsigned int z)
+	{
+		assert(heights);
+
+		column_heights* the_heights = heights[column_slot(x, z)];
+
+		return the_heights ? the_heights->non_air[(x & 15) | ((z & 15) << 4)] : y_res;
+	}
+
+	// Get the Y coordinate of the highest voxel at the specified X and Z
+	// coordinates that is not permeable to light, or y_res if there is none.
+	// The column must be resident, and the world must not be a snapshot.
+
+	inline unsigned int top_opaque(unsigned int x, unsigned int z)
+	{
+		assert(heights);
+
+		column_heights* the_heights = heights[column_slot(x, z)];
+
+		return the_heights ? the_heights->opaque[(x & 15) | ((z & 15) << 4)] : y_res;
+	}
+
+	// Get the heightmap of the column that holds the voxel at the specified X
+	// and Z coordinates, so that it can be changed. A column that does not
+	// have a heightmap yet gets one, in which there is no highest voxel.
+
+	column_heights* writable_heights(unsigned int x, unsigned int z)
+	{
+		assert(heights);
+
+		column_heights*& the_heights = heights[column_slot(x, z)];
+
+		if (!the_heights)
+		{
+			the_heights = (column_heights*)malloc(sizeof(column_heights));
+
+			if (!the_heights)
+			{
+				std::cout << "Could not allocate enough memory for a new world." << std::endl;
+
+				exit(13);
+			}
+
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				the_heights->non_air[i] = y_res;
+
+				the_heights->opaque[i] = y_res;
+			}
+		}
+
+		return the_heights;
+	}
+
+	// Find the Y coordinate of the highest voxel between y0 and y1 (not
+	// including y1) at the specified X and Z coordinates that is not id_air,
+	// or that is not permeable to light if opaque is true. Returns y_res if
+	// there is none. Uniform sections are skipped as a whole.
+
+	unsigned int find_top(unsigned int x, unsigned int z, unsigned int y0, unsigned int y1, bool opaque)
+	{
+		unsigned int y = y0;
+
+		while (y < y1)
+		{
+			section* the_section = section_at(x, y, z);
+
+			block_id id = the_section->get_id(local_index(x, y, z));
+
+			if (opaque ? is_not_permeable_light(id) : id != id_air)
+			{
+				return y;
+			}
+
+			if (the_section->bits == 0)
+			{
+				y = (y & ~15u) + 16;
+			}
+			else
+			{
+				y++;
+			}
+		}
+
+		return y_res;
+	}
+
+	// Update the heightmap after the block_id of the voxel at the specified
+	// coordinates was set to id.
+
+	inline void update_heights(unsigned int x, unsigned int y, unsigned int z, block_id id)
+	{
+		// A column without a heightmap only needs one once it has a voxel
+		// that is not id_air.
+
+		if (id == id_air && !heights[column_slot(x, z)])
+		{
+			return;
+		}
+
+		column_heights* the_heights = writable_heights(x, z);
+
+		unsigned int i = (x & 15) | ((z & 15) << 4);
+
+		if (id != id_air)
+		{
+			if (y < the_heights->non_air[i])
+			{
+				the_heights->non_air[i] = y;
+			}
+		}
+		else if (y == the_heights->non_air[i])
+		{
+			the_heights->non_air[i] = find_top(x, z, y + 1, y_res, false);
+		}
+
+		if (is_not_permeable_light(id))
+		{
+			if (y < the_heights->opaque[i])
+			{
+				the_heights->opaque[i] = y;
+			}
+		}
+		else if (y == the_heights->opaque[i])
+		{
+			the_heights->opaque[i] = find_top(x, z, y + 1, y_res, true);
+		}
+	}
+
+	// Update the heightmap after the block_ids of the voxels from (x0, y0,
+	// z0) up to (but not including) (x1, y1, z1) were changed.
+
+	void update_heights_in_box(unsigned int x0, unsigned int y0, unsigned int z0, unsigned int x1, unsigned int y1, unsigned int z1)
+	{
+		for (unsigned int z = z0; z < z1; z++)
+		for (unsigned int x = x0; x < x1; x++)
+		{
+			column_heights* the_heights = writable_heights(x, z);
+
+			unsigned int i = (x & 15) | ((z & 15) << 4);
+
+			unsigned short* tops[2] = {&the_heights->non_air[i], &the_heights->opaque[i]};
+
+			for (int j = 0; j < 2; j++)
+			{
+				// Voxels above the box did not change, so a top above the box
+				// stays where it is.
+
+				if (*tops[j] < y0)
+				{
+					continue;
+				}
+
+				unsigned int y = find_top(x, z, y0, y1, j == 1);
+
+				if (y == y_res && *tops[j] < y1)
+				{
+					// The top was inside the box and is gone, so look below
+					// the box.
+
+					y = find_top(x, z, y1, y_res, j == 1);
+				}
+				else if (y == y_res)
+				{
+					y = *tops[j];
+				}
+
+				*tops[j] = y;
+			}
+		}
+	}
+
 	// Get the voxel at the specified coordinates.
 
 	inline voxel get(unsigned int x, unsigned int y, unsigned int z)
 	{
-		return voxels[x + x_res * (y + y_res * z)];
+		section* the_section = section_at(x, y, z);
+
+		unsigned int i = local_index(x, y, z);
+
+		return (the_section->get_id(i) & 0xff) | (the_section->get_artificial(i) << 8) | (the_section->get_natural(i) << 12);
 	}
 
 	// Get the voxel at the specified coordinates, if the coordinates are 
@@ -33,19 +384,19 @@ struct world
 
 	inline voxel get_safe(unsigned int x, unsigned int y, unsigned int z)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return 0;
 		}
 
-		return voxels[x + x_res * (y + y_res * z)];
+		return get(x, y, z);
 	}
 
 	// Get the block_id information of the voxel at the specified coordinates.
 
 	inline block_id get_id(unsigned int x, unsigned int y, unsigned int z)
 	{
-		return voxel_get_id(voxels[x + x_res * (y + y_res * z)]);
+		return section_at(x, y, z)->get_id(local_index(x, y, z));
 	}
 
 	// Get the block_id information of the voxel at the specified coordinates,
@@ -54,12 +405,12 @@ struct world
 
 	inline block_id get_id_safe(unsigned int x, unsigned int y, unsigned int z)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return id_null;
 		}
 
-		return voxel_get_id(voxels[x + x_res * (y + y_res * z)]);
+		return section_at(x, y, z)->get_id(local_index(x, y, z));
 	}
 
 	// Get the natural lighting information of the voxel at the specified 
@@ -67,7 +418,7 @@ struct world
 
 	inline unsigned char get_natural(unsigned int x, unsigned int y, unsigned int z)
 	{
-		return voxel_get_natural(voxels[x + x_res * (y + y_res * z)]);
+		return section_at(x, y, z)->get_natural(local_index(x, y, z));
 	}
 
 	// Get the natural lighting information of the voxel at the specified 
@@ -76,12 +427,12 @@ struct world
 
 	inline unsigned char get_natural_safe(unsigned int x, unsigned int y, unsigned int z)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return 0;
 		}
 
-		return voxel_get_natural(voxels[x + x_res * (y + y_res * z)]);
+		return section_at(x, y, z)->get_natural(local_index(x, y, z));
 	}
 
 	// Get the natural lighting information of the voxel at the second 
@@ -91,12 +442,12 @@ struct world
 
 	inline unsigned char get_natural_edge(unsigned int x1, unsigned int y1, unsigned int z1, unsigned int x2, unsigned int y2, unsigned int z2)
 	{
-		if (x2 < 0 || y2 < 0 || z2 < 0 || x2 > x_res - 1 || y2 > y_res - 1 || z2 > z_res - 1)
+		if (!in_bounds(x2, y2, z2))
 		{
-			return voxel_get_natural(voxels[x1 + x_res * (y1 + y_res * z1)]);
+			return section_at(x1, y1, z1)->get_natural(local_index(x1, y1, z1));
 		}
 
-		return voxel_get_natural(voxels[x2 + x_res * (y2 + y_res * z2)]);
+		return section_at(x2, y2, z2)->get_natural(local_index(x2, y2, z2));
 	}
 
 	// Get the artificial lighting information of the voxel at the specified 
@@ -104,7 +455,7 @@ struct world
 
 	inline unsigned char get_artificial(unsigned int x, unsigned int y, unsigned int z)
 	{
-		return voxel_get_artificial(voxels[x + x_res * (y + y_res * z)]);
+		return section_at(x, y, z)->get_artificial(local_index(x, y, z));
 	}
 
 	// Get the artificial lighting information of the voxel at the specified 
@@ -113,12 +464,12 @@ struct world
 
 	inline unsigned char get_artificial_safe(unsigned int x, unsigned int y, unsigned int z)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return 0;
 		}
 
-		return voxel_get_artificial(voxels[x + x_res * (y + y_res * z)]);
+		return section_at(x, y, z)->get_artificial(local_index(x, y, z));
 	}
 
 	// Get the artificial lighting information of the voxel at the second 
@@ -128,19 +479,39 @@ struct world
 
 	inline unsigned char get_artificial_edge(unsigned int x1, unsigned int y1, unsigned int z1, unsigned int x2, unsigned int y2, unsigned int z2)
 	{
-		if (x2 < 0 || y2 < 0 || z2 < 0 || x2 > x_res - 1 || y2 > y_res - 1 || z2 > z_res - 1)
+		if (!in_bounds(x2, y2, z2))
 		{
-			return voxel_get_artificial(voxels[x1 + x_res * (y1 + y_res * z1)]);
+			return section_at(x1, y1, z1)->get_artificial(local_index(x1, y1, z1));
 		}
 
-		return voxel_get_artificial(voxels[x2 + x_res * (y2 + y_res * z2)]);
+		return section_at(x2, y2, z2)->get_artificial(local_index(x2, y2, z2));
+	}
+
+	// Set the block_id, natural lighting and artificial lighting information
+	// of the voxel at the specified coordinates.
+
+	inline void set(unsigned int x, unsigned int y, unsigned int z, voxel value)
+	{
+		section* the_section = writable_section_at(x, y, z);
+
+		unsigned int i = local_index(x, y, z);
+
+		the_section->set_id(i, voxel_get_id(value));
+
+		the_section->set_natural(i, voxel_get_natural(value));
+
+		the_section->set_artificial(i, voxel_get_artificial(value));
+
+		update_heights(x, y, z, voxel_get_id(value));
 	}
 
 	// Set the block_id information of the voxel at the specified coordinates.
 
 	inline void set_id(unsigned int x, unsigned int y, unsigned int z, block_id id)
 	{
-		voxel_set_id(voxels[x + x_res * (y + y_res * z)], id);
+		writable_section_at(x, y, z)->set_id(local_index(x, y, z), id);
+
+		update_heights(x, y, z, id);
 	}
 
 	// Set the block_id information of the voxel at the specified coordinates,
@@ -151,7 +522,7 @@ struct world
 	{
 		if (get_id(x, y, z) == id_air)
 		{
-			voxel_set_id(voxels[x + x_res * (y + y_res * z)], id);
+			set_id(x, y, z, id);
 		}
 	}
 
@@ -163,7 +534,7 @@ struct world
 	{
 		if (get_id(x, y, z) != id_air)
 		{
-			voxel_set_id(voxels[x + x_res * (y + y_res * z)], id);
+			set_id(x, y, z, id);
 		}
 	}
 
@@ -172,12 +543,12 @@ struct world
 
 	inline void set_id_safe(unsigned int x, unsigned int y, unsigned int z, block_id id)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return;
 		}
 
-		voxel_set_id(voxels[x + x_res * (y + y_res * z)], id);
+		set_id(x, y, z, id);
 	}
 
 	// Set the block_id information of the voxel at the specified coordinates,
@@ -186,14 +557,14 @@ struct world
 
 	inline void set_id_safe_if_air(unsigned int x, unsigned int y, unsigned int z, block_id id)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return;
 		}
 
 		if (get_id(x, y, z) == id_air)
 		{
-			voxel_set_id(voxels[x + x_res * (y + y_res * z)], id);
+			set_id(x, y, z, id);
 		}
 	}
 
@@ -204,14 +575,14 @@ struct world
 
 	inline void set_id_safe_if_not_air(unsigned int x, unsigned int y, unsigned int z, block_id id)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return;
 		}
 
 		if (get_id(x, y, z) != id_air)
 		{
-			voxel_set_id(voxels[x + x_res * (y + y_res * z)], id);
+			set_id(x, y, z, id);
 		}
 	}
 
@@ -220,7 +591,7 @@ struct world
 
 	inline void set_natural(unsigned int x, unsigned int y, unsigned int z, unsigned char natural)
 	{
-		voxel_set_natural(voxels[x + x_res * (y + y_res * z)], natural);
+		writable_section_at(x, y, z)->set_natural(local_index(x, y, z), natural);
 	}
 
 	// Set the natural lighting information of the voxel at the specified 
@@ -228,12 +599,12 @@ struct world
 
 	inline void set_natural_safe(unsigned int x, unsigned int y, unsigned int z, unsigned char natural)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return;
 		}
 
-		voxel_set_natural(voxels[x + x_res * (y + y_res * z)], natural);
+		writable_section_at(x, y, z)->set_natural(local_index(x, y, z), natural);
 	}
 
 	// Set the artificial lighting information of the voxel at the specified 
@@ -241,7 +612,7 @@ struct world
 
 	inline void set_artificial(unsigned int x, unsigned int y, unsigned int z, unsigned char artificial)
 	{
-		voxel_set_artificial(voxels[x + x_res * (y + y_res * z)], artificial);
+		writable_section_at(x, y, z)->set_artificial(local_index(x, y, z), artificial);
 	}
 
 	// Set the artificial lighting information of the voxel at the specified 
@@ -249,16 +620,17 @@ struct world
 
 	inline void set_artificial_safe(unsigned int x, unsigned int y, unsigned int z, unsigned char artificial)
 	{
-		if (x < 0 || y < 0 || z < 0 || x > x_res - 1 || y > y_res - 1 || z > z_res - 1)
+		if (!in_bounds(x, y, z))
 		{
 			return;
 		}
 
-		voxel_set_artificial(voxels[x + x_res * (y + y_res * z)], artificial);
+		writable_section_at(x, y, z)->set_artificial(local_index(x, y, z), artificial);
 	}
 
 	// Check if this world may reference a voxel at the given coordinates. If
-	// so, return true. Else, return false.
+	// so, return true. Else, return false. Voxels in columns that are not 
+	// resident may not be referenced.
 
 	inline bool in_bounds(unsigned int x, unsigned int y, unsigned int z)
 	{
@@ -267,40 +639,382 @@ struct world
 			return false;
 		}
 
-		return true;
+		return column_resident(x, z);
 	}
 };
 
-// Allocate an empty world* of a given resolution. Each voxel in the world 
-// will be set to 0.
+// Reserve a zeroed block of memory. The operating system only gives the pages
+// of the block physical memory as they are touched. On POSIX systems, the
+// block is not committed either (MAP_NORESERVE), so a large block that is
+// mostly left alone costs almost nothing. On Windows, the whole block is
+// committed up front, so it counts against the commit limit (physical memory
+// plus the page file) even if it is never touched, and a block that is larger
+// than that limit can not be reserved. Returns nullptr if the block could not
+// be reserved.
 
-world* allocate_world(unsigned int x_res, unsigned int y_res, unsigned int z_res)
+void* reserve_memory(size_t bytes)
+{
+	#ifdef _WIN32
+
+	return VirtualAlloc(NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+	#else
+
+	void* block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	return block == MAP_FAILED ? nullptr : block;
+
+	#endif
+}
+
+// Give back a block of memory that was reserved with reserve_memory.
+
+void release_memory(void* block, size_t bytes)
+{
+	#ifdef _WIN32
+
+	VirtualFree(block, 0, MEM_RELEASE);
+
+	#else
+
+	munmap(block, bytes);
+
+	#endif
+}
+
+// Round a number up to the next power of two.
+
+inline unsigned int next_power_of_two(unsigned int n)
+{
+	unsigned int power = 1;
+
+	while (power < n)
+	{
+		power *= 2;
+	}
+
+	return power;
+}
+
+// Allocate a world* of a given resolution, with a window of window_x_res by
+// window_z_res column slots. Every slot is empty.
+
+world* allocate_world_window(unsigned int x_res, unsigned int y_res, unsigned int z_res, unsigned int window_x_res, unsigned int window_z_res)
 {
 	world* new_world = new world();
 
-	new_world->voxels = (voxel*)malloc(x_res * y_res * z_res * sizeof(voxel));
+	new_world->x_res = x_res;
+	new_world->y_res = y_res;
+	new_world->z_res = z_res;
+
+	// Round the section counts up, so that worlds whose dimensions are not 
+	// multiples of 16 still have room for every voxel.
+
+	new_world->chunk_x_res = (x_res + 15) / 16;
+	new_world->chunk_y_res = (y_res + 15) / 16;
+	new_world->chunk_z_res = (z_res + 15) / 16;
+
+	new_world->window_x_res = next_power_of_two(window_x_res);
+	new_world->window_z_res = next_power_of_two(window_z_res);
+
+	new_world->generator = generated_by_world;
+
+	// Column indices and slots are 32-bit, and heightmaps store Y coordinates
+	// in 16 bits.
+
+	if
+	(
+		(unsigned long long)new_world->chunk_x_res * new_world->chunk_z_res >= no_column ||
+
+		(unsigned long long)new_world->window_x_res * new_world->window_z_res >= no_column ||
+
+		y_res > USHRT_MAX
+	)
+	{
+		std::cout << "Could not allocate a world of " << x_res << "x" << y_res << "x" << z_res << " voxels, the world is too large." << std::endl;
+
+		exit(17);
+	}
+
+	size_t slot_count = size_t(new_world->window_x_res) * new_world->window_z_res;
+
+	size_t section_count = slot_count * new_world->chunk_y_res;
 
-	if (!new_world->voxels)
+	new_world->sections = (section**)reserve_memory(section_count * sizeof(section*));
+
+	new_world->columns = (unsigned int*)malloc(slot_count * sizeof(unsigned int));
+
+	new_world->columns_modified = (bool*)calloc(slot_count, sizeof(bool));
+
+	new_world->heights = (column_heights**)reserve_memory(slot_count * sizeof(column_heights*));
+
+	if (!new_world->sections || !new_world->columns || !new_world->columns_modified || !new_world->heights)
 	{
 		std::cout << "Could not allocate enough memory for a new world." << std::endl;
 
 		exit(13);
 	}
 
-	memset(new_world->voxels, 0, x_res * y_res * z_res * sizeof(voxel));
+	for (size_t i = 0; i < slot_count; i++)
+	{
+		new_world->columns[i] = no_column;
+	}
+
+	return new_world;
+}
 
-	new_world->x_res = x_res;
-	new_world->y_res = y_res;
-	new_world->z_res = z_res;
+// Make the column that holds the voxel at the specified X and Z coordinates
+// resident. Each voxel in the column will be set to 0. The column's slot must
+// be empty.
+//
+// Every section of the column shares one uniform id_air section, which is
+// copied the first time each section is changed. The column has no 
+// heightmap until it has a voxel that is not id_air.
+
+void allocate_column(world* the_world, unsigned int x, unsigned int z)
+{
+	unsigned int slot = the_world->column_slot(x, z);
+
+	the_world->columns[slot] = (x >> 4) + the_world->chunk_x_res * (z >> 4);
+
+	the_world->columns_modified[slot] = false;
+
+	section* air_section = allocate_section(id_air);
+
+	air_section->references.store(the_world->chunk_y_res, std::memory_order_relaxed);
+
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	{
+		the_world->sections[the_world->section_index(x, y, z)] = air_section;
+	}
+}
+
+// Deallocate the sections of the column in the specified slot, and mark the
+// slot as empty.
+
+void deallocate_column_slot(world* the_world, unsigned int slot)
+{
+	if (the_world->columns[slot] == no_column)
+	{
+		return;
+	}
+
+	for (unsigned int cy = 0; cy < the_world->chunk_y_res; cy++)
+	{
+		section*& the_section = the_world->sections[the_world->slot_section_index(slot, cy)];
+
+		release_section(the_section);
+
+		the_section = nullptr;
+	}
+
+	// Snapshots have no heightmaps.
+
+	if (the_world->heights)
+	{
+		free(the_world->heights[slot]);
+
+		the_world->heights[slot] = nullptr;
+	}
+
+	the_world->columns[slot] = no_column;
+}
+
+// Set every voxel of the resident column that holds the voxel at the
+// specified X and Z coordinates back to id_air, as if the column was just
+// made resident. It's modified flag is cleared.
+
+void clear_column(world* the_world, unsigned int x, unsigned int z)
+{
+	deallocate_column_slot(the_world, the_world->column_slot(x, z));
+
+	allocate_column(the_world, x, z);
+}
+
+// Move the column that holds the voxel at the specified X and Z coordinates
+// from one world* to another world* of the same size, without copying it's
+// sections. The column must be resident in from, and it's slot in to must be
+// empty. It is not marked as modified in to.
+
+void move_column(world* from, world* to, unsigned int x, unsigned int z)
+{
+	unsigned int from_slot = from->column_slot(x, z);
+
+	unsigned int to_slot = to->column_slot(x, z);
+
+	for (unsigned int cy = 0; cy < to->chunk_y_res; cy++)
+	{
+		to->sections[to->slot_section_index(to_slot, cy)] = from->sections[from->slot_section_index(from_slot, cy)];
+
+		from->sections[from->slot_section_index(from_slot, cy)] = nullptr;
+	}
+
+	to->heights[to_slot] = from->heights[from_slot];
+
+	from->heights[from_slot] = nullptr;
+
+	to->columns[to_slot] = from->columns[from_slot];
+
+	from->columns[from_slot] = no_column;
+
+	to->columns_modified[to_slot] = false;
+}
+
+// Allocate an empty world* of a given resolution. Each voxel in the world 
+// will be set to 0.
+
+world* allocate_world(unsigned int x_res, unsigned int y_res, unsigned int z_res)
+{
+	// Use a window that holds every column, and make every column resident.
+
+	world* new_world = allocate_world_window(x_res, y_res, z_res, (x_res + 15) / 16, (z_res + 15) / 16);
+
+	for (unsigned int x = 0; x < x_res; x += 16)
+	for (unsigned int z = 0; z < z_res; z += 16)
+	{
+		allocate_column(new_world, x, z);
+	}
 
 	return new_world;
 }
 
-// Deallocate a world*'s voxels, and then delete the world*.
+// Deallocate a world*'s sections, and then delete the world*.
 
 void deallocate_world(world* to_be_annihilated)
 {
-	free(to_be_annihilated->voxels);
+	size_t slot_count = size_t(to_be_annihilated->window_x_res) * to_be_annihilated->window_z_res;
+
+	for (size_t i = 0; i < slot_count; i++)
+	{
+		deallocate_column_slot(to_be_annihilated, i);
+	}
+
+	release_memory(to_be_annihilated->sections, slot_count * to_be_annihilated->chunk_y_res * sizeof(section*));
+
+	free(to_be_annihilated->columns);
+
+	free(to_be_annihilated->columns_modified);
+
+	if (to_be_annihilated->heights)
+	{
+		release_memory(to_be_annihilated->heights, slot_count * sizeof(column_heights*));
+	}
 
 	delete to_be_annihilated;
-}
\ No newline at end of file
+}
+
+// Compact every resident section of a world*. This should be called after 
+// large changes, such as generating or loading a world, to give back the 
+// memory used by palette entries and lighting arrays that are no longer 
+// needed. Sections that are shared with a snapshot are left alone.
+
+void compact_world(world* the_world)
+{
+	size_t section_count = size_t(the_world->window_x_res) * the_world->chunk_y_res * the_world->window_z_res;
+
+	for (size_t i = 0; i < section_count; i++)
+	{
+		if (the_world->sections[i] && the_world->sections[i]->references == 1)
+		{
+			compact_section(the_world->sections[i]);
+		}
+	}
+}
+
+// Compact every section of the column that holds the voxel at the specified
+// X and Z coordinates. Sections that are shared with a snapshot are left 
+// alone.
+
+void compact_column(world* the_world, unsigned int x, unsigned int z)
+{
+	for (unsigned int y = 0; y < the_world->y_res; y += 16)
+	{
+		section* the_section = the_world->section_at(x, y, z);
+
+		if (the_section->references == 1)
+		{
+			compact_section(the_section);
+		}
+	}
+}
+
+// Take a snapshot of some columns of a world*. The snapshot is a world* that
+// shares every section of the specified columns (given as cx + chunk_x_res *
+// cz) with the world, so taking it only copies pointers, and only the columns
+// that are read from it need to be shared. Columns that are not resident in
+// the world are left out. While the world keeps changing, the snapshot keeps
+// the voxels that the world had when the snapshot was taken, because the
+// world copies each shared section before it changes it.
+//
+// Snapshots must be taken on the thread that changes the world, but may then
+// be read (and deallocated with deallocate_world) from any other thread. A
+// snapshot must never be changed. It has no heightmaps, because the world
+// changes those in place, so top_non_air and top_opaque must not be called on
+// it.
+
+world* snapshot_world(world* the_world, const std::vector<unsigned int>& snapshot_columns)
+{
+	world* snapshot = allocate_world_window(the_world->x_res, the_world->y_res, the_world->z_res, the_world->window_x_res, the_world->window_z_res);
+
+	size_t slot_count = size_t(the_world->window_x_res) * the_world->window_z_res;
+
+	release_memory(snapshot->heights, slot_count * sizeof(column_heights*));
+
+	snapshot->heights = nullptr;
+
+	snapshot->generator = the_world->generator;
+
+	for (unsigned int column: snapshot_columns)
+	{
+		unsigned int x = (column % the_world->chunk_x_res) * 16;
+		unsigned int z = (column / the_world->chunk_x_res) * 16;
+
+		unsigned int slot = the_world->column_slot(x, z);
+
+		// Columns that are listed more than once are only shared once.
+
+		if (the_world->columns[slot] != column || snapshot->columns[slot] == column)
+		{
+			continue;
+		}
+
+		snapshot->columns[slot] = column;
+
+		snapshot->columns_modified[slot] = the_world->columns_modified[slot];
+
+		for (unsigned int cy = 0; cy < the_world->chunk_y_res; cy++)
+		{
+			size_t i = the_world->slot_section_index(slot, cy);
+
+			the_world->sections[i]->references.fetch_add(1, std::memory_order_relaxed);
+
+			snapshot->sections[i] = the_world->sections[i];
+		}
+	}
+
+	return snapshot;
+}
+
+// Get the amount of bytes of memory used by the voxels of a world*.
+
+unsigned long long world_memory_usage(world* the_world)
+{
+	size_t section_count = size_t(the_world->window_x_res) * the_world->chunk_y_res * the_world->window_z_res;
+
+	unsigned long long bytes = section_count * sizeof(section*);
+
+	for (size_t i = 0; i < section_count; i++)
+	{
+		// A section that is shared by neighboring sections of a column (like
+		// the id_air section of a new column) is only counted once.
+
+		bool shared_with_previous = (i / the_world->window_x_res) % the_world->chunk_y_res != 0 && the_world->sections[i] == the_world->sections[i - the_world->window_x_res];
+
+		if (the_world->sections[i] && !shared_with_previous)
+		{
+			bytes += section_memory_usage(the_world->sections[i]);
+		}
+	}
+
+	return bytes;
+}
@@ -38,8 +38,11 @@ void print_usage(char** argv)
 
 	std::cout << "        Play singleplayer. If a world save exists at <path-to-level>, the       " << std::endl;
 	std::cout << "        world is loaded and the given dimensions (if any) are ignored. If not,  " << std::endl;
-	std::cout << "        a new world is generated with the given dimensions and saved to         " << std::endl;
-	std::cout << "        <path-to-level>.                                                        " << std::endl;
+	std::cout << "        a new world is created and saved to <path-to-level>. Without any        " << std::endl;
+	std::cout << "        dimensions, the new world is horizontally unbounded, and is generated   " << std::endl;
+	std::cout << "        and saved one column at a time around the player. With dimensions, the  " << std::endl;
+	std::cout << "        new world is generated all at once with the given dimensions.           " << std::endl;
+	std::cout << "        The world is autosaved every 5 minutes, and when F5 is pressed.         " << std::endl;
 
 	std::cout << std::endl;
 
@@ -48,7 +51,8 @@ void print_usage(char** argv)
 	std::cout << std::endl;
 
 	std::cout << "        Play quickplay. A new world is generated with the given dimensions (if  " << std::endl;
-	std::cout << "        any) and is stored in memory for the duration of the gameplay.          " << std::endl;
+	std::cout << "        any, else it is horizontally unbounded) and is stored in memory for the " << std::endl;
+	std::cout << "        duration of the gameplay.                                               " << std::endl;
 
 	exit(16);
 }
@@ -57,6 +61,11 @@ void print_usage(char** argv)
 
 int main(int argc, char** argv)
 {
+	// Record the time at which the game started, to report the time until
+	// the first frame.
+
+	auto startup_time = std::chrono::high_resolution_clock::now();
+
 	// Print usage information if the command line was not used correctly. 
 	// Otherwise, parse the gamemode.
 
@@ -207,7 +216,7 @@ int main(int argc, char** argv)
     gui2_init();
     gui3_init();
 
-    // Load the block face_info* array.
+    // Load the block face_info array.
 
     load_block_face_info_array();
 
@@ -224,6 +233,20 @@ int main(int argc, char** argv)
 
     world* the_world = nullptr;
 
+    // Streaming worlds are generated using a seed, and have no fixed 
+    // horizontal size.
+
+    bool streaming = false;
+
+    unsigned int seed = time(NULL);
+
+    unsigned int streaming_y_res = 256;
+
+    // Worlds with a fixed size that are loaded from a level directory are
+    // loaded in the background, closest to the player first.
+
+    level_load* the_load = nullptr;
+
     // Define variables to hold the looking direction of the player.
 
     float rot_x_deg = 0.0f;
@@ -235,6 +258,11 @@ int main(int argc, char** argv)
     float player_y = 0.0f;
     float player_z = 0.0f;
 
+    // New worlds spawn the player on the ground, once the columns around the
+    // player are resident.
+
+    bool spawn_on_ground = false;
+
     float player_vx = 0.0f;
     float player_vy = 0.0f;
     float player_vz = 0.0f; 
@@ -286,17 +314,15 @@ int main(int argc, char** argv)
 	{
 		// Singleplayer mode.
 
-		unsigned int x_res;
-		unsigned int y_res;
-		unsigned int z_res;
+		unsigned int x_res = 0;
+		unsigned int y_res = 0;
+		unsigned int z_res = 0;
 
 		if (argc == 3)
 		{
-			// Singleplayer mode with a default world.
+			// Singleplayer mode with a streaming world.
 
-			x_res = 256;
-			y_res = 256;
-			z_res = 256;
+			streaming = true;
 		}
 		else if (argc == 6)
 		{
@@ -326,11 +352,51 @@ int main(int argc, char** argv)
 
 		path_to_level = std::string(argv[2]);
 
-		// Check if a world at path_to_level exists.
+		// Finish replacing a world file with a level directory, if the game
+		// crashed while it was replaced.
+
+		recover_level(path_to_level);
+
+		// Check if a world at path_to_level exists. Worlds are directories
+		// that contain a level.dat file and region files, except for worlds
+		// that were saved before region files were used, which are single
+		// files.
+
+		unsigned int level_generator;
+
+		unsigned int level_x_res;
+		unsigned int level_y_res;
+		unsigned int level_z_res;
+
+		if (load_level_info(path_to_level, seed, level_generator, level_x_res, level_y_res, level_z_res, player_x, player_y, player_z))
+		{
+			if (level_x_res == 0)
+			{
+				// The streaming world exists, so it's columns will be loaded
+				// around the player.
+
+				streaming = true;
+
+				streaming_y_res = level_y_res;
 
-		if (std::ifstream(path_to_level).good())
+				the_world = allocate_streaming_world(streaming_y_res);
+			}
+			else
+			{
+				streaming = false;
+
+				// The world exists, so start loading it. The columns around the
+				// player are waited for once the accessor* exists.
+
+				the_load = start_level_load(the_world, path_to_level, seed, level_generator, level_x_res, level_y_res, level_z_res, player_x, player_z);
+			}
+		}
+		else if (std::ifstream(path_to_level).good())
     	{
-    		// The world exists, so load it.
+    		streaming = false;
+
+    		// The world exists as a single file, so load it. It is saved as a
+    		// level directory right away, so that it's edits can be journaled.
 
     		load_world_from_file
 	    	(
@@ -342,6 +408,40 @@ int main(int argc, char** argv)
 
 	    		path_to_level
 	    	);
+
+	    	save_world_to_level
+	    	(
+	    		the_world,
+
+	    		seed,
+
+	    		player_x,
+	    		player_y,
+	    		player_z,
+
+	    		path_to_level
+	    	);
+    	}
+    	else if (streaming)
+    	{
+    		// The world does not exist, so create a new streaming world. It's
+    		// columns will be generated around the player.
+
+    		the_world = allocate_streaming_world(streaming_y_res);
+
+	    	// Spawn the player at the center.
+
+	    	player_x = float(the_world->x_res) / 2.0f;
+
+	    	player_y = 0.0f;
+
+	    	player_z = float(the_world->z_res) / 2.0f;
+
+	    	spawn_on_ground = true;
+
+	    	// Create the level directory at path_to_level.
+
+	    	save_level_info(path_to_level, seed, the_world->generator, 0, streaming_y_res, 0, player_x, player_y, player_z);
     	}
     	else
     	{
@@ -350,24 +450,28 @@ int main(int argc, char** argv)
 
 			the_world = allocate_world(x_res, y_res, z_res);
 
-			// Generate a new world using the current time as the seed.
+			// Generate a new world using the current time as the seed. It is
+			// generated one column at a time, so that only the seed and the
+			// columns that are modified have to be saved.
 
-	    	generate_world(the_world, time(NULL));
+	    	generate_world_columns(the_world, seed);
 
-	    	// Spawn the player at the top center.
+	    	// Spawn the player on the ground at the center.
 
 	    	player_x = float(the_world->x_res) / 2.0f;
 
-	    	player_y = 0.0f;
-
 	    	player_z = float(the_world->z_res) / 2.0f;
 
+	    	player_y = spawn_y(the_world, player_x, player_z);
+
 	    	// Save the world to path_to_level.
 
-	    	save_world_to_file
+	    	save_world_to_level
 			(
 				the_world, 
 
+				seed,
+
 				player_x,
 				player_y,
 				player_z,
@@ -386,11 +490,9 @@ int main(int argc, char** argv)
 
 		if (argc == 2)
 		{
-			// Quickplay mode with a default world.
+			// Quickplay mode with a streaming world.
 
-			x_res = 128;
-			y_res = 128;
-			z_res = 128;
+			streaming = true;
 		}
 		else if (argc == 5)
 		{
@@ -416,32 +518,135 @@ int main(int argc, char** argv)
 			print_usage(argv);
 		}
 
-		// Allocate an empty world of the given size.
+		if (streaming)
+		{
+			// Allocate an empty streaming world. It's columns will be 
+			// generated around the player.
 
-		the_world = allocate_world(x_res, y_res, z_res);
+			the_world = allocate_streaming_world(streaming_y_res);
+		}
+		else
+		{
+			// Allocate an empty world of the given size.
 
-		// Generate a new world using the current time as the seed.
+			the_world = allocate_world(x_res, y_res, z_res);
 
-    	generate_world(the_world, time(NULL));
+			// Generate a new world using the current time as the seed.
+
+	    	generate_world(the_world, seed);
+		}
 
-    	// Spawn the player at the top center.
+    	// Spawn the player on the ground at the center.
 
     	player_x = float(the_world->x_res) / 2.0f;
 
     	player_y = 0.0f;
 
     	player_z = float(the_world->z_res) / 2.0f;
+
+    	spawn_on_ground = true;
 	}
 
     // Allocate a new accessor* from the_world.
 
     accessor* the_accessor = allocate_accessor(the_world);
 
+    // Allocate a mesher* to mesh the chunks that are modified while the game
+    // runs.
+
+    mesher* the_mesher = allocate_mesher();
+
+    // Allocate a stream* for streaming worlds, and make the columns around the
+    // player resident. Quickplay streaming worlds are never saved to disk.
+
+    stream* the_stream = nullptr;
+
+    if (streaming)
+    {
+    	the_stream = allocate_stream(the_accessor, seed, gamemode == 1 ? path_to_level : std::string());
+
+    	update_stream(the_stream, player_x, player_z, 1, 0);
+    }
+
+    // Read the journal of a singleplayer world once. It's edits are replayed
+    // below.
+
+    std::vector<journal_entry> journal_entries;
+
+    if (gamemode == 1)
+    {
+    	journal_entries = read_journal(path_to_level);
+    }
+
+    // Move the columns around the player of a world that is being loaded into
+    // it, so that the first frame shows them. The edits in a journal may be
+    // anywhere in the world, so every column is waited for if there are any.
+
+    int initial_load_radius = 4;
+
+    if (the_load)
+    {
+    	size_t initial_columns = level_load_columns_within(the_load, player_x, player_z, initial_load_radius);
+
+    	if (!journal_entries.empty())
+    	{
+    		initial_columns = the_load->order.size();
+    	}
+
+    	wait_for_level_load(the_load, the_accessor, initial_columns);
+    }
+
+    if (spawn_on_ground)
+    {
+    	player_y = spawn_y(the_world, player_x, player_z);
+    }
+
+    // Every edit to a singleplayer world is appended to the journal of it's
+    // level directory. The edits that are in the journal were not saved
+    // before the game last exited, so they are replayed first.
+
+    journal* the_journal = nullptr;
+
+    if (gamemode == 1)
+    {
+    	size_t replayed_edits = replay_journal(the_accessor, the_stream, journal_entries);
+
+    	if (replayed_edits != 0)
+    	{
+    		std::cout << "Replayed " << replayed_edits << " edits from the journal of " << path_to_level << std::endl;
+    	}
+
+    	the_journal = allocate_journal(path_to_level);
+
+    	the_accessor->the_journal = the_journal;
+    }
+
+    // Define the time between two autosaves of a singleplayer world (0
+    // disables autosaving), and the most columns of a streaming world that an
+    // autosave may save per frame. Pressing F5 starts an autosave right away.
+
+    unsigned int autosave_interval_in_s = 300;
+
+    unsigned int autosave_columns_per_frame = 4;
+
+    autosave* the_autosave = nullptr;
+
+    if (gamemode == 1)
+    {
+    	the_autosave = allocate_autosave(the_world, the_stream, the_journal, seed, path_to_level, autosave_interval_in_s * 1000, autosave_columns_per_frame);
+    }
+
+    // Define the time (in milliseconds) that a stream may spend loading and
+    // meshing columns per frame.
+
+    unsigned int stream_budget_in_ms = 8;
+
     // Define the reach distance.
 
     float reach_distance = 8.0f;
 
-    // Define the maximum chunk updates per frame.
+    // Define the maximum chunk updates (uploads of chunks that the mesher
+    // meshed) per frame.
 
     unsigned int max_chunk_updates = 16;
 
@@ -593,6 +798,10 @@ int main(int argc, char** argv)
 				}
 				else if (key >= SDLK_1 && key <= SDLK_9) {
 					player_selection = key - SDLK_1;
+				} else if (key == SDLK_F5) {
+					if (the_autosave) {
+						request_autosave(the_autosave);
+					}
 				} else if (key == SDLK_e) {
 					if (!is_options_open) {
 						is_inventory_open = !is_inventory_open;
@@ -1090,7 +1299,7 @@ int main(int argc, char** argv)
 
 							is_crop(plant_above))
 						{
-							the_world->set_id_safe(px, py - 1, pz, id_air);
+							the_accessor->set_id_safe(px, py - 1, pz, id_air);
 						}
 
 						// Reeds cannot exist if there is nothing below them.
@@ -1107,7 +1316,7 @@ int main(int argc, char** argv)
 							}
 							else
 							{
-								the_world->set_id_safe(px, py - reeds_offset, pz, id_air);
+								the_accessor->set_id_safe(px, py - reeds_offset, pz, id_air);
 							}
 
 							reeds_offset++;
@@ -1450,42 +1659,38 @@ int main(int argc, char** argv)
 			the_world->burning_fires.push_back(the_burning_fire);
 		}
 
-		// Update all modified chunks.
-
-		unsigned int chunk_updates = 0;
+		// Page the columns of a streaming world in and out around the player.
 
-		for (int i = 0; i < the_accessor->chunk_count; i++)
+		if (the_stream)
 		{
-			chunk*& the_chunk = the_accessor->the_chunks[i];
-
-			if (the_chunk->modified)
-			{
-				chunk* new_chunk = allocate_chunk
-				(
-					the_world,
+			update_stream(the_stream, player_x, player_z, option_render_distance, stream_budget_in_ms);
+		}
 
-					the_chunk->x,
-					the_chunk->y,
-					the_chunk->z,
+		// Move the columns of a world that is being loaded into it, and report
+		// the time it took once every column is loaded.
 
-					the_chunk->x_res,
-					the_chunk->y_res,
-					the_chunk->z_res
-				);
+		if (the_load && (update_level_load(the_load, the_accessor, stream_budget_in_ms) || level_load_done(the_load)))
+		{
+			std::cout << "Loaded " << the_load->order.size() << " columns in " << the_load->total_time_in_ms << " ms" << std::endl;
 
-				deallocate_chunk(the_chunk);
+			deallocate_level_load(the_load);
 
-				the_chunk = new_chunk;
+			the_load = nullptr;
+		}
 
-				chunk_updates++;
-			}
+		// Continue (or start) an autosave, and report it's cost once it is
+		// done.
 
-			if (chunk_updates == max_chunk_updates)
-			{
-				break;
-			}
+		if (the_autosave && update_autosave(the_autosave, player_x, player_y, player_z))
+		{
+			std::cout << "Autosaved " << the_autosave->columns_saved << " columns in " << the_autosave->total_time_in_ms << " ms, using " << the_autosave->frame_time_in_ms << " ms of " << the_autosave->frames << " frames (at most " << the_autosave->max_frame_time_in_ms << " ms per frame)" << std::endl;
 		}
 
+		// Upload the chunks that the mesher meshed, and start meshing all
+		// modified chunks.
+
+		update_mesher(the_mesher, the_accessor, max_chunk_updates);
+
 		// Clear the OpenGL context to the default sky color.
 
 		glClearColor
@@ -1586,16 +1791,26 @@ int main(int argc, char** argv)
 
 		glUniform1f(glGetUniformLocation(block_shader_program, "time_in_seconds"), SDL_GetTicks() / 1000.0f);
 
+		// Find the location of the chunk_offset uniform, which is set for
+		// each chunk.
+
+		GLint chunk_offset_location = glGetUniformLocation(block_shader_program, "chunk_offset");
+
 		// Bind the block_texture_array to the current state.
 
 		glBindTexture(GL_TEXTURE_2D_ARRAY, block_texture_array);
 
 		// Render all of the chunks' vertex arrays in the_accessor.
 
-		for (int i = 0; i < the_accessor->chunk_count; i++)
+		for (size_t i = 0; i < the_accessor->chunk_count; i++)
 		{
 			chunk* the_chunk = the_accessor->the_chunks[i];
 
+			if (!the_chunk)
+			{
+				continue;
+			}
+
 			float ccx = the_chunk->x + (the_chunk->x_res / 2);
 			float ccy = the_chunk->y + (the_chunk->y_res / 2);
 			float ccz = the_chunk->z + (the_chunk->z_res / 2);
@@ -1606,7 +1821,7 @@ int main(int argc, char** argv)
 
 			if (dx * dx + dy * dy + dz * dz < view_distance * view_distance)
 			{
-				render_chunk(the_chunk);
+				render_chunk(the_chunk, chunk_offset_location);
 			}
 		}
 
@@ -1622,10 +1837,15 @@ int main(int argc, char** argv)
 
 		// Render all of the chunks' water vertex arrays in the_accessor.
 
-		for (int i = 0; i < the_accessor->chunk_count; i++)
+		for (size_t i = 0; i < the_accessor->chunk_count; i++)
 		{
 			chunk* the_chunk = the_accessor->the_chunks[i];
 
+			if (!the_chunk)
+			{
+				continue;
+			}
+
 			float ccx = the_chunk->x + (the_chunk->x_res / 2);
 			float ccy = the_chunk->y + (the_chunk->y_res / 2);
 			float ccz = the_chunk->z + (the_chunk->z_res / 2);
@@ -1636,7 +1856,7 @@ int main(int argc, char** argv)
 
 			if (dx * dx + dy * dy + dz * dz < view_distance * view_distance)
 			{
-				render_chunk_water(the_chunk);
+				render_chunk_water(the_chunk, chunk_offset_location);
 			}
 		}
 
@@ -2018,6 +2238,13 @@ int main(int argc, char** argv)
 
 		SDL_GL_SwapWindow(sdl_window);
 
+		// Report the time from startup to the first frame.
+
+		if (sdl_iteration == 0)
+		{
+			std::cout << "Showed the first frame " << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startup_time).count() << " ms after startup" << std::endl;
+		}
+
 		// Decrement the block timer, if the block timer is not equal to 0.
 
 		if (block_timer != 0)
@@ -2042,21 +2269,59 @@ int main(int argc, char** argv)
 
 		sdl_iteration++;
 
+		if (the_journal)
+		{
+			the_journal->tick = sdl_iteration;
+		}
+
 		if (sdl_iteration % 60 == 0)
 		{
 			std::cout << "Running at " << 1000.0f / frame_elapsed_time << " Hz" << std::endl;
+
+			if (the_autosave && the_autosave->running)
+			{
+				std::cout << "Autosaving, " << int(autosave_progress(the_autosave) * 100.0f) << "% done" << std::endl;
+			}
+
+			if (the_load)
+			{
+				std::cout << "Loading the world, " << int(level_load_progress(the_load) * 100.0f) << "% done" << std::endl;
+			}
 		}
     }
 
+    // Stop loading the world. The columns that were not loaded yet were not
+    // modified, so they do not need to be saved.
+
+    if (the_load)
+    {
+    	deallocate_level_load(the_load);
+    }
+
+    // Wait for a running autosave to finish before the world is saved again.
+
+    if (the_autosave)
+    {
+    	deallocate_autosave(the_autosave);
+    }
+
     // Save the world to the specified save file, if the gamemode is 1 
     // (singleplayer).
 
-    if (gamemode == 1)
+    bool saved = false;
+
+    if (gamemode == 1 && the_stream)
     {
-	    save_world_to_file
+    	saved = save_stream(the_stream, player_x, player_y, player_z);
+    }
+    else if (gamemode == 1)
+    {
+	    saved = save_modified_columns_to_level
 		(
 			the_world, 
 
+			seed,
+
 			player_x,
 			player_y,
 			player_z,
@@ -2065,14 +2330,35 @@ int main(int argc, char** argv)
 		);
     }
 
+    // Every edit in the journal was saved, unless the save failed.
+
+    if (the_journal)
+    {
+    	if (saved)
+    	{
+    		truncate_journal(the_journal);
+    	}
+
+    	deallocate_journal(the_journal);
+    }
+
     // Destroy all Minceraft related objects.
 
+    deallocate_mesher(the_mesher);
+
+    if (the_stream)
+    {
+    	deallocate_stream(the_stream);
+    }
+
     deallocate_world(the_world);
 
     deallocate_accessor(the_accessor);
 
     // Destroy all OpenGL related objects.
 
+    deallocate_quad_indices();
+
     glDeleteTextures(1, &block_texture_array);
 
     glDeleteProgram(block_shader_program);
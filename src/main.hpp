@@ -44,28 +44,46 @@
 
 #include <voxel.hpp>
 
+#include <section.hpp>
+
 #include <face.hpp>
 
 #include <plant.hpp>
 
 #include <fire.hpp>
 
+#include <parallel.hpp>
+
 #include <world.hpp>
 
+#include <box.hpp>
+
 #include <mesh.hpp>
 
 #include <chunk.hpp>
 
 #include <skylight.hpp>
 
+#include <journal.hpp>
+
 #include <accessor.hpp>
 
+#include <mesher.hpp>
+
 #include <hitbox.hpp>
 
 #include <generator.hpp>
 
+#include <compress.hpp>
+
 #include <file.hpp>
 
+#include <stream.hpp>
+
+#include <save.hpp>
+
+#include <load.hpp>
+
 #include <gui.hpp>
 #include <gui2.hpp>
 #include <gui3.hpp>